@@ -2,7 +2,7 @@ rm ./*/*.db
 for D in *; do
     if [ -d "${D}" ]; then
 		cd ${D}
-		ls | cat > ${D}.db
+		ls | grep -v '\.hxc$' > ${D}.db
 		cd ..
 	fi
 done
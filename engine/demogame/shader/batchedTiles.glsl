@@ -5,10 +5,13 @@
 layout(location = 0) in vec2 pos;
 layout(location = 1) in vec2 inUv;
 out vec2 UV;
+//xy: screen position of the origin, zw: size of a unit (a tile for the static map meshes)
+uniform vec4 tileTransform;
 
 void main()
 {
-	gl_Position = vec4(pos.x*2-1, pos.y*2-1, 0.0f, 1.0f);
+	vec2 screen = tileTransform.xy + pos*tileTransform.zw;
+	gl_Position = vec4(screen.x*2-1, screen.y*2-1, 0.0f, 1.0f);
 	UV = vec2(inUv.x, inUv.y);
 }
 
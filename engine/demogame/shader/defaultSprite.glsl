@@ -3,12 +3,15 @@
 
 #ifdef CONTROL_COMPILE_VERTEX
 layout(location = 0) in vec3 vertexPosition_screenspace;
-uniform vec4 position;
-uniform vec4 offset;
+//one sprite per instance (see SpriteBatch): x, y, width, height on the screen and the region on the texture
+layout(location = 1) in vec4 instancePosition;
+layout(location = 2) in vec4 instanceOffset;
 out vec2 UV;
 
 void main()
 {
+	vec4 position = instancePosition;
+	vec4 offset = instanceOffset;
 	float xscale = (vertexPosition_screenspace.x + 1) / 2;
 	float yscale = (vertexPosition_screenspace.y + 1) / 2;
 	vec2 inpos = vec2(position.x * 2 - 1 + xscale * 2 * position[2], (1-position.y-position[3]) * 2 - 1 + yscale * 2 * position[3]);
@@ -0,0 +1,31 @@
+#define CONFIG_HAS_VERTEX
+#define CONFIG_HAS_FRAGMENT
+
+#ifdef CONTROL_COMPILE_VERTEX
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec2 inUv;
+uniform vec4 position;
+out vec2 UV;
+
+void main()
+{
+	//pos is in pixels of the font from the top left of the text, position has the top left on the screen and the size of a pixel
+	vec2 screen = vec2(position.x + pos.x * position[2], 1 - position.y - pos.y * position[3]);
+	gl_Position = vec4(screen.x * 2 - 1, screen.y * 2 - 1, 0.0f, 1.0f);
+	UV = inUv;
+}
+
+#endif
+
+#ifdef CONTROL_COMPILE_FRAGMENT
+in vec2 UV;
+out vec4 color;
+uniform sampler2D textureSampler;
+uniform vec4 textColor;
+
+void main()
+{
+	color = texture2D(textureSampler, UV).rgba * textColor;
+}
+
+#endif
\ No newline at end of file
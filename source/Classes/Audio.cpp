@@ -13,26 +13,63 @@ namespace Dragon2D
 	}
 
 	Music::Music(std::string loadname)
-		: name(loadname)
+		: name("")
 	{
 		Load(loadname);
 	}
 	
+	Music::Music(const Music& other)
+		: BaseClass(other), name(other.name)
+	{
+		if (name != "") {
+			Env::GetResourceManager().RequestAudioResource(name);
+		}
+	}
+
+	Music& Music::operator=(const Music& other)
+	{
+		//request before free, the resource stays if both are the same
+		if (other.name != "") {
+			Env::GetResourceManager().RequestAudioResource(other.name);
+		}
+		if (name != "") {
+			Env::GetResourceManager().FreeAudioResource(name);
+		}
+		BaseClass::operator=(other);
+		name = other.name;
+		return *this;
+	}
+
+	Music::~Music()
+	{
+		if (name != "") {
+			Env::GetResourceManager().FreeAudioResource(name);
+		}
+	}
+
 	void Music::Load(std::string loadname)
 	{
+		if (name != "") {
+			Env::GetResourceManager().FreeAudioResource(name);
+		}
 		name = loadname;
 		Env::GetResourceManager().RequestAudioResource(name);		
 	}	
 	
 	void Music::Play(int fadetime, int loops)
 	{
-		if(curChannel!=-1) {
+		PlayOnChannel(-1, fadetime, loops);
+	}	
+
+	void Music::PlayOnChannel(int channel, int fadetime, int loops)
+	{
+		if (curChannel != -1 && curChannel != channel) {
 			Mix_FadeOutChannel(curChannel, fadetime);
 		}
-		
+
 		AudioResource &res = Env::GetResourceManager().GetAudioResource(name);
-		curChannel = Mix_FadeInChannel(-1,res.GetChunk(),loops,fadetime);
-	}	
+		curChannel = res.Play(fadetime, loops, channel);
+	}
 
 	void Music::Stop(int fadetime)
 	{
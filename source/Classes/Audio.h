@@ -12,9 +12,21 @@ namespace Dragon2D
 	public:
 		Music();
 		Music(std::string name);
+		//constructor: Music
+		//note: copies (scripts copy on assignment) hold a request of their own, the destructor frees it
+		Music(const Music& other);
+		Music& operator=(const Music& other);
+		//destructor: ~Music
+		//note: frees the audio resource
+		~Music();
 		
+		//function: Load
+		//note: requests the audio resource name (and frees the old one)
 		void Load(std::string name);
 		void Play(int fadetime, int loops);
+		//function: PlayOnChannel
+		//note: like Play(), but on the given channel instead of a free one. For sounds that must start at once on a channel kept free with Mix_ReserveChannels (the buzzer).
+		void PlayOnChannel(int channel, int fadetime, int loops);
 		void Stop(int fadetime = 0);
 	private:
 		std::string name;
@@ -25,6 +37,7 @@ namespace Dragon2D
 		D2DCLASS_SCRIPTINFO_CONSTRUCTOR(Music, std::string)
 		D2DCLASS_SCRIPTINFO_MEMBER(Music, Load)
 		D2DCLASS_SCRIPTINFO_MEMBER(Music, Play)
+		D2DCLASS_SCRIPTINFO_MEMBER(Music, PlayOnChannel)
 	D2DCLASS_SCRIPTINFO_END
 
 }; //namespace Dragon2D
@@ -0,0 +1,83 @@
+#include "AudioLatency.h"
+#include "Env.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace Dragon2D
+{
+	std::atomic<bool> AudioLatency::enabled(false);
+	double AudioLatency::bufferTime = 0.0;
+	std::atomic<std::int64_t> AudioLatency::inputTime(0);
+	std::atomic<bool> AudioLatency::watching(false);
+	std::atomic<std::int64_t> AudioLatency::measured(-1);
+	int AudioLatency::count = 0;
+	std::int64_t AudioLatency::total = 0;
+	std::int64_t AudioLatency::worst = 0;
+
+	void AudioLatency::SetEnabled(bool enable)
+	{
+		enabled = enable;
+	}
+
+	bool AudioLatency::IsEnabled()
+	{
+		return enabled;
+	}
+
+	void AudioLatency::SetBufferTime(double ms)
+	{
+		bufferTime = ms;
+	}
+
+	double AudioLatency::GetBufferTime()
+	{
+		return bufferTime;
+	}
+
+	void AudioLatency::MarkInput()
+	{
+		if (enabled) {
+			inputTime = _Now();
+		}
+	}
+
+	void AudioLatency::Watch(int channel)
+	{
+		if (!enabled || channel < 0 || inputTime == 0) {
+			return;
+		}
+		watching = true;
+		//the effect goes away with the sound, when the channel stops
+		Mix_RegisterEffect(channel, _Effect, nullptr, nullptr);
+	}
+
+	void AudioLatency::Update()
+	{
+		std::int64_t latency = measured.exchange(-1);
+		if (latency < 0) {
+			return;
+		}
+		count++;
+		total += latency;
+		worst = std::max(worst, latency);
+		Env::Out() << "Audio latency: " << latency / 1000.0 << " ms from the input to the mixer, +" << bufferTime << " ms device buffer (average " << total / count / 1000.0 << " ms, worst " << worst / 1000.0 << " ms of " << count << ")" << std::endl;
+	}
+
+	void AudioLatency::_Effect(int channel, void* stream, int len, void* udata)
+	{
+		//only the first call counts, the later ones are the rest of the sound
+		bool expected = true;
+		if (watching.compare_exchange_strong(expected, false)) {
+			std::int64_t input = inputTime.exchange(0);
+			if (input != 0) {
+				measured = _Now() - input;
+			}
+		}
+	}
+
+	std::int64_t AudioLatency::_Now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "base.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Dragon2D
+{
+	//class: AudioLatency
+	//note: Measures how long it takes from an input (the byte of a buzzer on the serial port) until the mixer starts on the sound that answers it. Off unless "measureAudioLatency = true" is set in the settings.
+	//note: The measured time ends when the audio callback mixes the first samples of the sound. The device buffer (GetBufferTime()) comes on top until it is heard.
+	class AudioLatency
+	{
+	public:
+		//function: SetEnabled
+		//note: turns the measurement on or off
+		static void SetEnabled(bool enable);
+		//function: IsEnabled
+		static bool IsEnabled();
+		//function: SetBufferTime
+		//note: sets the milliseconds of audio in the device buffer, for the log. Set by the Env when it opens the mixer.
+		static void SetBufferTime(double ms);
+		//function: GetBufferTime
+		static double GetBufferTime();
+
+		//function: MarkInput
+		//note: Remembers the time of an input. Any thread, called right where the input is received.
+		static void MarkInput();
+		//function: Watch
+		//note: Call it right after playing the answer to the input on channel. The time is taken when the mixer first reaches the channel. Main thread only.
+		static void Watch(int channel);
+		//function: Update
+		//note: logs new measurements. Main thread only, once every frame.
+		static void Update();
+	private:
+		//function: _Effect
+		//note: the channel effect that takes the time on the mixer thread
+		static void _Effect(int channel, void* stream, int len, void* udata);
+		//function: _Now
+		//note: microseconds of the steady clock
+		static std::int64_t _Now();
+
+		//var: enabled, bufferTime. see SetEnabled() and SetBufferTime()
+		static std::atomic<bool> enabled;
+		static double bufferTime;
+		//var: inputTime. time of the last input, 0 if none waits for a sound
+		static std::atomic<std::int64_t> inputTime;
+		//var: watching. set by Watch() until the mixer took the time
+		static std::atomic<bool> watching;
+		//var: measured. the latest measurement in microseconds, -1 once Update() logged it
+		static std::atomic<std::int64_t> measured;
+		//var: count, total, worst. all measurements so far, for the log
+		static int count;
+		static std::int64_t total;
+		static std::int64_t worst;
+	};
+}
@@ -0,0 +1,222 @@
+#include "AudioStream.h"
+#include "Env.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	std::vector<AudioStream*> AudioStream::playing;
+	std::mutex AudioStream::playingMutex;
+	Mix_Chunk* AudioStream::silentLoop = nullptr;
+
+	bool AudioStream::IsVorbis(const char* data, std::size_t size)
+	{
+		//an ogg page with the vorbis identification header in its first packet
+		return size > 35 && std::memcmp(data, "OggS", 4) == 0 && std::memcmp(data + 29, "vorbis", 6) == 0;
+	}
+
+	bool AudioStream::Check(const char* data, std::size_t size, std::string& error)
+	{
+		AudioStream stream(nullptr, data, size, 0);
+		OggVorbis_File check;
+		ov_callbacks callbacks = { _Read, _Seek, nullptr, _Tell };
+		if (ov_open_callbacks(&stream, &check, nullptr, 0, callbacks) != 0) {
+			error = "Not a valid ogg vorbis file";
+			return false;
+		}
+		ov_clear(&check);
+		return true;
+	}
+
+	int AudioStream::Play(std::shared_ptr<const void> owner, const char* data, std::size_t size, int loops, int fadetime, int channel)
+	{
+		AudioStream* stream = new AudioStream(owner, data, size, loops);
+		std::string error;
+		if (!stream->_Open(error)) {
+			Env::Err() << "ERROR: Cannot play audio stream: " << error << std::endl;
+			delete stream;
+			return -1;
+		}
+		if (!silentLoop) {
+			//the samples are replaced by the effect, the chunk only keeps the channel busy until it is halted
+			static Uint8 samples[4096] = {};
+			silentLoop = Mix_QuickLoad_RAW(samples, sizeof(samples));
+		}
+		stream->channel = Mix_FadeInChannel(channel, silentLoop, -1, fadetime);
+		if (stream->channel < 0) {
+			delete stream;
+			return -1;
+		}
+		{
+			std::lock_guard<std::mutex> lock(playingMutex);
+			playing.push_back(stream);
+		}
+		if (!Mix_RegisterEffect(stream->channel, _Effect, _EffectDone, stream)) {
+			{
+				std::lock_guard<std::mutex> lock(playingMutex);
+				playing.erase(std::remove(playing.begin(), playing.end(), stream), playing.end());
+			}
+			Mix_HaltChannel(stream->channel);
+			delete stream;
+			return -1;
+		}
+		return stream->channel;
+	}
+
+	void AudioStream::Update()
+	{
+		std::vector<int> ended;
+		{
+			std::lock_guard<std::mutex> lock(playingMutex);
+			for (AudioStream* stream : playing) {
+				if (stream->finished) {
+					ended.push_back(stream->channel);
+				}
+			}
+		}
+		//halting calls _EffectDone, which needs the lock
+		for (int c : ended) {
+			Mix_HaltChannel(c);
+		}
+	}
+
+	std::size_t AudioStream::GetPlayingCount()
+	{
+		std::lock_guard<std::mutex> lock(playingMutex);
+		return playing.size();
+	}
+
+	AudioStream::AudioStream(std::shared_ptr<const void> streamOwner, const char* streamData, std::size_t streamSize, int streamLoops)
+		: owner(streamOwner), data(streamData), size(streamSize), position(0), open(false), converter(nullptr), silence(0), loops(streamLoops), ended(false), finished(false), channel(-1)
+	{
+
+	}
+
+	AudioStream::~AudioStream()
+	{
+		if (converter) {
+			SDL_FreeAudioStream(converter);
+		}
+		if (open) {
+			ov_clear(&vorbis);
+		}
+	}
+
+	bool AudioStream::_Open(std::string& error)
+	{
+		ov_callbacks callbacks = { _Read, _Seek, nullptr, _Tell };
+		if (ov_open_callbacks(this, &vorbis, nullptr, 0, callbacks) != 0) {
+			error = "Not a valid ogg vorbis file";
+			return false;
+		}
+		open = true;
+		int frequency;
+		Uint16 format;
+		int channels;
+		if (!Mix_QuerySpec(&frequency, &format, &channels)) {
+			error = std::string("The mixer is not open: ") + Mix_GetError();
+			return false;
+		}
+		vorbis_info* info = ov_info(&vorbis, -1);
+		converter = SDL_NewAudioStream(AUDIO_S16SYS, Uint8(info->channels), int(info->rate), format, Uint8(channels), frequency);
+		if (!converter) {
+			error = std::string("Cannot convert the samples: ") + SDL_GetError();
+			return false;
+		}
+		silence = SDL_AUDIO_ISSIGNED(format) ? 0 : 0x80;
+		return true;
+	}
+
+	void AudioStream::_Fill(Uint8* stream, int len)
+	{
+		int filled = 0;
+		while (filled < len) {
+			int got = SDL_AudioStreamGet(converter, stream + filled, len - filled);
+			if (got > 0) {
+				filled += got;
+			}
+			else if (!_Decode()) {
+				break;
+			}
+		}
+		if (filled < len) {
+			std::memset(stream + filled, silence, len - filled);
+			if (ended && SDL_AudioStreamAvailable(converter) == 0) {
+				finished = true;
+			}
+		}
+	}
+
+	bool AudioStream::_Decode()
+	{
+		if (ended) {
+			return false;
+		}
+		for (;;) {
+			int section = 0;
+			long bytes = ov_read(&vorbis, packet, sizeof(packet), SDL_BYTEORDER == SDL_BIG_ENDIAN ? 1 : 0, 2, 1, &section);
+			if (bytes > 0) {
+				SDL_AudioStreamPut(converter, packet, int(bytes));
+				return true;
+			}
+			if (bytes == OV_HOLE) {
+				//a gap in the data, the decoder goes on after it
+				continue;
+			}
+			if (bytes == 0 && loops != 0 && ov_pcm_seek(&vorbis, 0) == 0) {
+				//the next loop follows the last samples in the same converter, so there is no gap
+				if (loops > 0) {
+					loops--;
+				}
+				continue;
+			}
+			//the end (or a broken file): the converter gives out what it holds back for resampling
+			SDL_AudioStreamFlush(converter);
+			ended = true;
+			return SDL_AudioStreamAvailable(converter) > 0;
+		}
+	}
+
+	void AudioStream::_Effect(int channel, void* stream, int len, void* udata)
+	{
+		static_cast<AudioStream*>(udata)->_Fill(static_cast<Uint8*>(stream), len);
+	}
+
+	void AudioStream::_EffectDone(int channel, void* udata)
+	{
+		AudioStream* stream = static_cast<AudioStream*>(udata);
+		{
+			std::lock_guard<std::mutex> lock(playingMutex);
+			playing.erase(std::remove(playing.begin(), playing.end(), stream), playing.end());
+		}
+		delete stream;
+	}
+
+	std::size_t AudioStream::_Read(void* ptr, std::size_t size, std::size_t count, void* source)
+	{
+		AudioStream* stream = static_cast<AudioStream*>(source);
+		if (size == 0) {
+			return 0;
+		}
+		std::size_t items = std::min(count, (stream->size - stream->position) / size);
+		std::memcpy(ptr, stream->data + stream->position, items * size);
+		stream->position += items * size;
+		return items;
+	}
+
+	int AudioStream::_Seek(void* source, ogg_int64_t offset, int whence)
+	{
+		AudioStream* stream = static_cast<AudioStream*>(source);
+		ogg_int64_t base = whence == SEEK_CUR ? ogg_int64_t(stream->position) : whence == SEEK_END ? ogg_int64_t(stream->size) : 0;
+		if (base + offset < 0 || base + offset > ogg_int64_t(stream->size)) {
+			return -1;
+		}
+		stream->position = std::size_t(base + offset);
+		return 0;
+	}
+
+	long AudioStream::_Tell(void* source)
+	{
+		return long(static_cast<AudioStream*>(source)->position);
+	}
+}
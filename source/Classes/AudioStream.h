@@ -0,0 +1,93 @@
+#pragma once
+
+#include "base.h"
+
+#include <vorbis/vorbisfile.h>
+#include <atomic>
+#include <mutex>
+
+namespace Dragon2D
+{
+	//class: AudioStream
+	//note: Plays an ogg vorbis file while it is decoded, instead of decoding all of it into a Mix_Chunk first. Used for music, a decoded track takes tens of MB.
+	//note: The stream plays a short looped silent chunk on a mixer channel and replaces its samples in a channel effect, so volume, fading and halting work like for chunks. Decoding happens in the effect, on the mixer thread, straight from the mapped file.
+	//note: Decoded samples go through an SDL_AudioStream (converting to the format of the mixer), which holds at most one decoded packet more then the mixer asks for.
+	class AudioStream
+	{
+	public:
+		//function: IsVorbis
+		//note: returns true if data looks like an ogg vorbis file
+		static bool IsVorbis(const char* data, std::size_t size);
+		//function: Check
+		//note: Opens data like Play() would, to find broken files while loading. Returns false and sets error if it can not be played. Thread safe.
+		static bool Check(const char* data, std::size_t size, std::string& error);
+
+		//function: Play
+		//note: Plays data on a free channel and returns the channel, -1 if there is none or data can not be played. Main thread only.
+		//param:	owner: keeps data alive while it is played
+		//		data, size: the ogg vorbis file
+		//		loops: like Mix_PlayChannel, -1 loops forever. The track starts again without a gap.
+		//		fadetime: milliseconds to fade in
+		//		channel: the channel to play on, -1 for a free one
+		static int Play(std::shared_ptr<const void> owner, const char* data, std::size_t size, int loops, int fadetime, int channel = -1);
+		//function: Update
+		//note: halts the channels of streams that ended. Main thread only, once every frame.
+		static void Update();
+		//function: GetPlayingCount
+		//note: returns the number of streams that are played right now
+		static std::size_t GetPlayingCount();
+	private:
+		AudioStream(std::shared_ptr<const void> owner, const char* data, std::size_t size, int loops);
+		~AudioStream();
+		AudioStream(const AudioStream&) = delete;
+		AudioStream& operator=(const AudioStream&) = delete;
+
+		//function: _Open
+		//note: opens the decoder and the converter to the mixer format. Returns false (and sets error) on errors.
+		bool _Open(std::string& error);
+		//function: _Fill
+		//note: fills len bytes of the mixer with the next samples, silence once the stream ended
+		void _Fill(Uint8* stream, int len);
+		//function: _Decode
+		//note: decodes the next packet into the converter. Starts again at the end while loops are left. Returns false once the end is reached.
+		bool _Decode();
+
+		//function: _Effect, _EffectDone
+		//note: the channel effect of SDL_mixer. _EffectDone is called when the channel stops, and deletes the stream.
+		static void _Effect(int channel, void* stream, int len, void* udata);
+		static void _EffectDone(int channel, void* udata);
+		//function: _Read, _Seek, _Tell
+		//note: the file callbacks of the vorbis decoder, on the memory of the file
+		static std::size_t _Read(void* ptr, std::size_t size, std::size_t count, void* source);
+		static int _Seek(void* source, ogg_int64_t offset, int whence);
+		static long _Tell(void* source);
+
+		//var: owner, data, size, position. the file and where the decoder reads
+		std::shared_ptr<const void> owner;
+		const char* data;
+		std::size_t size;
+		std::size_t position;
+		//var: vorbis, open. the decoder
+		OggVorbis_File vorbis;
+		bool open;
+		//var: converter. decoded samples in the format of the mixer, waiting to be mixed
+		SDL_AudioStream* converter;
+		//var: silence. value of silent bytes in the mixer format
+		Uint8 silence;
+		//var: loops. loops that are left, -1 for endless
+		int loops;
+		//var: ended. set once the last samples are in the converter
+		bool ended;
+		//var: finished. set by the mixer thread once the last samples were played
+		std::atomic<bool> finished;
+		int channel;
+		//var: packet. the last decoded packet
+		char packet[4096];
+
+		//var: playing. the streams that are played, protected by playingMutex
+		static std::vector<AudioStream*> playing;
+		static std::mutex playingMutex;
+		//var: silentLoop. the chunk the channels of the streams play
+		static Mix_Chunk* silentLoop;
+	};
+}
@@ -1,4 +1,5 @@
 #include "BaseClass.h"
+#include "Env.h"
 
 namespace Dragon2D
 {
@@ -62,6 +63,7 @@ namespace Dragon2D
 	{
 		auto stillToRender = children;
 		for (unsigned int curlayer = 0; stillToRender.size() > 0; curlayer++) {
+			Env::GetSpriteBatch().NextLayer();
 			for (auto c = stillToRender.begin(); c != stillToRender.end(); c++) {
 				if ((*c)->GetRenderLayer() <= curlayer) {
 					(*c)->Render();
@@ -0,0 +1,58 @@
+#include "CachedText.h"
+#include "Env.h"
+
+namespace Dragon2D
+{
+	CachedText::CachedText()
+		: wrapWidth(0)
+	{
+
+	}
+
+	CachedText::~CachedText()
+	{
+
+	}
+
+	void CachedText::SetForgroundColor(glm::vec4 color)
+	{
+		if (color == fgcolor) {
+			return;
+		}
+		TextElement::SetForgroundColor(color);
+		dirty = true;
+	}
+
+	void CachedText::SetWrapWidth(int width)
+	{
+		if (width != wrapWidth) {
+			wrapWidth = width;
+			dirty = true;
+		}
+	}
+
+	int CachedText::GetWrapWidth()
+	{
+		return wrapWidth;
+	}
+
+	TailTipUI::GeneralElement* CachedText::Replace(TailTipUI::GeneralElement* element)
+	{
+		return TextElement::Replace<CachedText>(element);
+	}
+
+	void CachedText::_Render()
+	{
+		if (dirty) {
+			//the old texture stays in the cache, the element only lets go of it
+			texture = Env::GetResourceManager().GetTextCache().Get(font, fgcolor, name, wrapWidth);
+			textWidth = texture ? texture->width : 0;
+			textHeight = texture ? texture->height : 0;
+			dirty = false;
+		}
+		if (!texture) {
+			return;
+		}
+		TailTipUI::RenderElementByTexture(texture->texture, RelativePositionToParent());
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "base.h"
+#include "TextElement.h"
+#include "TextCache.h"
+
+namespace Dragon2D
+{
+	//class: CachedText
+	//note: A TailTipUI text element that gets its texture from the TextCache of the ResourceManager. Texts that were shown before (names, answers shown again, ...) are not rendered again.
+	//note: Unlike GlyphText it works with any text and font (wrapped lines, kerning, every glyph), but a text that was not cached still costs a render and an upload.
+	//note: Use Replace() to swap a Text of a loaded Ui for a CachedText.
+	class CachedText : public TextElement
+	{
+	public:
+		CachedText();
+		virtual ~CachedText();
+
+		virtual void SetForgroundColor(glm::vec4 color) override;
+
+		//function: SetWrapWidth
+		//note: wraps lines at width pixels of the font, 0 (default) for one line. The height of the position is the height of all lines then.
+		virtual void SetWrapWidth(int width);
+		//function: GetWrapWidth
+		//note: returns the wrap width
+		virtual int GetWrapWidth();
+
+		//function: Replace
+		//note: Replaces a TailTipUI::Text in its tree with a CachedText, see TextElement::Replace().
+		static TailTipUI::GeneralElement* Replace(TailTipUI::GeneralElement* element);
+	protected:
+		virtual void _Render() override;
+	private:
+		int wrapWidth;
+		std::shared_ptr<const TextCache::Texture> texture;
+	};
+}
@@ -2,6 +2,7 @@
 //contains functions for the env class 
 
 #include "Env.h"
+#include "AudioLatency.h"
 
 namespace Dragon2D {
 
@@ -167,6 +168,7 @@ namespace Dragon2D {
 		glGenBuffers(1, &quadBuffer);
 		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(g_quad), g_quad, GL_STATIC_DRAW);
+		spriteBatch.reset(new SpriteBatch(quadBuffer));
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glEnable(GL_BLEND);
@@ -188,9 +190,19 @@ namespace Dragon2D {
 		if (settings[engineInitName]["requestFLAC"] == std::string("true")) {
 			mixerInitFlags |= MIX_INIT_FLAC;
 		}
-		if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096) != 0) {
+		//sample frames the device plays per callback. A sound waits up to that long before it is mixed, 4096 frames are 93 ms
+		int audioFrequency = 44100;
+		int audioBufferSize = atoi(settings[engineInitName]["audioBufferSize"].c_str());
+		if (audioBufferSize <= 0) {
+			audioBufferSize = 4096;
+		}
+		if (Mix_OpenAudio(audioFrequency, MIX_DEFAULT_FORMAT, 2, audioBufferSize) != 0) {
 			throw EnvException("Could not open Audio Device!");
 		}
+		AudioLatency::SetBufferTime(audioBufferSize * 1000.0 / audioFrequency);
+		if (settings[engineInitName]["measureAudioLatency"] == std::string("true")) {
+			AudioLatency::SetEnabled(true);
+		}
 		int inittedMixerFlags = Mix_Init(mixerInitFlags);
 		//Hope that all modes were supported, but dont think that it will always work!
 		if (mixerInitFlags != inittedMixerFlags) {
@@ -229,8 +241,40 @@ namespace Dragon2D {
 			throw EnvException("Could not init SDL_TTF!");
 		}
 
-		//in the end fire up the resource manager
-		resourceManager.reset(new ResourceManager);
+		//in the end fire up the resource manager. loaderThreads = 0 (or not set) picks the number of threads by the cpu
+		int loaderThreads = atoi(settings[engineInitName]["loaderThreads"].c_str());
+		resourceManager.reset(new ResourceManager(loaderThreads));
+		//memory budgets per resource type in MB, like "textureBudget = 256". Types without one use ResourceManager::DefaultMemoryBudget
+		for (std::string type : { "audio", "video", "texture", "xml", "font", "shader", "map", "text" }) {
+			std::string budget = settings[engineInitName][type + "Budget"];
+			if (budget != "") {
+				resourceManager->SetMemoryBudget(type, std::size_t(atoi(budget.c_str())) * 1024 * 1024);
+			}
+		}
+		//larger textures are scaled down to textureMaxSize (0 for no limit)
+		std::string textureMaxSize = settings[engineInitName]["textureMaxSize"];
+		if (textureMaxSize != "") {
+			TextureResource::SetMaxSize(atoi(textureMaxSize.c_str()));
+		}
+		//ogg vorbis files from audioStreamSize KB on are decoded while they play
+		std::string audioStreamSize = settings[engineInitName]["audioStreamSize"];
+		if (audioStreamSize != "") {
+			AudioResource::SetStreamSize(std::size_t(atoi(audioStreamSize.c_str())) * 1024);
+		}
+		//small textures share atlas pages unless "textureAtlas = false"
+		if (settings[engineInitName]["textureAtlas"] == std::string("false")) {
+			resourceManager->GetAtlas().SetEnabled(false);
+		}
+		//rendered ui texts are kept up to textCacheBudget MB
+		std::string textCacheBudget = settings[engineInitName]["textCacheBudget"];
+		if (textCacheBudget != "") {
+			resourceManager->GetTextCache().SetBudget(std::size_t(atoi(textCacheBudget.c_str())) * 1024 * 1024);
+		}
+
+		//changed files are loaded again while the game runs
+		if (settings[engineInitName]["hotReload"] == std::string("true")) {
+			resourceManager->WatchFiles(true);
+		}
 
 		//fire up input
 		input.reset(new Input);
@@ -239,11 +283,14 @@ namespace Dragon2D {
 		TailTipUI::Info(settings[gameInitName]["title"], width, height);
 		TailTipUI::Info::SetMouseCallback(Env::GetCurrentMouseState);
 		TailTipUI::Info::SetButtonCallback(Env::GetCurrentKeysRaw);
+		//the ui asks by name, the handles are found in a hash table instead of the sorted resource maps
 		TailTipUI::Info::SetImageCallback([this](std::string name) {
-			return resourceManager->GetTextureResource(name).GetTextureId();
+			//the ui keeps the id, so it must not get the placeholder
+			resourceManager->FinishTextureResource(name);
+			return resourceManager->Get(resourceManager->GetTextureHandle(name)).GetTextureId();
 		});
 		TailTipUI::Info::SetFontCallback([this](std::string name, int size) {
-			return resourceManager->GetFontResource(name).GetFont(size);
+			return resourceManager->Get(resourceManager->GetFontHandle(name)).GetFont(size);
 		});
 		TailTipUI::Info::SetTextBufferResetCallback(Env::ResetCurrentTextInput);
 		TailTipUI::Info::SetGetTextBufferCallback(Env::GetCurrentText);
@@ -255,6 +302,7 @@ namespace Dragon2D {
 	Env::~Env()
 	{
 		input.reset();
+		spriteBatch.reset();
 		resourceManager.reset();
 		Mix_Quit();
 		SDL_GL_DeleteContext(context);
@@ -291,6 +339,7 @@ namespace Dragon2D {
 	void Env::SwapBuffers()
 	{
 		_CheckEnv();
+		ActiveEnv->spriteBatch->EndFrame();
 		SDL_GL_SwapWindow(ActiveEnv->window);
 	}
 
@@ -352,6 +401,23 @@ namespace Dragon2D {
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		glDisableVertexAttribArray(0);
+		ActiveEnv->spriteBatch->CountDrawCalls();
+	}
+
+	SpriteBatch& Env::GetSpriteBatch()
+	{
+		_CheckEnv();
+		return *(ActiveEnv->spriteBatch);
+	}
+
+	int Env::GetDrawCalls()
+	{
+		return GetSpriteBatch().GetDrawCalls();
+	}
+
+	int Env::GetDrawnQuads()
+	{
+		return GetSpriteBatch().GetQuads();
 	}
 
 	glm::vec2 Env::GetResolution()
@@ -376,6 +442,15 @@ namespace Dragon2D {
 		return stream.open(ActiveEnv->GetGamepath() + file, mode);
 	}
 
+	bool Env::ReadGamefile(std::string file, std::string& out)
+	{
+		_CheckEnv();
+		if (ActiveEnv->resourceManager && ActiveEnv->resourceManager->GetPack().Read(file, out)) {
+			return true;
+		}
+		return HoardXML::ReadFile(ActiveEnv->GetGamepath() + file, out);
+	}
+
 	ResourceManager& Env::GetResourceManager()
 	{
 		_CheckEnv();
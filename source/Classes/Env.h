@@ -5,6 +5,7 @@
 //includes
 #include "base.h"
 #include "ResourceManager.h"
+#include "SpriteBatch.h"
 #include "Input.h"
 
 namespace Dragon2D {
@@ -55,6 +56,9 @@ namespace Dragon2D {
 		//function: Gamefile(std::string file, std::ios_base::openmode mode);
 		//note: opens file from the game directory
 		static void Gamefile(std::string file, std::ios_base::openmode mode, std::fstream&stream);
+		//function: ReadGamefile(std::string file, std::string& out)
+		//note: Reads file from the game directory into out, from the game.pak if it contains the file. Returns false if the file does not exist. Can be used by loader threads.
+		static bool ReadGamefile(std::string file, std::string& out);
 		//function: Enginefile(std::string file, std::ios_base::openmode mode);
 		//note: opens file from the engine directory
 		static void Enginefile(std::string file, std::ios_base::openmode mode, std::fstream&stream);
@@ -72,7 +76,7 @@ namespace Dragon2D {
 		//OpenGL foo
 
 		//function: swapBuffers()
-		//note: swaps the screen buffers
+		//note: swaps the screen buffers. Draws what is left in the SpriteBatch first.
 		static void SwapBuffers();
 		//function: clearScreen()
 		//note: cleans the active Framebuffer
@@ -81,6 +85,15 @@ namespace Dragon2D {
 		//note: Renders a Quad on the screen. 
 		//		Everything but the render-call needs to be done til here, so bind a shader, a texture,... and everything by yourself til here!
 		static void RenderQuad();
+		//function: GetSpriteBatch
+		//note: returns the SpriteBatch the sprites are drawn with
+		static SpriteBatch& GetSpriteBatch();
+		//function: GetDrawCalls
+		//note: returns the draw calls of the last frame (see SpriteBatch::GetDrawCalls())
+		static int GetDrawCalls();
+		//function: GetDrawnQuads
+		//note: returns the quads the SpriteBatch drew in the last frame
+		static int GetDrawnQuads();
 
 		//function: GenerateFrameBuffer
 		//note: generates a framebuffer
@@ -158,6 +171,8 @@ namespace Dragon2D {
 		GLuint vertexArray;
 		//var: QuadBuffer. buffer that holds a quad for rendering
 		GLuint quadBuffer;
+		//var: spriteBatch. collects the quads of the sprites of a frame
+		std::shared_ptr<SpriteBatch> spriteBatch;
 		//var ResourceManager. The Games ResourceManager
 		std::shared_ptr<ResourceManager> resourceManager;
 
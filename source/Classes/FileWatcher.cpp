@@ -0,0 +1,165 @@
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Dragon2D
+{
+#ifdef __linux__
+	//what counts as a change. Files are reported when they are closed after writing, not on every write
+	static const uint32_t WatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF;
+#endif
+	const int FileWatcher::SettleTime;
+
+	FileWatcher::FileWatcher()
+		: fd(-1)
+	{
+
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		Stop();
+	}
+
+	bool FileWatcher::Watch(const std::string& folder)
+	{
+		Stop();
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+		root = folder;
+		if (root.empty() || root.back() != '/') {
+			root += '/';
+		}
+		_AddFolder("", false);
+		if (folders.empty()) {
+			Stop();
+			return false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void FileWatcher::Stop()
+	{
+#ifdef __linux__
+		if (fd >= 0) {
+			//closing the descriptor removes all its watches
+			close(fd);
+		}
+#endif
+		fd = -1;
+		root.clear();
+		folders.clear();
+		pending.clear();
+	}
+
+	bool FileWatcher::IsWatching() const
+	{
+		return fd >= 0;
+	}
+
+	int FileWatcher::Poll(std::vector<std::string>& changed)
+	{
+		if (fd < 0) {
+			return 0;
+		}
+		auto now = std::chrono::steady_clock::now();
+#ifdef __linux__
+		//aligned like the kernel wants it, room for many events per read
+		alignas(struct inotify_event) char buffer[16 * 1024];
+		for (;;) {
+			ssize_t length = read(fd, buffer, sizeof(buffer));
+			if (length <= 0) {
+				//EAGAIN: nothing more to read
+				break;
+			}
+			for (char* p = buffer; p < buffer + length;) {
+				const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+				p += sizeof(struct inotify_event) + event->len;
+				auto folder = folders.find(event->wd);
+				if (event->mask & IN_IGNORED) {
+					//the folder was deleted (or moved away)
+					if (folder != folders.end()) {
+						folders.erase(folder);
+					}
+					continue;
+				}
+				if (folder == folders.end() || event->len == 0 || _IsIgnored(event->name)) {
+					continue;
+				}
+				std::string path = folder->second + event->name;
+				if (event->mask & IN_ISDIR) {
+					//new folders are watched too, the files in them count as changed
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						_AddFolder(path, true);
+					}
+					continue;
+				}
+				//created files are reported by IN_CLOSE_WRITE once they are written
+				if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+					pending[path] = now;
+				}
+			}
+		}
+#endif
+		int count = 0;
+		for (auto file = pending.begin(); file != pending.end();) {
+			if (now - file->second >= std::chrono::milliseconds(SettleTime)) {
+				changed.push_back(file->first);
+				count++;
+				file = pending.erase(file);
+			}
+			else {
+				file++;
+			}
+		}
+		return count;
+	}
+
+	void FileWatcher::_AddFolder(const std::string& path, bool reportFiles)
+	{
+#ifdef __linux__
+		std::string folder = root + path;
+		int wd = inotify_add_watch(fd, folder.c_str(), WatchMask | IN_ONLYDIR);
+		if (wd < 0) {
+			return;
+		}
+		std::string relative = path.empty() ? path : path + '/';
+		folders[wd] = relative;
+		DIR* dir = opendir(folder.c_str());
+		if (!dir) {
+			return;
+		}
+		while (struct dirent* entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name == "." || name == ".." || _IsIgnored(name)) {
+				continue;
+			}
+			//some file systems do not know the type. Watching a file fails because of IN_ONLYDIR, so that is fine
+			if (entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN) {
+				_AddFolder(relative + name, reportFiles);
+			}
+			if (reportFiles && entry->d_type != DT_DIR) {
+				//written before the folder was watched
+				pending[relative + name] = std::chrono::steady_clock::now();
+			}
+		}
+		closedir(dir);
+#endif
+	}
+
+	bool FileWatcher::_IsIgnored(const std::string& name)
+	{
+		return name.empty() || name[0] == '.' || name.back() == '~';
+	}
+}
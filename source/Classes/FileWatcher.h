@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+namespace Dragon2D
+{
+	//class: FileWatcher
+	//note: Watches a folder and all folders in it for files that were written, moved in or created. Uses inotify on linux and does nothing on the other systems (IsWatching() is false there).
+	//note: Nothing blocks: Poll() only takes the events the system has collected since the last call. Editors often write a file more then once, so a file is only reported once it was quiet for SettleTime.
+	class FileWatcher
+	{
+	public:
+		//const: SettleTime
+		//note: milliseconds a file has to be unchanged before Poll() reports it
+		static const int SettleTime = 100;
+
+		//constructor: FileWatcher
+		//note: creates a FileWatcher that watches nothing
+		FileWatcher();
+		//destructor: ~FileWatcher
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		//function: Watch
+		//note: Starts watching "folder" and everything in it. Stops watching the folder watched before. Returns false if the folder can not be watched.
+		//param:	folder: the folder to watch, with or without a slash at the end
+		bool Watch(const std::string& folder);
+		//function: Stop
+		//note: stops watching
+		void Stop();
+		//function: IsWatching
+		//note: returns true if a folder is watched
+		bool IsWatching() const;
+
+		//function: Poll
+		//note: Appends the files that changed to "changed", relative to the watched folder and with '/' between folders ("texture/player.png"). Every file is reported once, however often it was written. Returns the number of files appended.
+		//note: Hidden files (starting with '.') and backups (ending with '~') are left out.
+		int Poll(std::vector<std::string>& changed);
+	private:
+		//function: _AddFolder
+		//note: watches the folder "path" (relative to root, "" for root itself) and the folders in it
+		//param:	reportFiles: true for folders that are new, the files already in them are reported by Poll()
+		void _AddFolder(const std::string& path, bool reportFiles);
+		//function: _IsIgnored
+		//note: returns true for names of files editors use for themselves
+		static bool _IsIgnored(const std::string& name);
+
+		//var: fd. the inotify descriptor, -1 if nothing is watched
+		int fd;
+		//var: root. the watched folder, ending with a slash
+		std::string root;
+		//var: folders. folder (relative to root, ending with a slash or "") by watch descriptor
+		std::map<int, std::string> folders;
+		//var: pending. changed files by the time of their last change, until they settle
+		std::map<std::string, std::chrono::steady_clock::time_point> pending;
+	};
+}
@@ -1,4 +1,5 @@
 #include "GameManager.h"
+#include "AudioLatency.h"
 
 namespace Dragon2D {
 
@@ -86,6 +87,10 @@ void GameManager::RunGame(UpdateCallback c, UpdateCallback r)
 		}
 		toAdd.clear();
 
+		//finish resources that were loaded in the background
+		Env::GetResourceManager().Update();
+		AudioLatency::Update();
+
 
 		//Update - delta div dt times!
 		while(timeLeft>=ticksize) {
@@ -106,8 +111,10 @@ void GameManager::RunGame(UpdateCallback c, UpdateCallback r)
 			renderCallback();
 		}
 
+		//sprites go into the SpriteBatch, sorted by layer. Env::SwapBuffers() draws the rest
 		auto stillToRender = elements;
 		for (unsigned int curlayer = 0; stillToRender.size() > 0; curlayer++) {
+			Env::GetSpriteBatch().NextLayer();
 			for (auto c = stillToRender.begin(); c != stillToRender.end(); c++) {
 				if ((*c)->GetRenderLayer() <= curlayer) {
 					(*c)->Render();
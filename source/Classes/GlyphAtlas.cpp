@@ -0,0 +1,132 @@
+#include "GlyphAtlas.h"
+#include "Env.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	std::unordered_map<TTF_Font*, GlyphAtlas*> GlyphAtlas::atlases;
+
+	GlyphAtlas::GlyphAtlas(TTF_Font* atlasFont)
+		: font(atlasFont), height(TTF_FontHeight(atlasFont)), pages(PageSize)
+	{
+		atlases[font] = this;
+	}
+
+	GlyphAtlas::~GlyphAtlas()
+	{
+		auto registered = atlases.find(font);
+		if (registered != atlases.end() && registered->second == this) {
+			atlases.erase(registered);
+		}
+	}
+
+	GlyphAtlas* GlyphAtlas::Find(TTF_Font* font)
+	{
+		auto registered = atlases.find(font);
+		return registered != atlases.end() ? registered->second : nullptr;
+	}
+
+	const GlyphAtlas::Glyph& GlyphAtlas::GetGlyph(std::uint32_t codepoint)
+	{
+		if (codepoint > 0xFFFF) {
+			codepoint = '?';
+		}
+		auto known = glyphs.find(codepoint);
+		if (known != glyphs.end()) {
+			return known->second;
+		}
+		Glyph& glyph = glyphs[codepoint];
+		_Rasterize(Uint16(codepoint), glyph);
+		return glyph;
+	}
+
+	int GlyphAtlas::Layout(const std::string& text, std::vector<Quad>& quads)
+	{
+		quads.clear();
+		int pen = 0;
+		std::size_t i = 0;
+		while (i < text.size()) {
+			//decode one UTF-8 sequence. Anything else is a latin-1 character
+			unsigned char lead = (unsigned char)text[i];
+			std::uint32_t codepoint = lead;
+			std::size_t length = 1;
+			if (lead >= 0xC0 && lead < 0xF8) {
+				length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+				std::uint32_t decoded = lead & (0x3F >> (length - 1));
+				bool valid = i + length <= text.size();
+				for (std::size_t k = 1; valid && k < length; k++) {
+					unsigned char next = (unsigned char)text[i + k];
+					valid = (next & 0xC0) == 0x80;
+					decoded = (decoded << 6) | (next & 0x3F);
+				}
+				if (valid) {
+					codepoint = decoded;
+				}
+				else {
+					length = 1;
+				}
+			}
+			i += length;
+
+			const Glyph& glyph = GetGlyph(codepoint);
+			if (glyph.region.width > 0) {
+				Quad quad;
+				quad.texture = glyph.region.texture;
+				quad.pos = glm::vec4(pen + glyph.x, glyph.y, glyph.region.width, glyph.region.height);
+				quad.uv = glyph.region.uv;
+				quads.push_back(quad);
+			}
+			pen += glyph.advance;
+		}
+		return pen;
+	}
+
+	int GlyphAtlas::GetHeight() const
+	{
+		return height;
+	}
+
+	TTF_Font* GlyphAtlas::GetFont() const
+	{
+		return font;
+	}
+
+	std::size_t GlyphAtlas::GetGlyphCount() const
+	{
+		return glyphs.size();
+	}
+
+	void GlyphAtlas::_Rasterize(Uint16 character, Glyph& glyph)
+	{
+		glyph.x = 0;
+		glyph.y = 0;
+		glyph.advance = 0;
+		int minx, maxx, miny, maxy;
+		if (TTF_GlyphMetrics(font, character, &minx, &maxx, &miny, &maxy, &glyph.advance) != 0) {
+			return;
+		}
+		//white, the color is applied when the text is drawn
+		SDL_Color white = { 255, 255, 255, 255 };
+		SDL_Surface* surface = TTF_RenderGlyph_Blended(font, character, white);
+		if (!surface || surface->w == 0) {
+			//glyphs without pixels (like space) only move the pen
+			SDL_FreeSurface(surface);
+			return;
+		}
+		if (surface->h == height) {
+			//newer SDL_ttf versions render a cell of the line height, starting at the pen (or left of it for glyphs that reach back)
+			glyph.x = std::min(minx, 0);
+		}
+		else {
+			//older versions only render the bitmap of the glyph
+			glyph.x = minx;
+			glyph.y = TTF_FontAscent(font) - maxy;
+		}
+		std::vector<unsigned char> pixels;
+		if (!TextureAtlas::PrepareImage(surface, pixels) || !pages.Insert(pixels, surface->w, surface->h, glyph.region)) {
+			Env::Out() << "WARNING: glyph " << character << " (" << surface->w << "x" << surface->h << ") does not fit into the glyph atlas, it will be empty!" << std::endl;
+		}
+		SDL_FreeSurface(surface);
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "base.h"
+#include "TextureAtlas.h"
+
+#include <unordered_map>
+
+namespace Dragon2D
+{
+	//class: GlyphAtlas
+	//note: The glyphs of one font at one size. Each glyph is rasterized once, the first time it is used, and kept in a TextureAtlas of its own.
+	//note: Text is then laid out as a list of quads on the atlas pages, so changing a text only changes vertices: nothing is rasterized or uploaded again.
+	//note: Every TTF_Font of a FontResource has a GlyphAtlas, Find() returns it for the font of a TailTipUI element.
+	class GlyphAtlas
+	{
+	public:
+		//const: PageSize
+		//note: width and height of the atlas pages. A page holds a few hundred glyphs at 64 points.
+		static const int PageSize = 1024;
+
+		//class: Glyph
+		//note: a rasterized glyph. Pixels are counted from the top left of the line, like SDL_ttf does.
+		struct Glyph
+		{
+			//var: region. where the glyph is in the atlas. width and height are 0 for glyphs without pixels (space)
+			AtlasRegion region;
+			//var: x, y. offset of the image from the pen position and the top of the line
+			int x, y;
+			//var: advance. how far the pen moves after the glyph
+			int advance;
+		};
+
+		//class: Quad
+		//note: a glyph of a laid out text
+		struct Quad
+		{
+			//var: texture. the atlas page to draw with
+			GLuint texture;
+			//var: pos. [0]=x, [1]=y (top left, in pixels from the top left of the text), [2]=width, [3]=height
+			glm::vec4 pos;
+			//var: uv. the region on the page, as in AtlasRegion::uv
+			glm::vec4 uv;
+		};
+
+		//constructor: GlyphAtlas
+		//param:	font: the font to rasterize with. The atlas has to be deleted before the font is closed.
+		GlyphAtlas(TTF_Font* font);
+		~GlyphAtlas();
+
+		GlyphAtlas(const GlyphAtlas&) = delete;
+		GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+		//function: Find
+		//note: returns the atlas of a font, nullptr if the font has none
+		static GlyphAtlas* Find(TTF_Font* font);
+
+		//function: GetGlyph
+		//note: Returns a glyph, rasterizing it the first time. Main thread only.
+		//param:	codepoint: the character. SDL_ttf only renders the basic multilingual plane, everything above becomes '?'.
+		const Glyph& GetGlyph(std::uint32_t codepoint);
+
+		//function: Layout
+		//note: Lays out a line of text and returns its width in pixels. Rasterizes the glyphs not used before.
+		//param:	text: the text in UTF-8. Bytes that are not valid UTF-8 are taken as latin-1.
+		//		quads: gets a quad for each visible glyph (it is cleared first)
+		int Layout(const std::string& text, std::vector<Quad>& quads);
+
+		//function: GetHeight
+		//note: returns the height of a line in pixels
+		int GetHeight() const;
+		//function: GetFont
+		//note: returns the font of the atlas
+		TTF_Font* GetFont() const;
+		//function: GetGlyphCount
+		//note: returns the number of rasterized glyphs
+		std::size_t GetGlyphCount() const;
+	private:
+		//function: _Rasterize
+		//note: renders a glyph and puts it into the atlas
+		void _Rasterize(Uint16 character, Glyph& glyph);
+
+		TTF_Font* font;
+		int height;
+		TextureAtlas pages;
+		std::unordered_map<std::uint32_t, Glyph> glyphs;
+
+		//var: atlases. the atlas of each open font, for Find()
+		static std::unordered_map<TTF_Font*, GlyphAtlas*> atlases;
+	};
+}
@@ -0,0 +1,110 @@
+#include "GlyphText.h"
+#include "Env.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	GlyphText::GlyphText()
+		: atlas(nullptr), vertexBuffer(0)
+	{
+		Env::GetResourceManager().RequestGLProgramResource("glyphText");
+		programHandle = Env::GetResourceManager().GetGLProgramHandle("glyphText");
+		glGenBuffers(1, &vertexBuffer);
+	}
+
+	GlyphText::~GlyphText()
+	{
+		glDeleteBuffers(1, &vertexBuffer);
+		Env::GetResourceManager().FreeGLProgramResource("glyphText");
+	}
+
+	TailTipUI::GeneralElement* GlyphText::Replace(TailTipUI::GeneralElement* element)
+	{
+		if (!element || !GlyphAtlas::Find(element->GetFont())) {
+			return element;
+		}
+		return TextElement::Replace<GlyphText>(element);
+	}
+
+	void GlyphText::_Render()
+	{
+		static const std::uint32_t positionUniform = GLProgramResource::GetUniformId("position");
+		static const std::uint32_t colorUniform = GLProgramResource::GetUniformId("textColor");
+		static const std::uint32_t samplerUniform = GLProgramResource::GetUniformId("textureSampler");
+
+		GlyphAtlas* glyphs = GlyphAtlas::Find(font);
+		if (!glyphs) {
+			return;
+		}
+		if (dirty || glyphs != atlas) {
+			_Layout(glyphs);
+		}
+		if (batches.empty() || textWidth <= 0) {
+			return;
+		}
+
+		//the vertices are in pixels of the font, the position scales them onto the screen. Moving the text does not touch them
+		glm::vec4 absolute = RelativePositionToParent();
+		float scaleX = absolute[2] / textWidth;
+		float scaleY = absolute[3] / textHeight;
+
+		GLProgramResource &p = Env::GetResourceManager().Get(programHandle);
+		p.Use();
+		glUniform4f(p.GetUniform(positionUniform), absolute.x, absolute.y, scaleX, scaleY);
+		glUniform4f(p.GetUniform(colorUniform), fgcolor[0], fgcolor[1], fgcolor[2], fgcolor[3]);
+		glUniform1i(p.GetUniform(samplerUniform), 0);
+		glActiveTexture(GL_TEXTURE0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(sizeof(GLfloat) * 2));
+		for (auto& batch : batches) {
+			TextureResource::BindTexture(batch.texture);
+			glDrawArrays(GL_TRIANGLES, batch.first, batch.count);
+		}
+		Env::GetSpriteBatch().CountDrawCalls((int)batches.size());
+		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(0);
+	}
+
+	void GlyphText::_Layout(GlyphAtlas* glyphs)
+	{
+		atlas = glyphs;
+		dirty = false;
+		textWidth = atlas->Layout(name, quads);
+		textHeight = atlas->GetHeight();
+		//one batch per atlas page, mostly there is only one
+		std::stable_sort(quads.begin(), quads.end(), [](const GlyphAtlas::Quad& a, const GlyphAtlas::Quad& b) { return a.texture < b.texture; });
+
+		vertices.clear();
+		batches.clear();
+		for (auto& quad : quads) {
+			if (batches.empty() || batches.back().texture != quad.texture) {
+				Batch batch = { quad.texture, GLint(vertices.size()), 0 };
+				batches.push_back(batch);
+			}
+			//x, y in pixels from the top left of the text, u, v on the page (its rows start at the bottom)
+			glm::vec2 topLeft(quad.pos.x, quad.pos.y);
+			glm::vec2 size(quad.pos[2], quad.pos[3]);
+			glm::vec4 uv = quad.uv;
+			glm::vec4 tl(topLeft.x, topLeft.y, uv[0], uv[1] + uv[3]);
+			glm::vec4 tr(topLeft.x + size.x, topLeft.y, uv[0] + uv[2], uv[1] + uv[3]);
+			glm::vec4 bl(topLeft.x, topLeft.y + size.y, uv[0], uv[1]);
+			glm::vec4 br(topLeft.x + size.x, topLeft.y + size.y, uv[0] + uv[2], uv[1]);
+			vertices.push_back(bl);
+			vertices.push_back(br);
+			vertices.push_back(tl);
+			vertices.push_back(tl);
+			vertices.push_back(br);
+			vertices.push_back(tr);
+			batches.back().count += 6;
+		}
+		if (!vertices.empty()) {
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec4), &vertices[0][0], GL_DYNAMIC_DRAW);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "base.h"
+#include "GlyphAtlas.h"
+#include "TextElement.h"
+#include "ResourceManager.h"
+
+namespace Dragon2D
+{
+	//class: GlyphText
+	//note: A TailTipUI text element that draws its text from the GlyphAtlas of its font, as one batch of quads (shader "glyphText").
+	//note: The TailTipUI::Text renders a new surface and uploads a new texture for every SetName(). Here a new name is only laid out again, which changes a few vertices.
+	//note: Use Replace() to swap a Text of a loaded Ui for a GlyphText.
+	class GlyphText : public TextElement
+	{
+	public:
+		GlyphText();
+		virtual ~GlyphText();
+
+		//function: Replace
+		//note: Replaces a TailTipUI::Text in its tree with a GlyphText, see TextElement::Replace(). Texts with a font without GlyphAtlas stay.
+		static TailTipUI::GeneralElement* Replace(TailTipUI::GeneralElement* element);
+	protected:
+		virtual void _Render() override;
+	private:
+		//class: Batch
+		//note: the glyphs on one atlas page, drawn with one call
+		struct Batch
+		{
+			GLuint texture;
+			GLint first;
+			GLsizei count;
+		};
+
+		//function: _Layout
+		//note: lays out the name with glyphs and uploads the vertices
+		void _Layout(GlyphAtlas* glyphs);
+
+		//var: atlas. the atlas of the last layout
+		GlyphAtlas* atlas;
+		std::vector<GlyphAtlas::Quad> quads;
+		std::vector<glm::vec4> vertices;
+		std::vector<Batch> batches;
+		GLuint vertexBuffer;
+		ResourceHandle<GLProgramResource> programHandle;
+	};
+}
@@ -8,13 +8,14 @@ namespace Dragon2D
 	Input::Input()
 	{
 		std::string infile = Env::GetGamepath() + "cfg/input.xml";
-		HoardXML::Document indoc(infile);
-		auto inputs = indoc["input"];
-		for (auto input : inputs) {
-			if (input->GetName() == "input") {
+		std::string indata;
+		HoardXML::ReadFile(infile, indata);
+		HoardXML::Reader reader(indata.data(), indata.size());
+		while (reader.NextChild(0)) {
+			if (reader.GetName() == "input") {
 				InputEvent newEvent;
-				newEvent.name = input->GetAttribute("name");
-				std::string rawEvent = input->GetAttribute("key");
+				newEvent.name = reader.GetAttribute("name").Str();
+				std::string rawEvent = reader.GetAttribute("key").Str();
 				newEvent.key = rawEvent;
 				//is it a mouseclick?
 				auto pos = rawEvent.find("MOUSE");
@@ -39,7 +40,7 @@ namespace Dragon2D
 				events[newEvent.name] = newEvent;
 			}
 			else {
-				Env::Out() << "WARNING: Unknown input-tag " << input->GetName() << "!" << infile << std::endl;
+				Env::Out() << "WARNING: Unknown input-tag " << reader.GetName() << "!" << infile << std::endl;
 			}
 		}
 	}
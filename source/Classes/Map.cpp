@@ -20,163 +20,161 @@ namespace Dragon2D
 
 	Map::~Map()
 	{
-		std::string filename = std::string("map/") + name + ".xml";
-		Env::GetResourceManager().FreeXMLResource(filename);
 	}
 
 	void Map::Load(std::string name)
 	{
 		std::string filename = std::string("map/") + name + ".xml";
-		Env::GetResourceManager().RequestXMLResource(filename);
-		HoardXML::Document& xmlDoc = Env::GetResourceManager().GetXMLResource(filename).GetDocument();
 		this->name = name;
 
-		if (xmlDoc["map"].size() != 1) {
+		//maps can be big, so we dont build a document but read the file tag by tag
+		std::string indata;
+		Env::ReadGamefile(filename, indata);
+		HoardXML::Reader reader(indata.data(), indata.size());
+		bool foundMap = false;
+		while (!foundMap && reader.NextChild(0)) {
+			foundMap = reader.GetName() == "map";
+		}
+		if (!foundMap) {
 			Env::Err() << "ERROR: Errors in mapfile " << filename << std::endl;
 			return;
 		}
-		auto mapElements = xmlDoc["map"][0]->GetChildren();
-		for (auto c : mapElements) {
+		std::size_t mapDepth = reader.GetDepth();
+		while (reader.NextChild(mapDepth)) {
+			HoardXML::StringRef tagname = reader.GetName();
 			//Info
-			if (c.GetName() == "info") {
-				auto infotags = c.GetChildren();
-				for (auto infotag : infotags) {
-					if (infotag.GetName() == "mapsize") {
-						width = atoi(infotag.GetAttribute("width").c_str());
-						height = atoi(infotag.GetAttribute("height").c_str());
+			if (tagname == "info") {
+				std::size_t infoDepth = reader.GetDepth();
+				while (reader.NextChild(infoDepth)) {
+					HoardXML::StringRef infotag = reader.GetName();
+					if (infotag == "mapsize") {
+						width = reader.GetAttribute("width").ToInt();
+						height = reader.GetAttribute("height").ToInt();
 					}
-					else if (infotag.GetName() == "walkable") {
-						walkarea.x = atoi(infotag.GetAttribute("x").c_str());
-						walkarea.y = atoi(infotag.GetAttribute("y").c_str());
+					else if (infotag == "walkable") {
+						walkarea.x = reader.GetAttribute("x").ToInt();
+						walkarea.y = reader.GetAttribute("y").ToInt();
 					}
-					else if (infotag.GetName() == "tilesize") {
-						keepTileRatio = infotag.GetAttribute("keepRatio") == "true" ? true : false;
+					else if (infotag == "tilesize") {
+						keepTileRatio = reader.GetAttribute("keepRatio") == "true" ? true : false;
 					}
-					else if (infotag.GetName() == "stream") {
-						forceStreamTeleport = infotag.GetAttribute("teleport") == "true" ? true : false;
+					else if (infotag == "stream") {
+						forceStreamTeleport = reader.GetAttribute("teleport") == "true" ? true : false;
 					}
 					else {
-						Env::Out() << "WARNING: unknown map info tag in map file: " << infotag.GetName() << "! " << filename << std::endl;
+						Env::Out() << "WARNING: unknown map info tag in map file: " << infotag << "! " << filename << std::endl;
 					}
 				}
 			}
 			//scriiipt
-			else if (c.GetName() == "script") {
-				mapscript = c.GetData();
+			else if (tagname == "script") {
+				mapscript = reader.ReadData();
 			}
 			//Tile- and streamdata
-			else if (c.GetName() == "mapdata")
+			else if (tagname == "mapdata")
 			{
-				auto tagLayers = c.GetChildren();
-				for (auto l : tagLayers) {
-					std::string layertype = l.GetName();
+				std::size_t layerDepth = reader.GetDepth();
+				while (reader.NextChild(layerDepth)) {
+					HoardXML::StringRef layertype = reader.GetName();
+					std::size_t contentDepth = reader.GetDepth();
 					//its a layer. 
 					if (layertype == "layer") {
 						//layer info
 						MapLayer newLayer;
-						newLayer.id = atoi(l.GetAttribute("id").c_str());
+						newLayer.id = reader.GetAttribute("id").ToInt();
 						newLayer.tileset = NewD2DObject<BatchedTileset>();
-						newLayer.tileset->Load(l.GetAttribute("tileset"));
-						if (l.GetAttribute("nodefault") == "true") {
-							newLayer.defaultId = -1;
+						newLayer.tileset->Load(reader.GetAttribute("tileset").Str());
+						if (reader.GetAttribute("nodefault") == "true") {
+							newLayer.tiles.SetDefault(-1);
 						}
 						else {
-							newLayer.defaultId = atoi(l.GetAttribute("default").c_str());
+							newLayer.tiles.SetDefault(reader.GetAttribute("default").ToInt());
 						}
 						//Load tiles
-						auto tiles = l.GetChildren();
-						for (auto t : tiles) {
-							if (t.GetName() == "tile") {
-								int x = atoi(t.GetAttribute("x").c_str());
-								int y = atoi(t.GetAttribute("y").c_str());
-								int id = atoi(t.GetAttribute("id").c_str());
-								newLayer.tiles[x][y] = id;
+						while (reader.NextChild(contentDepth)) {
+							if (reader.GetName() == "tile") {
+								int x = reader.GetAttribute("x").ToInt();
+								int y = reader.GetAttribute("y").ToInt();
+								int id = reader.GetAttribute("id").ToInt();
+								if (!newLayer.tiles.Set(x, y, id)) {
+									Env::Out() << "WARNING: tile id " << id << " too large in map file: " << filename << std::endl;
+								}
 							}
 							//thats not a tile
 							else {
-								Env::Out() << "WARNING: unknown tile tag in map file: " << t.GetName() << "! " << filename << std::endl;
+								Env::Out() << "WARNING: unknown tile tag in map file: " << reader.GetName() << "! " << filename << std::endl;
 							}
 						}
 
 						//insert into list
 						auto layerIterator = layers.begin();
-						while (layerIterator != layers.end()) {
-							if (layerIterator->id >= newLayer.id) {
-								layers.insert(layerIterator, newLayer);
-								break;
-							}
+						while (layerIterator != layers.end() && layerIterator->id < newLayer.id) {
 							layerIterator++;
 						}
-						if (layerIterator == layers.end()) {
-							layers.push_back(newLayer);
-						}
+						layers.insert(layerIterator, std::move(newLayer));
 					}
 					//Its a streaming layer!
 					else if (layertype == "streaminglayer") {
-						auto streamTags = l.GetChildren();
-						for (auto streamTag : streamTags) {
-							if (streamTag.GetName() == "streambox") {
+						while (reader.NextChild(contentDepth)) {
+							if (reader.GetName() == "streambox") {
 								MapStreamBox box;
-								auto streamBoxAttributes = streamTag.GetAttributes();
 								box.parent = name;
-								box.streamMap = streamBoxAttributes["map"];
-								box.pos.x = (float)atof(streamBoxAttributes["x"].c_str());
-								box.pos.y = (float)atof(streamBoxAttributes["y"].c_str());
-								box.pos[2] = (float)atof(streamBoxAttributes["w"].c_str());
-								box.pos[3] = (float)atof(streamBoxAttributes["h"].c_str());
-								box.streamPos.x = (float)atof(streamBoxAttributes["sx"].c_str());
-								box.streamPos.y = (float)atof(streamBoxAttributes["sy"].c_str());
-								box.streamPos[2] = (float)atof(streamBoxAttributes["sox"].c_str());
-								box.streamPos[3] = (float)atof(streamBoxAttributes["soy"].c_str());
-								box.isTeleport = streamBoxAttributes["teleport"] == "true";
+								box.streamMap = reader.GetAttribute("map").Str();
+								box.pos.x = reader.GetAttribute("x").ToFloat();
+								box.pos.y = reader.GetAttribute("y").ToFloat();
+								box.pos[2] = reader.GetAttribute("w").ToFloat();
+								box.pos[3] = reader.GetAttribute("h").ToFloat();
+								box.streamPos.x = reader.GetAttribute("sx").ToFloat();
+								box.streamPos.y = reader.GetAttribute("sy").ToFloat();
+								box.streamPos[2] = reader.GetAttribute("sox").ToFloat();
+								box.streamPos[3] = reader.GetAttribute("soy").ToFloat();
+								box.isTeleport = reader.GetAttribute("teleport") == "true";
 								streamBoxes.push_back(box);
 							}
 							else {
-								Env::Out() << "WARNING: unknown Map-streaming tag in map file: " << streamTag.GetName() << "! " << filename << std::endl;
+								Env::Out() << "WARNING: unknown Map-streaming tag in map file: " << reader.GetName() << "! " << filename << std::endl;
 							}
 						}
 					}
 					//clipping clayer (non-walkable areas)
 					else if (layertype == "clippinglayer") {
-						auto clipTags = l.GetChildren();
-						for (auto clipTag : clipTags) {
-							if (clipTag.GetName() == "clipbox") {
+						while (reader.NextChild(contentDepth)) {
+							if (reader.GetName() == "clipbox") {
 								MapClipBox box;
-								box.pos.x = (float)atof(clipTag.GetAttribute("x").c_str());
-								box.pos.y = (float)atof(clipTag.GetAttribute("y").c_str());
-								box.pos[2] = (float)atof(clipTag.GetAttribute("w").c_str());
-								box.pos[3] = (float)atof(clipTag.GetAttribute("h").c_str());
+								box.pos.x = reader.GetAttribute("x").ToFloat();
+								box.pos.y = reader.GetAttribute("y").ToFloat();
+								box.pos[2] = reader.GetAttribute("w").ToFloat();
+								box.pos[3] = reader.GetAttribute("h").ToFloat();
 								clipBoxes.push_back(box);
 							}
 							else {
-								Env::Out() << "WARNING: unknown Map-clipping tag in map file: " << clipTag.GetName() << "! " << filename << std::endl;
+								Env::Out() << "WARNING: unknown Map-clipping tag in map file: " << reader.GetName() << "! " << filename << std::endl;
 							}
 						}
 					}
 					//trigger layer. dont be tumblr here
 					else if (layertype == "triggerlayer") {
-						auto triggerTags = l.GetChildren();
-						for (auto triggerTag : triggerTags) {
-							if (triggerTag.GetName() == "triggerbox") {
+						while (reader.NextChild(contentDepth)) {
+							if (reader.GetName() == "triggerbox") {
 								MapTriggerBox box;
-								box.x = atoi(triggerTag.GetAttribute("x").c_str());
-								box.y = atoi(triggerTag.GetAttribute("y").c_str());
-								box.w = atoi(triggerTag.GetAttribute("w").c_str());
-								box.h = atoi(triggerTag.GetAttribute("h").c_str());
-								box.name = triggerTag.GetAttribute("name");
+								box.x = reader.GetAttribute("x").ToInt();
+								box.y = reader.GetAttribute("y").ToInt();
+								box.w = reader.GetAttribute("w").ToInt();
+								box.h = reader.GetAttribute("h").ToInt();
+								box.name = reader.GetAttribute("name").Str();
 								triggers.push_back(box);
 							}
 						}
 					}
 					//thats not a layer
 					else {
-						Env::Out() << "WARNING: unknown layer tag in map file: " << l.GetName() << "! " << filename << std::endl;
+						Env::Out() << "WARNING: unknown layer tag in map file: " << layertype << "! " << filename << std::endl;
 					}
 				}
 			}
 			//i dont know that part of the map
 			else {
-				Env::Out() << "WARNING: unknown tag in map file: " << c.GetName() << "! " << filename << std::endl;
+				Env::Out() << "WARNING: unknown tag in map file: " << tagname << "! " << filename << std::endl;
 			}
 		}
 		
@@ -202,35 +200,46 @@ namespace Dragon2D
 		tilesize[3] = ceilf(tilesize[3] / res.y)*res.y;
 		tilesize.y = ceilf(tilesize.y / res.y)*res.y;
 
+		//the geometry of the tiles does not change while the map scrolls, build it now
+		for (auto& layer : layers) {
+			for (auto& chunk : layer.tiles.GetChunks()) {
+				_GetMesh(layer, chunk.first, chunk.second);
+			}
+		}
+
 		//Run the mapscript
 		ScriptEngine::RawEval(mapscript);
 	}
 
 	void Map::Render()
 	{
+		//sprites of lower layers are below the map
+		Env::GetSpriteBatch().Flush();
 
-		for (auto layer : layers) {
-			//for each tile
-			for (int y = oy - std::abs(doy); y < height + oy + std::abs(doy); y++) {
-				for (int x = ox - std::abs(dox); x < width + ox + std::abs(dox); x++) {
-					//check if the tile exists
-					auto xiter = layer.tiles.find(x);
-					int tile = layer.defaultId;
-					if (xiter != layer.tiles.end()) {
-						auto yiter = xiter->second.find(y);
-						if (yiter != xiter->second.end()) {
-							tile = yiter->second;
-						}
-					}
-							
-					if (tile != -1) {
-						layer.tileset->SetPosition(Tilepos(x, y));
-						layer.tileset->Render(tile);
-					}
+		//the visible tiles, with the ones scrolling in
+		int x0 = ox - std::abs(dox);
+		int x1 = width + ox + std::abs(dox);
+		int y0 = oy - std::abs(doy);
+		int y1 = height + oy + std::abs(doy);
+		//the meshes are in tiles, the transform puts tile 0, 0 where Tilepos() has it
+		float tw = tilesize[2];
+		float th = tilesize[3];
+		glm::vec4 transform(tilesize.x - ox*tw - mapMovementOffset.x, 1.0f - tilesize.y + oy*th + mapMovementOffset.y, tw, -th);
+
+		//chunks reach over the visible tiles, cut them off there
+		glm::vec2 res = Env::GetResolution();
+		float left = transform.x + x0*tw;
+		float bottom = transform.y - y1*th;
+		glEnable(GL_SCISSOR_TEST);
+		glScissor((GLint)floorf(left*res.x + 0.5f), (GLint)floorf(bottom*res.y + 0.5f), (GLsizei)floorf((x1 - x0)*tw*res.x + 0.5f), (GLsizei)floorf((y1 - y0)*th*res.y + 0.5f));
+		for (auto& layer : layers) {
+			for (int cy = TileGrid::ChunkOf(y0); cy <= TileGrid::ChunkOf(y1 - 1); cy++) {
+				for (int cx = TileGrid::ChunkOf(x0); cx <= TileGrid::ChunkOf(x1 - 1); cx++) {
+					layer.tileset->DrawMesh(_GetMesh(layer, cx, cy), transform);
 				}
 			}
-			layer.tileset->FlushBatched();
 		}
+		glDisable(GL_SCISSOR_TEST);
 
 		BaseClass::Render();
 	}
@@ -324,6 +333,42 @@ namespace Dragon2D
 		return tilepos;
 	}
 
+	void Map::SetTile(int layerId, int x, int y, int id)
+	{
+		for (auto& layer : layers) {
+			if (layer.id == layerId) {
+				if (!layer.tiles.Set(x, y, id)) {
+					Env::Out() << "WARNING: tile id " << id << " too large for map " << name << std::endl;
+					return;
+				}
+				//built again when it is drawn
+				layer.meshes.erase(std::make_pair(TileGrid::ChunkOf(x), TileGrid::ChunkOf(y)));
+				return;
+			}
+		}
+		Env::Out() << "WARNING: map " << name << " has no layer " << layerId << std::endl;
+	}
+
+	TileMesh& Map::_GetMesh(MapLayer& layer, int cx, int cy)
+	{
+		std::shared_ptr<TileMesh>& mesh = layer.meshes[std::make_pair(cx, cy)];
+		if (mesh && layer.tileset->IsMeshCurrent(*mesh)) {
+			return *mesh;
+		}
+		if (!mesh) {
+			mesh.reset(new TileMesh());
+		}
+		const int size = TileGrid::ChunkSize;
+		BatchedTileset& tileset = *layer.tileset;
+		layer.tiles.ForEach(cx*size, cy*size, (cx + 1)*size, (cy + 1)*size, [&tileset](int x, int y, int tile) {
+			if (tile != -1) {
+				tileset.AddMeshTile(tile, x, y);
+			}
+		});
+		tileset.BuildMesh(*mesh);
+		return *mesh;
+	}
+
 	void Map::Move(int x, int y, int ticks)
 	{
 		dox += x;
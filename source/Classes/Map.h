@@ -3,6 +3,7 @@
 #include "BaseClass.h"
 #include "Tileset.h"
 #include "GameObject.h"
+#include "TileGrid.h"
 
 namespace Dragon2D
 {
@@ -40,7 +41,15 @@ namespace Dragon2D
 
 		std::vector<GameObjectPtr> GetObjectsAtPosition(int x, int y) const;
 		bool IsPositionWalkable(int x, int y) const;
+
+		//function: SetTile
+		//note: sets the tile at x, y of the layer with the id layerId. Only the chunk of the tile is built again.
+		virtual void SetTile(int layerId, int x, int y, int id);
 	private:
+		//function: _GetMesh
+		//note: returns the mesh of the chunk cx, cy (a chunk of the TileGrid) of layer, building it if it is missing or outdated
+		TileMesh& _GetMesh(MapLayer& layer, int cx, int cy);
+
 		std::string name;
 		std::list<MapLayer> layers;
 		
@@ -72,6 +81,7 @@ namespace Dragon2D
 		D2DCLASS_SCRIPTINFO_MEMBER(Map, Move)
 		D2DCLASS_SCRIPTINFO_MEMBER(Map, SetMapPosition)
 		D2DCLASS_SCRIPTINFO_MEMBER(Map, GetMapPosition)
+		D2DCLASS_SCRIPTINFO_MEMBER(Map, SetTile)
 	D2DCLASS_SCRIPTINFO_END
 
 	//class: MapLayer
@@ -82,12 +92,12 @@ namespace Dragon2D
 		
 		//var: id. Id of the layer
 		int									id;
-		//var: defaultId. Id of the default layer. if -1 it dosnt have a default tile -> render black
-		int									defaultId;
-		//var: tiles. Holds the layers tiles.
-		std::map<int, std::map<int, int>>	tiles;
+		//var: tiles. Holds the layers tiles. The default id is -1 if the layer doesnt have a default tile -> render black
+		TileGrid							tiles;
 		//var: tileset. Holds the tileset of the layer. 
 		BatchedTilesetPtr					tileset;
+		//var: meshes. The static geometry of the layer, one mesh for each chunk of tiles. Chunks only with default tiles are built when they are first visible.
+		std::map<std::pair<int, int>, std::shared_ptr<TileMesh>>	meshes;
 	};
 
 	//class: MapStreamBox
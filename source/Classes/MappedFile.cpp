@@ -0,0 +1,256 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Dragon2D
+{
+	MappedFile::MappedFile()
+		: data(nullptr), size(0), open(false)
+#ifdef _WIN32
+		, fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#endif
+	{
+
+	}
+
+	MappedFile::MappedFile(const std::string& filename)
+		: data(nullptr), size(0), open(false)
+#ifdef _WIN32
+		, fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#endif
+	{
+		Open(filename);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+#ifdef _WIN32
+		fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle != INVALID_HANDLE_VALUE) {
+			LARGE_INTEGER fileSize;
+			if (GetFileSizeEx(fileHandle, &fileSize)) {
+				size = (std::size_t)fileSize.QuadPart;
+				open = true;
+				if (size == 0) {
+					return true;
+				}
+				mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mappingHandle) {
+					data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+					if (data) {
+						return true;
+					}
+				}
+			}
+			//mapping failed, read it below
+			if (mappingHandle) {
+				CloseHandle(mappingHandle);
+				mappingHandle = nullptr;
+			}
+			CloseHandle(fileHandle);
+			fileHandle = INVALID_HANDLE_VALUE;
+			open = false;
+		}
+#else
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			struct stat info;
+			if (fstat(fd, &info) == 0) {
+				if (S_ISDIR(info.st_mode)) {
+					//folders open fine, but there is nothing to read
+					::close(fd);
+					return false;
+				}
+				size = (std::size_t)info.st_size;
+				open = true;
+				if (size == 0) {
+					::close(fd);
+					return true;
+				}
+				void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				::close(fd);
+				if (mapping != MAP_FAILED) {
+					data = (const char*)mapping;
+					return true;
+				}
+			}
+			else {
+				::close(fd);
+			}
+			open = false;
+		}
+#endif
+		//no mapping. read the file the old way
+		size = 0;
+		std::ifstream infile(filename, std::ios::in | std::ios::binary);
+		if (!infile.is_open()) {
+			return false;
+		}
+		fallback.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+		data = fallback.data();
+		size = fallback.size();
+		open = true;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data && data != fallback.data()) {
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+#else
+			munmap((void*)data, size);
+#endif
+		}
+#ifdef _WIN32
+		if (mappingHandle) {
+			CloseHandle(mappingHandle);
+			mappingHandle = nullptr;
+		}
+		if (fileHandle != INVALID_HANDLE_VALUE) {
+			CloseHandle(fileHandle);
+			fileHandle = INVALID_HANDLE_VALUE;
+		}
+#endif
+		std::vector<char>().swap(fallback);
+		data = nullptr;
+		size = 0;
+		open = false;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return open;
+	}
+
+	const char* MappedFile::GetData() const
+	{
+		return data;
+	}
+
+	std::size_t MappedFile::GetSize() const
+	{
+		return size;
+	}
+
+	bool MappedFile::Stat(const std::string& filename, std::uint64_t& size, std::int64_t& mtime)
+	{
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA info;
+		if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &info)) {
+			return false;
+		}
+		size = ((std::uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+		mtime = (std::int64_t)(((std::uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+#else
+		struct stat info;
+		if (stat(filename.c_str(), &info) != 0) {
+			return false;
+		}
+		size = (std::uint64_t)info.st_size;
+		//nanoseconds where we can get them: a file can be changed more then once a second
+#if defined(__APPLE__)
+		mtime = (std::int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+		mtime = (std::int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#endif
+		return true;
+	}
+
+	namespace
+	{
+		//mappings currently in use, by filename
+		std::mutex sharedMutex;
+		std::map<std::string, std::weak_ptr<const MappedFile>> shared;
+	}
+
+	std::shared_ptr<const MappedFile> MappedFile::Share(const std::string& filename)
+	{
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		auto known = shared.find(filename);
+		if (known != shared.end()) {
+			std::shared_ptr<const MappedFile> mapping = known->second.lock();
+			if (mapping) {
+				return mapping;
+			}
+		}
+		std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(filename);
+		if (!mapping->IsOpen()) {
+			return nullptr;
+		}
+		//forget the files nobody uses anymore, before the map grows with every file ever loaded
+		for (auto s = shared.begin(); s != shared.end();) {
+			if (s->second.expired()) {
+				s = shared.erase(s);
+			}
+			else {
+				s++;
+			}
+		}
+		shared[filename] = mapping;
+		return mapping;
+	}
+
+	void MappedFile::Unshare(const std::string& filename)
+	{
+		//the users of the old mapping keep it, only new ones map the file again
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		shared.erase(filename);
+	}
+
+	bool MappedFile::WriteAtomic(const std::string& filename, const std::vector<std::pair<const void*, std::size_t>>& parts)
+	{
+		std::string tempName = filename + ".tmp";
+		std::FILE* out = std::fopen(tempName.c_str(), "wb");
+		if (!out) {
+			return false;
+		}
+		bool written = true;
+		for (auto& part : parts) {
+			written = written && std::fwrite(part.first, 1, part.second, out) == part.second;
+		}
+		written = std::fclose(out) == 0 && written;
+		if (written) {
+#ifdef _WIN32
+			//rename does not replace files on windows
+			std::remove(filename.c_str());
+#endif
+			written = std::rename(tempName.c_str(), filename.c_str()) == 0;
+		}
+		if (!written) {
+			std::remove(tempName.c_str());
+		}
+		return written;
+	}
+
+	std::uint64_t MappedFile::Hash(const char* data, std::size_t size)
+	{
+		std::uint64_t hash = 14695981039346656037ULL;
+		for (std::size_t i = 0; i < size; i++) {
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+}
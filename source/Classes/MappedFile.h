@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Dragon2D
+{
+	//class: MappedFile
+	//note: Maps a file read-only into memory. Uses mmap (or MapViewOfFile on windows), and reads the file into memory if mapping does not work.
+	//note: The data stays valid until the MappedFile is closed or destroyed. MappedFiles can not be copied, use Share() to get a shared one.
+	class MappedFile
+	{
+	public:
+		//constructor: MappedFile
+		//note: Creates a closed MappedFile
+		MappedFile();
+		//constructor: MappedFile
+		//note: Maps the file "filename". Check IsOpen() to see if that worked.
+		//param:	filename: file to map
+		MappedFile(const std::string& filename);
+		//destructor: ~MappedFile
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//function: Open
+		//note: Maps the file "filename". Closes the file that was open before. Returns false if the file can not be opened.
+		//param:	filename: file to map
+		bool Open(const std::string& filename);
+		//function: Close
+		//note: Unmaps the file
+		void Close();
+
+		//function: IsOpen
+		//note: returns true if a file is mapped. Empty files are open, but have no data.
+		bool IsOpen() const;
+		//function: GetData
+		//note: returns the content of the file
+		const char* GetData() const;
+		//function: GetSize
+		//note: returns the size of the file in bytes
+		std::size_t GetSize() const;
+
+		//function: Stat
+		//note: Gets size and time of last modification of a file without opening it. Returns false if the file does not exist.
+		//param:	filename: file to check
+		//		size: gets the size of the file in bytes
+		//		mtime: gets the time of the last modification. The unit depends on the system, only compare it to other values from Stat.
+		static bool Stat(const std::string& filename, std::uint64_t& size, std::int64_t& mtime);
+
+		//function: Share
+		//note: Returns the mapping of "filename", shared with everyone else who asked for the same file while it is in use. Returns nullptr if the file can not be opened.
+		//note: The file stays mapped until the last std::shared_ptr to it goes away. Thread safe.
+		//note: Writing a mapped file in place (not to a new file that is renamed) makes reading the mapping crash with SIGBUS. Keep mappings of game files only while reading them, and copy what is kept.
+		//param:	filename: file to map
+		static std::shared_ptr<const MappedFile> Share(const std::string& filename);
+		//function: Unshare
+		//note: Makes the next Share() of "filename" map the file again, for files that changed on disk. Thread safe.
+		//param:	filename: file that changed
+		static void Unshare(const std::string& filename);
+
+		//function: WriteAtomic
+		//note: Writes the parts (data and size) one after the other to "filename". The file is written as filename.tmp and renamed, so a crash (or a second instance) never sees half a file. Returns false if it can not be written.
+		static bool WriteAtomic(const std::string& filename, const std::vector<std::pair<const void*, std::size_t>>& parts);
+
+		//function: Hash
+		//note: returns the 64 bit FNV-1a hash of size bytes at data. Used to check if the content of files changed.
+		static std::uint64_t Hash(const char* data, std::size_t size);
+	private:
+		const char* data;
+		std::size_t size;
+		bool open;
+		//var: fallback. holds the content of the file if it could not be mapped
+		std::vector<char> fallback;
+#ifdef _WIN32
+		void* fileHandle;
+		void* mappingHandle;
+#endif
+	};
+}
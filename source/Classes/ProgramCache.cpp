@@ -0,0 +1,42 @@
+#include "ProgramCache.h"
+#include "MappedFile.h"
+
+#include <cstring>
+
+namespace Dragon2D
+{
+	const char* ProgramCache::Extension = ".d2p";
+
+	bool ProgramCache::Load(const std::string& file, std::uint64_t sourceHash, std::uint64_t driverHash, Binary& binary)
+	{
+		std::shared_ptr<MappedFile> cache = std::make_shared<MappedFile>(file + Extension);
+		if (!cache->IsOpen() || cache->GetSize() < sizeof(Header)) {
+			return false;
+		}
+		Header header;
+		std::memcpy(&header, cache->GetData(), sizeof(Header));
+		if (std::memcmp(header.magic, "D2PB", 4) != 0 || header.version != Version || header.sourceHash != sourceHash
+			|| header.driverHash != driverHash || header.binarySize != cache->GetSize() - sizeof(Header)) {
+			return false;
+		}
+		binary.format = header.format;
+		binary.data = cache->GetData() + sizeof(Header);
+		binary.size = (std::size_t)header.binarySize;
+		binary.owner = cache;
+		return true;
+	}
+
+	bool ProgramCache::Save(const std::string& file, std::uint64_t sourceHash, std::uint64_t driverHash, std::uint32_t format, const char* data, std::size_t size)
+	{
+		Header header;
+		std::memcpy(header.magic, "D2PB", 4);
+		header.version = Version;
+		header.sourceHash = sourceHash;
+		header.driverHash = driverHash;
+		header.format = format;
+		header.reserved = 0;
+		header.binarySize = size;
+
+		return MappedFile::WriteAtomic(file + Extension, { { &header, sizeof(Header) }, { data, size } });
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <memory>
+
+namespace Dragon2D
+{
+	//class: ProgramCache
+	//note: Keeps linked shader programs on disk, as the driver gives them with glGetProgramBinary. The program of "shader.glsl" is stored in "shader.glsl.d2p".
+	//note: A binary only fits the driver that made it, so the cache stores hashes of the source and of the driver (vendor, renderer and version). If one of them changed, the program is compiled again.
+	class ProgramCache
+	{
+	public:
+		//const: Extension
+		//note: appended to the name of the source to get the name of the cache
+		static const char* Extension;
+		//const: Version
+		//note: Version of the cache file format. Increase when Header changes, caches with other versions are ignored.
+		static const std::uint32_t Version = 1;
+
+		//class: Binary
+		//note: a program binary. data stays valid as long as owner lives.
+		struct Binary
+		{
+			std::uint32_t format;
+			const char* data;
+			std::size_t size;
+			std::shared_ptr<const void> owner;
+		};
+
+		//function: Load
+		//note: Maps the cache of "file". Returns false if there is none or it was made from another source or by another driver.
+		//param:	file: the shader source
+		//		sourceHash: MappedFile::Hash of the source
+		//		driverHash: hash of the driver strings
+		//		binary: gets the program binary
+		static bool Load(const std::string& file, std::uint64_t sourceHash, std::uint64_t driverHash, Binary& binary);
+		//function: Save
+		//note: Writes the cache of "file". Returns false if it can not be written.
+		static bool Save(const std::string& file, std::uint64_t sourceHash, std::uint64_t driverHash, std::uint32_t format, const char* data, std::size_t size);
+	private:
+		//struct: Header
+		//note: starts every cache file. The binary follows directly.
+		struct Header
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sourceHash;
+			std::uint64_t driverHash;
+			std::uint32_t format;
+			std::uint32_t reserved;
+			std::uint64_t binarySize;
+		};
+	};
+}
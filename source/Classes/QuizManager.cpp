@@ -2,21 +2,29 @@
 #include "Ui.h"
 #include "GameManager.h"
 #include "Audio.h"
+#include "GlyphText.h"
+#include "CachedText.h"
+#include "AudioLatency.h"
 
 namespace Dragon2D
 {
 	D2DCLASS_REGISTER(QuizManager);
+	const int QuizManager::DefaultPrefetchWindow;
+	const int QuizManager::BuzzerChannel;
 
 	std::shared_ptr<NisaBuzzer::BuzzerManager> QuizManager::buzzerManager = std::shared_ptr<NisaBuzzer::BuzzerManager>();
 
 	QuizManager::QuizManager()
-		: name(""), numPlayers(0), curstate(QuizState::STATE_SETUP), lastInput(QuizManageInput::IN_NONE), lastBuzzerinput(NisaBuzzer::BuzzerManager::Event::NUM_EVENTS), triggerdButton(-1), currentQuestion(-1)
+		: name(""), numPlayers(0), curstate(QuizState::STATE_SETUP), lastInput(QuizManageInput::IN_NONE), lastBuzzerinput(NisaBuzzer::BuzzerManager::Event::NUM_EVENTS), triggerdButton(-1), currentQuestion(-1), askedQuestions(0), prefetchWindow(DefaultPrefetchWindow), reloadListener(-1)
 	{
 
 	}
 
 	QuizManager::~QuizManager()
 	{
+		if (reloadListener >= 0) {
+			Env::GetResourceManager().RemoveReloadListener(reloadListener);
+		}
 		//Free the resources
 	//	Env::GetResourceManager().FreeAudioResource("Buzz");
 	}
@@ -29,65 +37,35 @@ namespace Dragon2D
 			std::string port = Env::Setting(gameinit)["comport"];
 			buzzerManager.reset(new NisaBuzzer::BuzzerManager(port));
 			buzzerManager->FullReset();
+			if (AudioLatency::IsEnabled()) {
+				//a digit is a buzzer that was pressed
+				buzzerManager->SetReceiveHandler([](unsigned char c) {
+					if (c >= '0' && c <= '9') {
+						AudioLatency::MarkInput();
+					}
+				});
+			}
 		}
+		//the buzzer sound gets its own channel, so it never waits for a free one
+		Mix_ReserveChannels(BuzzerChannel + 1);
 
 		std::string gameinit = Env::GetGamepath() + "GameInit.txt";
 		maxtries = atoi(Env::Setting(gameinit)["maxtries"].c_str());
+		//the media of the next questions are loaded in the background, the rest waits until they come closer
+		std::string prefetch = Env::Setting(gameinit)["prefetch"];
+		prefetchWindow = prefetch != "" ? std::max(1, atoi(prefetch.c_str())) : DefaultPrefetchWindow;
 		//Load the questions
-		XMLResource& questionResource = Env::GetResourceManager().GetXMLResource(std::string("quiz/") + gamename + ".xml");
-		auto doc = questionResource.GetDocument();
-		for (auto t : doc.GetChildren()) {
-			QuizQuestion newQuestion;
-			if (t.GetName() == "question") {
-				newQuestion.type = QuizQuestion::QUESTION_TEXT;
-				newQuestion.text = t.GetData();
-			}
-			else if (t.GetName() == "multiplechoice") {
-				newQuestion.type = QuizQuestion::QUESTION_MULTIPLE_CHOICE;
-				newQuestion.text = t.GetData();
-				for (auto answer : t.GetChildren()) {
-					if (answer.GetName() == "answer") {
-						newQuestion.answers.push_back(answer.GetData());
-					}
-					else if (answer.GetName() == "rightanswer") {
-						newQuestion.rightAnswer = newQuestion.answers.size();
-						newQuestion.answers.push_back(answer.GetData());
-					}
-				}
-			}
-			else if (t.GetName() == "image") {
-				newQuestion.type = QuizQuestion::QUESTION_IMAGEBASE;
-				newQuestion.text = t.GetData();
-				auto answers = t.GetChildren();
-				newQuestion.imageQuestion = t.GetAttribute("questionImage");
-				newQuestion.imageSolution = t.GetAttribute("solutionImage");
-				Env::GetResourceManager().RequestTextureResource(newQuestion.imageQuestion);
-				Env::GetResourceManager().RequestTextureResource(newQuestion.imageSolution);
-
-				if (answers.size() == 1 && answers[0].GetName()=="answer") {
-					newQuestion.answers.push_back(answers[0].GetData());
-					newQuestion.rightAnswer = 0;
-				}
-				else {
-					continue;
+		_ReadQuestions(questions);
+		_Prefetch();
+		//the quiz file is read again when it changes (if the ResourceManager watches the files)
+		if (reloadListener < 0) {
+			reloadListener = Env::GetResourceManager().AddReloadListener([this](const std::string& file) {
+				if (file == "quiz/" + name + ".xml") {
+					_ReloadQuestions();
 				}
-			}
-			else {
-				continue;
-			}
-			newQuestion.points = atoi(t.GetAttribute("points").c_str());
-			newQuestion.audioName = t.GetAttribute("audio");
-			newQuestion.imageName = t.GetAttribute("imagename");
-			if (newQuestion.audioName != "") {
-				Env::GetResourceManager().RequestAudioResource(newQuestion.audioName);
-			}
-			if (newQuestion.imageName != "") {
-				Env::GetResourceManager().RequestTextureResource(newQuestion.imageName);
-			}
-			questions.push(newQuestion);
+			});
 		}
 
-
 		//Ask for the music
 		Env::GetResourceManager().RequestAudioResource("Buzz");
 
@@ -116,6 +94,96 @@ namespace Dragon2D
 		SwitchUI();
 	}
 
+	void QuizManager::_ReadQuestions(std::deque<QuizQuestion>& out)
+	{
+		//They are read tag by tag, straight into the question queue. Nothing is requested here, see _Prefetch()
+		std::string indata;
+		Env::ReadGamefile("quiz/" + name + ".xml", indata);
+		HoardXML::Reader reader(indata.data(), indata.size());
+		while (reader.NextChild(0)) {
+			QuizQuestion newQuestion;
+			HoardXML::StringRef tagname = reader.GetName();
+			std::size_t questionDepth = reader.GetDepth();
+			//attributes are only there at the start of the tag
+			newQuestion.points = reader.GetAttribute("points").ToInt();
+			newQuestion.audioName = reader.GetAttribute("audio").Str();
+			newQuestion.imageName = reader.GetAttribute("imagename").Str();
+			if (tagname == "question") {
+				newQuestion.type = QuizQuestion::QUESTION_TEXT;
+				newQuestion.text = reader.ReadData();
+			}
+			else if (tagname == "multiplechoice" || tagname == "image") {
+				bool isImage = tagname == "image";
+				if (isImage) {
+					newQuestion.type = QuizQuestion::QUESTION_IMAGEBASE;
+					newQuestion.imageQuestion = reader.GetAttribute("questionImage").Str();
+					newQuestion.imageSolution = reader.GetAttribute("solutionImage").Str();
+				}
+				else {
+					newQuestion.type = QuizQuestion::QUESTION_MULTIPLE_CHOICE;
+				}
+				//the question text is the data around the answers
+				int children = 0;
+				int plainAnswers = 0;
+				while (reader.Next() != HoardXML::Reader::EVENT_END_DOCUMENT) {
+					if (reader.GetDepth() == questionDepth && reader.GetEvent() == HoardXML::Reader::EVENT_TEXT) {
+						newQuestion.text.append(reader.GetValue().Data(), reader.GetValue().Size());
+					}
+					else if (reader.GetDepth() == questionDepth && reader.GetEvent() == HoardXML::Reader::EVENT_END_TAG) {
+						break;
+					}
+					else if (reader.GetDepth() == questionDepth + 1 && reader.GetEvent() == HoardXML::Reader::EVENT_START_TAG) {
+						children++;
+						if (reader.GetName() == "answer") {
+							plainAnswers++;
+							newQuestion.answers.push_back(reader.ReadData());
+						}
+						else if (reader.GetName() == "rightanswer") {
+							newQuestion.rightAnswer = newQuestion.answers.size();
+							newQuestion.answers.push_back(reader.ReadData());
+						}
+						else {
+							reader.SkipTag();
+						}
+					}
+				}
+				HoardXML::Reader::CleanData(newQuestion.text);
+				//image questions have exactly one answer, and that is the right one
+				if (isImage) {
+					if (children != 1 || plainAnswers != 1) {
+						continue;
+					}
+					newQuestion.rightAnswer = 0;
+				}
+			}
+			else {
+				continue;
+			}
+			out.push_back(newQuestion);
+		}
+	}
+
+	void QuizManager::_ReloadQuestions()
+	{
+		std::deque<QuizQuestion> reloaded;
+		_ReadQuestions(reloaded);
+		//a question that is asked right now is not changed under the players
+		bool asking = curstate != STATE_SETUP && curstate != STATE_POINT_DISPLAY && curstate != STATE_SHOW_WINNER && !questions.empty();
+		int skip = askedQuestions + (asking ? 1 : 0);
+		reloaded.erase(reloaded.begin(), reloaded.begin() + std::min<std::size_t>(skip, reloaded.size()));
+		if (asking) {
+			reloaded.push_front(questions.front());
+			questions.pop_front();
+		}
+		//the new questions request their media below, before the old ones let go of theirs. Unchanged media stay loaded
+		questions.swap(reloaded);
+		_Prefetch();
+		for (auto& question : reloaded) {
+			FreeResources(question);
+		}
+		Env::Out() << "Reloaded quiz " << name << ", " << questions.size() << " questions left" << std::endl;
+	}
+
 	void QuizManager::Update()
 	{
 		buzzerManager->Update();
@@ -130,7 +198,12 @@ namespace Dragon2D
 			}
 			curstate = STATE_POINT_DISPLAY;
 			if (!questions.empty()) {
-				questions.pop();
+				//the question is done, its images and music can be unloaded when the memory is needed
+				FreeResources(questions.front());
+				questions.pop_front();
+				askedQuestions++;
+				//the next question moves into the window
+				_Prefetch();
 			}
 			SwitchUI(); 
 		case Dragon2D::QuizManager::STATE_POINT_DISPLAY:
@@ -159,7 +232,8 @@ namespace Dragon2D
 			}
 			else if (lastBuzzerinput == NisaBuzzer::BuzzerManager::Event::EVENT_TRIGGER) {
 				if (lastBuzzerinputParam <= numPlayers) {
-					Music("Buzz").Play(0, 0);
+					Music("Buzz").PlayOnChannel(BuzzerChannel, 0, 0);
+					AudioLatency::Watch(BuzzerChannel);
 					curstate = STATE_QUESTION_CHECKANSWER;
 					SwitchUI();
 				}
@@ -287,7 +361,13 @@ namespace Dragon2D
 		InputEventFunction undoevent = [this](bool pressed) { 
 			if (pressed&&this->undoSave) {
 				auto ptr = std::dynamic_pointer_cast<QuizManager>(this->Ptr());
+				//the restored questions hold no requests: the new window requests first, so unchanged media stay loaded, then the old one lets go
+				std::deque<QuizQuestion> previous = this->questions;
 				this->undoSave->Save(ptr);
+				this->_Prefetch();
+				for (auto& question : previous) {
+					this->FreeResources(question);
+				}
 				this->SwitchUI();
 			}
 			std::cout << "BLAAA" << std::endl;
@@ -320,6 +400,26 @@ namespace Dragon2D
 		if (!curui) {
 			curui = NewD2DObject<Ui>();
 			curui->Load("quizui");
+			//the scores change after every question: drawn from the glyph atlas, that only costs new vertices
+			for (auto screen : { "pointscreen", "pointscreen_inline" }) {
+				auto element = curui->GetLoader().GetElementById(screen);
+				for (int i = 0; element && i < 4; i++) {
+					GlyphText::Replace(element->GetElementById("p" + std::to_string(i) + "p"));
+				}
+			}
+			//all other texts are set again on every switch, mostly to what they show already. Cached, they are only rendered when they are new
+			std::vector<std::pair<std::string, std::string>> cachedTexts = {
+				{ "pointscreen", "round" }, { "pointscreen", "p0n" }, { "pointscreen", "p1n" }, { "pointscreen", "p2n" }, { "pointscreen", "p3n" },
+				{ "questionbase", "questionText" }, { "questionbase", "answer0" }, { "questionbase", "answer1" }, { "questionbase", "answer2" }, { "questionbase", "answer3" },
+				{ "imagequestionbase", "questionText" }, { "imagequestionbase", "questionAnswer" }, { "checkquestionbase", "buzzerPlayer" },
+				{ "winnerscreen", "winnername" }, { "winnerscreen", "place2" }, { "winnerscreen", "place3" }, { "winnerscreen", "place4" }
+			};
+			for (auto& text : cachedTexts) {
+				auto element = curui->GetLoader().GetElementById(text.first);
+				if (element) {
+					CachedText::Replace(element->GetElementById(text.second));
+				}
+			}
 		}
 		//hide all and load the right one for curstate IF all do exist
 		auto pointscreen = curui->GetLoader().GetElementById("pointscreen");
@@ -379,6 +479,8 @@ namespace Dragon2D
 				}
 				if (questions.front().type == QuizQuestion::QUESTION_IMAGEBASE || questions.front().type == QuizQuestion::QUESTION_HIDDENIMAGE) {				
 					auto i = imagequestionbase->GetElementById("qimage");
+					//the image is set only once, so it must not be the placeholder
+					Env::GetResourceManager().FinishTextureResource(questions.front().imageQuestion);
 					dynamic_cast<TailTipUI::Image*>(i)->SetImage(Env::GetResourceManager().GetTextureResource(questions.front().imageQuestion).GetTextureId(), false);
 					imagequestionbase->GetElementById("questionText")->SetName(questions.front().text);
 					imagequestionbase->GetElementById("questionAnswer")->SetHidden(true);
@@ -404,6 +506,7 @@ namespace Dragon2D
 
 				if (questions.front().type == QuizQuestion::QUESTION_IMAGEBASE || questions.front().type == QuizQuestion::QUESTION_HIDDENIMAGE) {
 					auto i = imagequestionbase->GetElementById("qimage");
+					Env::GetResourceManager().FinishTextureResource(questions.front().imageSolution);
 					dynamic_cast<TailTipUI::Image*>(i)->SetImage(Env::GetResourceManager().GetTextureResource(questions.front().imageSolution).GetTextureId(), false);
 					imagequestionbase->GetElementById("questionText")->SetName(questions.front().text);
 					imagequestionbase->GetElementById("questionAnswer")->SetName(questions.front().answers[0]);
@@ -452,6 +555,46 @@ namespace Dragon2D
 		}
 	}
 
+	void QuizManager::_Prefetch()
+	{
+		for (std::size_t i = 0; i < questions.size() && i < std::size_t(prefetchWindow); i++) {
+			QuizQuestion& question = questions[i];
+			if (question.requested) {
+				continue;
+			}
+			//requests return at once, the loader threads decode while the current question is played
+			if (question.audioName != "") {
+				Env::GetResourceManager().RequestAudioResource(question.audioName);
+			}
+			if (question.imageName != "") {
+				Env::GetResourceManager().RequestTextureResource(question.imageName);
+			}
+			if (question.type == QuizQuestion::QUESTION_IMAGEBASE) {
+				Env::GetResourceManager().RequestTextureResource(question.imageQuestion);
+				Env::GetResourceManager().RequestTextureResource(question.imageSolution);
+			}
+			question.requested = true;
+		}
+	}
+
+	void QuizManager::FreeResources(QuizQuestion& question)
+	{
+		if (!question.requested) {
+			return;
+		}
+		question.requested = false;
+		if (question.audioName != "") {
+			Env::GetResourceManager().FreeAudioResource(question.audioName);
+		}
+		if (question.imageName != "") {
+			Env::GetResourceManager().FreeTextureResource(question.imageName);
+		}
+		if (question.type == QuizQuestion::QUESTION_IMAGEBASE) {
+			Env::GetResourceManager().FreeTextureResource(question.imageQuestion);
+			Env::GetResourceManager().FreeTextureResource(question.imageSolution);
+		}
+	}
+
 	void QuizManager::Save(QuizManagerPtr &dst)
 	{
 		if (!dst) {
@@ -470,7 +613,13 @@ namespace Dragon2D
 		dst->buzzerEventHandler = buzzerEventHandler;
 		dst->triggerdButton = triggerdButton;
 		dst->questions = questions;
+		//requests belong to the live questions, not to a copy of them
+		for (auto& question : dst->questions) {
+			question.requested = false;
+		}
 		dst->currentQuestion = currentQuestion;
+		dst->askedQuestions = askedQuestions;
+		dst->prefetchWindow = prefetchWindow;
 		dst->maxtries = maxtries;
 		dst->triesLeft = triesLeft;
 	}
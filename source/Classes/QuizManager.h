@@ -12,6 +12,8 @@ namespace Dragon2D
 	class QuizQuestion
 	{
 	public:
+		QuizQuestion() : type(QUESTION_TEXT), points(0), rightAnswer(0), requested(false) {}
+
 		enum QuestionType {
 			QUESTION_TEXT,
 			QUESTION_MULTIPLE_CHOICE,
@@ -31,6 +33,9 @@ namespace Dragon2D
 
 		std::vector<std::string> answers;
 		int rightAnswer;
+
+		//var: requested. true while the question holds requests on its media, see QuizManager::_Prefetch()
+		bool requested;
 	};
 
 	class QuestionHideimageHelper
@@ -53,6 +58,13 @@ namespace Dragon2D
 	D2DCLASS(QuizManager, public BaseClass)
 	{
 	public:
+		//const: DefaultPrefetchWindow
+		//note: number of questions (the current one included) whose media are loaded, if GameInit.txt has no "prefetch"
+		static const int DefaultPrefetchWindow = 3;
+		//const: BuzzerChannel
+		//note: the mixer channel reserved for the buzzer sound
+		static const int BuzzerChannel = 0;
+
 		QuizManager();
 		~QuizManager();
 
@@ -112,8 +124,15 @@ namespace Dragon2D
 
 		int triggerdButton;
 
-		std::queue<QuizQuestion> questions;
+		//var: questions. the questions that are left, the current one first
+		std::deque<QuizQuestion> questions;
 		int currentQuestion;
+		//var: askedQuestions. number of questions that were done, for _ReloadQuestions()
+		int askedQuestions;
+		//var: prefetchWindow. number of questions that hold their media, see _Prefetch()
+		int prefetchWindow;
+		//var: reloadListener. id of the reload listener for the quiz file, -1 before Load()
+		int reloadListener;
 
 		int maxtries;
 		int triesLeft;
@@ -121,7 +140,21 @@ namespace Dragon2D
 		QuizManagerPtr undoSave;
 	protected:
 		void SwitchUI();
+		//function: Save
+		//note: copies the state to dst. The copied questions hold no media requests, after restoring the live one has to call _Prefetch()
 		void Save(QuizManagerPtr &dst);
+		//function: FreeResources
+		//note: frees the media a question requested in _Prefetch()
+		void FreeResources(QuizQuestion& question);
+		//function: _Prefetch
+		//note: requests the media of the first prefetchWindow questions that did not request them yet. They load in the background while the current question is played.
+		void _Prefetch();
+		//function: _ReadQuestions
+		//note: reads the questions of the quiz file into out. Their media are not requested yet.
+		void _ReadQuestions(std::deque<QuizQuestion>& out);
+		//function: _ReloadQuestions
+		//note: Reads the quiz file again after it changed. Questions that were asked stay done, the question that is asked right now stays as it is.
+		void _ReloadQuestions();
 	};
 
 	D2DCLASS_SCRIPTINFO_BEGIN(QuizManager, BaseClass)
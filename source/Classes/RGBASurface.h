@@ -0,0 +1,17 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+namespace Dragon2D
+{
+	//function: ConvertToRGBA
+	//note: Returns a copy of surface with the bytes in memory in the order R, G, B, A (the GL_RGBA, GL_UNSIGNED_BYTE upload format) on every byte order. nullptr if SDL can not convert it. Free it with SDL_FreeSurface().
+	inline SDL_Surface* ConvertToRGBA(SDL_Surface* surface)
+	{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		return SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+#else
+		return SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ABGR8888, 0);
+#endif
+	}
+}
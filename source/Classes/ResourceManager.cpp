@@ -1,5 +1,12 @@
 ﻿#include "ResourceManager.h"
 #include "Env.h"
+#include "XMLCache.h"
+#include "MappedFile.h"
+#include "RGBASurface.h"
+#include "AudioStream.h"
+
+#include <cctype>
+#include <set>
 
 namespace Dragon2D {
 
@@ -8,14 +15,60 @@ ResourceManager* ResourceManager::ActiveManager = nullptr;
 
 
 
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager(int loaderThreads)
+	: trimNeeded(false), nextListenerId(0)
 {
 	Env::Out() << "Init ResourceManager" << std::endl;
 	if (ActiveManager != nullptr) {
 		throw ResourceManagerException("Cannot create more then one instance of ResouceManager!");
 	}
 	ActiveManager = this;
-	//Load all .db files
+	//the pack has all files in its index, so the .db files are only needed without it
+	if (pack.Open(Env::GetGamepath() + ResourcePack::FileName)) {
+		Env::Out() << "Filling dbs with the " << pack.GetFileCount() << " files in " << ResourcePack::FileName << "..." << std::endl;
+		_LoadDbsFromPack();
+	}
+	else {
+		_LoadDbFiles();
+	}
+
+	TextureResource::CreatePlaceholder();
+	GLProgramResource::DetectDriver();
+	atlas = std::make_shared<TextureAtlas>();
+	textCache = std::make_shared<TextCache>();
+	AudioResource::CreateFallback();
+	//missing resources of all types get one shared invalid resource
+	audioResources.SetFallback(std::make_shared<AudioResource>());
+	videoResources.SetFallback(std::make_shared<VideoResource>());
+	textureResources.SetFallback(std::make_shared<TextureResource>());
+	XMLResources.SetFallback(std::make_shared<XMLResource>());
+	fontResources.SetFallback(std::make_shared<FontResource>());
+	glProgramResources.SetFallback(std::make_shared<GLProgramResource>());
+	mapResources.SetFallback(std::make_shared<MapResource>());
+	textResources.SetFallback(std::make_shared<TextResource>());
+	loader = std::make_shared<ResourceLoader>(loaderThreads);
+	Env::Out() << "Started " << loader->GetThreadCount() << " loader threads" << std::endl;
+	Env::Out() << "Done!" << std::endl;
+}
+
+ResourceManager::~ResourceManager()
+{
+	//stop the loader threads before anything they use goes away
+	loader.reset();
+	watcher.reset();
+	for (auto& reload : reloads) {
+		delete reload.resource;
+	}
+	reloads.clear();
+	TextureResource::DeletePlaceholder();
+	atlas.reset();
+	textCache.reset();
+	AudioResource::DeleteFallback();
+	ActiveManager = nullptr;
+}
+
+void ResourceManager::_LoadDbFiles()
+{
 	Env::Out() << "Loading Db files..." << std::endl;
 	std::fstream audioDbFile;
 	Env::Gamefile("audio/audio.db", std::ios::in, audioDbFile);
@@ -68,12 +121,287 @@ ResourceManager::ResourceManager()
 	glProgramDb = _LoadDbIntoMap(glProgramDbFileString, "shader/");
 	mapDb = _LoadDbIntoMap(mapDbFileString, "map/");
 	textDb = _LoadDbIntoMap(textDbFileString, "text/");
-	Env::Out() << "Done!" << std::endl;
 }
 
-ResourceManager::~ResourceManager()
+void ResourceManager::_LoadDbsFromPack()
 {
-	ActiveManager = nullptr;
+	std::map<std::string, std::map<std::string, std::string>*> dbs = {
+		{ "audio", &audioDb }, { "video", &videoDb }, { "texture", &textureDb }, { "script", &scriptDb },
+		{ "font", &fontDb }, { "shader", &glProgramDb }, { "map", &mapDb }, { "text", &textDb } };
+	for (std::size_t i = 0; i < pack.GetFileCount(); i++) {
+		//paths are folder/name.ending, like the entries of the .db files
+		std::string path = pack.GetPath(i);
+		std::size_t slash = path.find('/');
+		if (slash == std::string::npos) {
+			continue;
+		}
+		auto db = dbs.find(path.substr(0, slash));
+		std::string fileName = path.substr(slash + 1);
+		std::size_t cacheSize = std::string(XMLCache::Extension).size();
+		bool isCache = fileName.size() > cacheSize && fileName.compare(fileName.size() - cacheSize, cacheSize, XMLCache::Extension) == 0;
+		if (db == dbs.end() || isCache) {
+			continue;
+		}
+		(*db->second)[fileName.substr(0, fileName.find('.'))] = path;
+	}
+}
+
+const ResourcePack& ResourceManager::GetPack() const
+{
+	return pack;
+}
+
+TextureAtlas& ResourceManager::GetAtlas()
+{
+	return *atlas;
+}
+
+TextCache& ResourceManager::GetTextCache()
+{
+	return *textCache;
+}
+
+std::uint64_t ResourceManager::GetTextCacheHits()
+{
+	return textCache->GetHits();
+}
+
+std::uint64_t ResourceManager::GetTextCacheMisses()
+{
+	return textCache->GetMisses();
+}
+
+std::size_t ResourceManager::GetTextCacheMemory()
+{
+	return textCache->GetMemorySize();
+}
+
+void ResourceManager::Update()
+{
+	//new resources might push a type over its budget, too
+	if (loader->Update() > 0) {
+		trimNeeded = true;
+	}
+	if (watcher) {
+		//only what the system collected since the last frame, nothing waits here
+		std::vector<std::string> changed;
+		watcher->Poll(changed);
+		for (auto& file : changed) {
+			Reload(file);
+		}
+	}
+	if (!reloads.empty()) {
+		_UpdateReloads();
+	}
+	//streams that played their last loop give their channel back
+	AudioStream::Update();
+	if (trimNeeded) {
+		trimNeeded = false;
+		_TrimResources();
+	}
+}
+
+void ResourceManager::WatchFiles(bool watch)
+{
+	if (!watch) {
+		watcher.reset();
+		return;
+	}
+	//the files of a pack do not change
+	if (watcher || pack.IsOpen()) {
+		return;
+	}
+	watcher = std::make_shared<FileWatcher>();
+	if (!watcher->Watch(Env::GetGamepath())) {
+		Env::Err() << "WARNING: Cannot watch " << Env::GetGamepath() << " for changed files" << std::endl;
+		watcher.reset();
+		return;
+	}
+	Env::Out() << "Watching " << Env::GetGamepath() << " for changed files" << std::endl;
+}
+
+bool ResourceManager::IsWatchingFiles() const
+{
+	return watcher != nullptr;
+}
+
+void ResourceManager::Reload(std::string file)
+{
+	//resources that map the file right now keep the old content, new ones have to map it again
+	MappedFile::Unshare(Env::GetGamepath() + file);
+	for (const char* extension : { XMLCache::Extension, TextureCache::Extension, ProgramCache::Extension }) {
+		std::size_t length = std::string(extension).size();
+		if (file.size() > length && file.compare(file.size() - length, length, extension) == 0) {
+			//written by the resources themselves
+			return;
+		}
+	}
+	_AddFile(file);
+	bool reloading = _ReloadGeneralResource(file, textureResources);
+	reloading = _ReloadGeneralResource(file, XMLResources) || reloading;
+	reloading = _ReloadGeneralResource(file, glProgramResources) || reloading;
+	reloading = _ReloadGeneralResource(file, textResources) || reloading;
+	if (reloading) {
+		Env::Out() << "Reloading " << file << std::endl;
+	}
+	else {
+		_NotifyReload(file);
+	}
+}
+
+void ResourceManager::_UpdateReloads()
+{
+	std::set<std::string> replaced;
+	for (auto reload = reloads.begin(); reload != reloads.end();) {
+		if (reload->replace()) {
+			replaced.insert(reload->file);
+			reload = reloads.erase(reload);
+		}
+		else {
+			reload++;
+		}
+	}
+	//a file can have more then one resource, the listeners hear of it once all are done
+	for (auto& file : replaced) {
+		if (std::none_of(reloads.begin(), reloads.end(), [&file](const PendingReload& r) { return r.file == file; })) {
+			_NotifyReload(file);
+		}
+	}
+}
+
+void ResourceManager::_AddFile(const std::string& file)
+{
+	std::map<std::string, std::map<std::string, std::string>*> dbs = {
+		{ "audio", &audioDb }, { "video", &videoDb }, { "texture", &textureDb }, { "script", &scriptDb },
+		{ "font", &fontDb }, { "shader", &glProgramDb }, { "map", &mapDb }, { "text", &textDb } };
+	std::size_t slash = file.find('/');
+	if (slash == std::string::npos) {
+		return;
+	}
+	auto db = dbs.find(file.substr(0, slash));
+	if (db == dbs.end()) {
+		return;
+	}
+	//named like in the .db files: the file name up to the first dot, without folders
+	std::string fileName = file.substr(file.rfind('/') + 1);
+	std::string name = fileName.substr(0, fileName.find('.'));
+	if (db->second->count(name) == 0) {
+		(*db->second)[name] = file;
+		//it might have been looked for before
+		ClearMissingResources();
+	}
+}
+
+void ResourceManager::_NotifyReload(const std::string& file)
+{
+	//a copy: listeners may remove themselves (or others)
+	std::map<int, ReloadListener> listeners = reloadListeners;
+	for (auto& listener : listeners) {
+		listener.second(file);
+	}
+}
+
+void ResourceManager::_Replace(Resource* newRes, Resource* oldRes)
+{
+	newRes->Replace(*oldRes);
+}
+
+int ResourceManager::AddReloadListener(ReloadListener listener)
+{
+	reloadListeners[nextListenerId] = listener;
+	return nextListenerId++;
+}
+
+void ResourceManager::RemoveReloadListener(int id)
+{
+	reloadListeners.erase(id);
+}
+
+void ResourceManager::_TrimResources()
+{
+	_TrimGeneralResources("audio", audioResources);
+	_TrimGeneralResources("video", videoResources);
+	_TrimGeneralResources("texture", textureResources);
+	_TrimGeneralResources("xml", XMLResources);
+	_TrimGeneralResources("font", fontResources);
+	_TrimGeneralResources("shader", glProgramResources);
+	_TrimGeneralResources("map", mapResources);
+	_TrimGeneralResources("text", textResources);
+}
+
+std::size_t ResourceManager::GetMemoryUsage(std::string type)
+{
+	if (type == "audio") return _GetGeneralMemoryUsage(audioResources, false);
+	if (type == "video") return _GetGeneralMemoryUsage(videoResources, false);
+	if (type == "texture") return _GetGeneralMemoryUsage(textureResources, false);
+	if (type == "xml") return _GetGeneralMemoryUsage(XMLResources, false);
+	if (type == "font") return _GetGeneralMemoryUsage(fontResources, false);
+	if (type == "shader") return _GetGeneralMemoryUsage(glProgramResources, false);
+	if (type == "map") return _GetGeneralMemoryUsage(mapResources, false);
+	if (type == "text") return _GetGeneralMemoryUsage(textResources, false);
+	return 0;
+}
+
+std::size_t ResourceManager::GetUnusedMemoryUsage(std::string type)
+{
+	if (type == "audio") return _GetGeneralMemoryUsage(audioResources, true);
+	if (type == "video") return _GetGeneralMemoryUsage(videoResources, true);
+	if (type == "texture") return _GetGeneralMemoryUsage(textureResources, true);
+	if (type == "xml") return _GetGeneralMemoryUsage(XMLResources, true);
+	if (type == "font") return _GetGeneralMemoryUsage(fontResources, true);
+	if (type == "shader") return _GetGeneralMemoryUsage(glProgramResources, true);
+	if (type == "map") return _GetGeneralMemoryUsage(mapResources, true);
+	if (type == "text") return _GetGeneralMemoryUsage(textResources, true);
+	return 0;
+}
+
+std::uint64_t ResourceManager::GetFallbackCount(std::string type)
+{
+	if (type == "audio") return audioResources.GetFallbackCount();
+	if (type == "video") return videoResources.GetFallbackCount();
+	if (type == "texture") return textureResources.GetFallbackCount();
+	if (type == "xml") return XMLResources.GetFallbackCount();
+	if (type == "font") return fontResources.GetFallbackCount();
+	if (type == "shader") return glProgramResources.GetFallbackCount();
+	if (type == "map") return mapResources.GetFallbackCount();
+	if (type == "text") return textResources.GetFallbackCount();
+	return 0;
+}
+
+void ResourceManager::ClearMissingResources()
+{
+	audioResources.ClearMissing();
+	videoResources.ClearMissing();
+	textureResources.ClearMissing();
+	XMLResources.ClearMissing();
+	fontResources.ClearMissing();
+	glProgramResources.ClearMissing();
+	mapResources.ClearMissing();
+	textResources.ClearMissing();
+}
+
+bool ResourceManager::_Exists(const std::string& file) const
+{
+	std::uint64_t size;
+	std::int64_t mtime;
+	return pack.Contains(file) || MappedFile::Stat(Env::GetGamepath() + file, size, mtime);
+}
+
+std::size_t ResourceManager::GetMemoryBudget(std::string type)
+{
+	auto budget = budgets.find(type);
+	return budget == budgets.end() ? DefaultMemoryBudget : budget->second;
+}
+
+void ResourceManager::SetMemoryBudget(std::string type, std::size_t bytes)
+{
+	budgets[type] = bytes;
+	trimNeeded = true;
+}
+
+void ResourceManager::FinishTextureResource(std::string name)
+{
+	_GetGeneralResource<TextureResource>(name, textureDb, textureResources, true);
 }
 
 void ResourceManager::RequestAudioResource(std::string name)
@@ -201,7 +529,8 @@ VideoResource& ResourceManager::GetVideoResource(std::string name)
 
 TextureResource& ResourceManager::GetTextureResource(std::string name)
 {
-	return _GetGeneralResource<TextureResource>(name, textureDb, textureResources);
+	//textures have a placeholder, so no need to wait for them
+	return _GetGeneralResource<TextureResource>(name, textureDb, textureResources, false);
 }
 
 XMLResource& ResourceManager::GetXMLResource(std::string name)
@@ -229,6 +558,36 @@ TextResource& ResourceManager::GetTextResource(std::string name)
 	return _GetGeneralResource<TextResource>(name, textDb, textResources);
 }
 
+ResourceHandle<TextureResource> ResourceManager::GetTextureHandle(std::string name)
+{
+	return textureResources.Intern(name);
+}
+
+ResourceHandle<FontResource> ResourceManager::GetFontHandle(std::string name)
+{
+	return fontResources.Intern(name);
+}
+
+ResourceHandle<GLProgramResource> ResourceManager::GetGLProgramHandle(std::string name)
+{
+	return glProgramResources.Intern(name);
+}
+
+TextureResource& ResourceManager::Get(ResourceHandle<TextureResource> handle)
+{
+	return _GetHandleResource(handle, textureDb, textureResources, false);
+}
+
+FontResource& ResourceManager::Get(ResourceHandle<FontResource> handle)
+{
+	return _GetHandleResource(handle, fontDb, fontResources);
+}
+
+GLProgramResource& ResourceManager::Get(ResourceHandle<GLProgramResource> handle)
+{
+	return _GetHandleResource(handle, glProgramDb, glProgramResources);
+}
+
 
 std::map<std::string, std::string> ResourceManager::_LoadDbIntoMap(std::string FileString, std::string resFolder)
 {
@@ -250,6 +609,131 @@ std::map<std::string, std::string> ResourceManager::_LoadDbIntoMap(std::string F
 
 
 
+//ResourceLoader
+ResourceLoader::ResourceLoader(int threads)
+	: stopWorkers(false)
+{
+	if (threads <= 0) {
+		//leave one core for the main thread
+		threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+	for (int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(&ResourceLoader::_WorkerMain, this));
+	}
+}
+
+ResourceLoader::~ResourceLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopWorkers = true;
+	}
+	queueCondition.notify_all();
+	for (auto& w : workers) {
+		w.join();
+	}
+}
+
+int ResourceLoader::GetThreadCount() const
+{
+	return (int)workers.size();
+}
+
+int ResourceLoader::Update()
+{
+	std::vector<Resource*> decoded;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		decoded.swap(finalizeQueue);
+	}
+	for (Resource* r : decoded) {
+		_Finalize(r);
+	}
+	return (int)decoded.size();
+}
+
+void ResourceLoader::_WorkerMain()
+{
+	for (;;) {
+		Resource* resource = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this]() { return stopWorkers || !decodeQueue.empty(); });
+			if (stopWorkers) {
+				return;
+			}
+			resource = decodeQueue.front();
+			decodeQueue.pop_front();
+		}
+		bool decoded = resource->Decode();
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			resource->state = decoded ? RESOURCE_DECODED : RESOURCE_FAILED;
+			finalizeQueue.push_back(resource);
+		}
+		decodedCondition.notify_all();
+	}
+}
+
+void ResourceLoader::Enqueue(Resource* resource)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		decodeQueue.push_back(resource);
+	}
+	queueCondition.notify_one();
+}
+
+void ResourceLoader::Finish(Resource* resource)
+{
+	if (resource->GetState() == RESOURCE_READY || resource->GetState() == RESOURCE_FAILED) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		auto queued = std::find(decodeQueue.begin(), decodeQueue.end(), resource);
+		if (queued != decodeQueue.end()) {
+			//no loader thread got it yet. Faster to do it here then to wait for the rest of the queue
+			decodeQueue.erase(queued);
+			lock.unlock();
+			bool decoded = resource->Decode();
+			lock.lock();
+			resource->state = decoded ? RESOURCE_DECODED : RESOURCE_FAILED;
+		}
+		else {
+			decodedCondition.wait(lock, [resource]() { return resource->GetState() != RESOURCE_PENDING; });
+			finalizeQueue.erase(std::remove(finalizeQueue.begin(), finalizeQueue.end(), resource), finalizeQueue.end());
+		}
+	}
+	_Finalize(resource);
+}
+
+void ResourceLoader::Cancel(Resource* resource)
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+	auto queued = std::find(decodeQueue.begin(), decodeQueue.end(), resource);
+	if (queued != decodeQueue.end()) {
+		decodeQueue.erase(queued);
+		return;
+	}
+	//pending but not queued: a loader thread decodes it right now
+	decodedCondition.wait(lock, [resource]() { return resource->GetState() != RESOURCE_PENDING; });
+	finalizeQueue.erase(std::remove(finalizeQueue.begin(), finalizeQueue.end(), resource), finalizeQueue.end());
+}
+
+void ResourceLoader::_Finalize(Resource* resource)
+{
+	if (resource->GetState() == RESOURCE_DECODED) {
+		resource->state = resource->Finalize() ? RESOURCE_READY : RESOURCE_FAILED;
+		if (resource->GetState() == RESOURCE_READY) {
+			return;
+		}
+	}
+	if (resource->GetState() == RESOURCE_FAILED) {
+		Env::Err() << "ERROR: Cannot load resource " << resource->GetName() << ": " << resource->GetError() << std::endl;
+	}
+}
+
 void ResourceManager::_CheckResMgr()
 {
 	if (ActiveManager == nullptr) {
@@ -259,18 +743,39 @@ void ResourceManager::_CheckResMgr()
 
 //Subclasses (fml)
 //Resource
+std::uint64_t Resource::useClock = 0;
+
 Resource::Resource()
-	: references(-1), name("invalid")
+	: references(-1), name("invalid"), state(RESOURCE_FAILED), memorySize(0), lastUse(0)
+{
+
+}
+
+Resource::Resource(std::string resourceName, std::string resourceFile)
+	: references(1), name(resourceName), state(RESOURCE_PENDING), memorySize(0), lastUse(++useClock), file(resourceFile)
 {
 
 }
 
-Resource::Resource(std::string resourceName)
-	: references(1), name(resourceName)
+Resource::Resource(const Resource& other)
+	: references(other.references), name(other.name), fileData(other.fileData), state(other.state.load()), error(other.error), memorySize(other.memorySize.load()), lastUse(other.lastUse), file(other.file)
 {
 
 }
 
+Resource& Resource::operator=(const Resource& other)
+{
+	references = other.references;
+	name = other.name;
+	fileData = other.fileData;
+	state = other.state.load();
+	error = other.error;
+	memorySize = other.memorySize.load();
+	lastUse = other.lastUse;
+	file = other.file;
+	return *this;
+}
+
 Resource::~Resource()
 {
 
@@ -278,10 +783,14 @@ Resource::~Resource()
 
 void Resource::Access() {
 	references++;
+	lastUse = ++useClock;
 }
 
 void Resource::Free() {
-	references--;
+	if (references > 0) {
+		references--;
+	}
+	lastUse = ++useClock;
 }
 
 int Resource::GetResourceCount()
@@ -294,174 +803,657 @@ std::string Resource::GetName()
 	return name;
 }
 
+ResourceState Resource::GetState() const
+{
+	return (ResourceState)state.load();
+}
+
+bool Resource::IsReady() const
+{
+	return state == RESOURCE_READY;
+}
+
+std::string Resource::GetError() const
+{
+	return error;
+}
+
+std::size_t Resource::GetMemorySize() const
+{
+	return memorySize;
+}
+
+std::uint64_t Resource::GetLastUse() const
+{
+	return lastUse;
+}
+
+void Resource::Load()
+{
+	if (state != RESOURCE_PENDING) {
+		return;
+	}
+	state = Decode() ? RESOURCE_DECODED : RESOURCE_FAILED;
+	if (state == RESOURCE_DECODED) {
+		state = Finalize() ? RESOURCE_READY : RESOURCE_FAILED;
+	}
+	if (state == RESOURCE_FAILED) {
+		Env::Err() << "ERROR: Cannot load resource " << name << ": " << error << std::endl;
+	}
+}
+
+bool Resource::Decode()
+{
+	return true;
+}
+
+bool Resource::Finalize()
+{
+	return true;
+}
+
+void Resource::Replace(Resource& old)
+{
+}
+
+void Resource::_SetError(std::string message)
+{
+	error = message;
+}
+
+void Resource::_SetMemorySize(std::size_t bytes)
+{
+	memorySize = bytes;
+}
+
+bool Resource::_MapFile(std::string file, const char*& data, std::size_t& size)
+{
+	//no copy of the file: everything reads straight from the pack or the page cache
+	if (!Env::GetResourceManager().GetPack().Read(file, data, size, fileData)) {
+		std::shared_ptr<const MappedFile> mapped = MappedFile::Share(Env::GetGamepath() + file);
+		if (!mapped) {
+			_SetError("Cold not open " + file + ". Resource will be empty!");
+			return false;
+		}
+		data = mapped->GetData();
+		size = (std::size_t)mapped->GetSize();
+		fileData = mapped;
+	}
+	return true;
+}
+
 SDL_RWops* Resource::_RWFromFile(std::string file)
 {
-	SDL_RWops* newRwOps = nullptr;
-	std::fstream infile;
-	Env::Gamefile(file, std::ios::in | std::ios::binary, infile);
-	if (!infile.is_open()) {
-		Env::Err() << "Cold not open " << file << "Resource will be empty!";
+	const char* data = nullptr;
+	std::size_t size = 0;
+	if (!_MapFile(file, data, size)) {
 		return nullptr;
 	}
-	tmpFilestring = std::vector<char>(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
-	newRwOps = SDL_RWFromMem((void*)&tmpFilestring.data()[0], tmpFilestring.size());
+	SDL_RWops* newRwOps = SDL_RWFromConstMem(data, (int)size);
+	if (!newRwOps) {
+		_SetError("Cold not read " + file + " (" + SDL_GetError() + "). Resource will be empty!");
+		fileData.reset();
+	}
 	return newRwOps;
 }
 
+void Resource::_CloseFile()
+{
+	fileData.reset();
+}
+
+void Resource::_CopyFileData(const char*& data, std::size_t size)
+{
+	std::shared_ptr<std::vector<char>> copy = std::make_shared<std::vector<char>>(data, data + size);
+	data = copy->data();
+	fileData = copy;
+}
+
+std::shared_ptr<const void> Resource::_GetFileData() const
+{
+	return fileData;
+}
+
 //AudioResource
+Mix_Chunk* AudioResource::silentChunk = nullptr;
+std::atomic<std::size_t> AudioResource::streamThreshold(512 * 1024);
+
 AudioResource::AudioResource()
-: Resource("invalid")
+: Resource(), streamData(nullptr), streamSize(0)
 {
 	mixChunk = nullptr;
 }
 
 AudioResource::AudioResource(std::string name, std::string file)
-: Resource(name)
+: Resource(name, file), streamData(nullptr), streamSize(0)
 {
-	SDL_RWops* infile = _RWFromFile(file);
+	mixChunk = nullptr;
+}
+
+bool AudioResource::Decode()
+{
+	const char* data = nullptr;
+	std::size_t size = 0;
+	if (!_MapFile(file, data, size)) {
+		return false;
+	}
+	if (size >= streamThreshold && AudioStream::IsVorbis(data, size)) {
+		//music: decoding all of it would take ten times the file size, AudioStream decodes it from the file while it plays
+		//a copy and not the mapping, the file might be written while it plays
+		_CopyFileData(data, size);
+		std::string streamError;
+		if (!AudioStream::Check(data, size, streamError)) {
+			_CloseFile();
+			_SetError(std::string("Error Loading audio stream for ") + file + "! Sound will be empty! " + streamError);
+			return false;
+		}
+		streamData = data;
+		streamSize = size;
+		_SetMemorySize(size);
+		return true;
+	}
+	SDL_RWops* infile = SDL_RWFromConstMem(data, (int)size);
 	if (!infile)
 	{
-		mixChunk = nullptr;
-		return;
+		_CloseFile();
+		_SetError("Cold not read " + file + " (" + SDL_GetError() + "). Resource will be empty!");
+		return false;
 	}
 	mixChunk = Mix_LoadWAV_RW(infile, 1);
+	//the chunk has its own copy of the samples, already converted to the format of the audio device
+	_CloseFile();
 	if (!mixChunk) {
-		Env::Err() << "Error Loading Mix Chunk for " << file << "! Sound will be empty! " << Mix_GetError() << std::endl;
+		_SetError(std::string("Error Loading Mix Chunk for ") + file + "! Sound will be empty! " + Mix_GetError());
+		return false;
 	}
+	_SetMemorySize(mixChunk->alen);
+	return true;
 }
 
 AudioResource::~AudioResource() 
 {
+	if (mixChunk) {
+		//the mixer would keep reading the freed samples
+		for (int channel = 0; channel < Mix_AllocateChannels(-1); channel++) {
+			if (Mix_Playing(channel) && Mix_GetChunk(channel) == mixChunk) {
+				Mix_HaltChannel(channel);
+			}
+		}
+	}
 	Mix_FreeChunk(mixChunk);
 }
 
+int AudioResource::Play(int fadetime, int loops, int channel)
+{
+	if (streamData) {
+		//the stream keeps the mapped file, so it can still fade out after the resource is freed
+		return AudioStream::Play(_GetFileData(), streamData, streamSize, loops, fadetime, channel);
+	}
+	return Mix_FadeInChannel(channel, GetChunk(), loops, fadetime);
+}
+
 Mix_Chunk* AudioResource::GetChunk() const
 {
-	return mixChunk;
+	return mixChunk ? mixChunk : silentChunk;
+}
+
+bool AudioResource::IsStreamed() const
+{
+	return streamData != nullptr;
+}
+
+void AudioResource::SetStreamSize(std::size_t bytes)
+{
+	streamThreshold = bytes;
+}
+
+std::size_t AudioResource::GetStreamSize()
+{
+	return streamThreshold;
+}
+
+void AudioResource::CreateFallback()
+{
+	if (silentChunk) {
+		return;
+	}
+	//a tenth of a second of silence at 44.1 kHz, 16 bit stereo. The chunk does not own the samples
+	static Uint8 silence[17640] = {};
+	silentChunk = Mix_QuickLoad_RAW(silence, sizeof(silence));
+}
+
+void AudioResource::DeleteFallback()
+{
+	Mix_FreeChunk(silentChunk);
+	silentChunk = nullptr;
 }
 
 GLuint TextureResource::boundTexture = 0;
+GLuint TextureResource::placeholderTexture = 0;
+GLuint TextureResource::fallbackTexture = 0;
+std::atomic<int> TextureResource::maxSize(TextureCache::DefaultMaxSize);
 
 TextureResource::TextureResource()
-: Resource("invalid")
+: Resource(), texId(0), surface(nullptr), copyId(0), givenId(0)
 {
 
 }
 
 TextureResource::TextureResource(std::string name, std::string file)
-: Resource(name)
+: Resource(name, file), texId(0), surface(nullptr), copyId(0), givenId(0)
+{
+}
+
+bool TextureResource::Decode()
 {
-	texId = GL_INVALID_VALUE;
+	//cooked textures are uploaded as they are, nothing to decode
+	if (_LoadCooked()) {
+		_SetMemorySize(cooked.GetMemorySize());
+		return true;
+	}
 	//Create SDL_Surface from input file
 	SDL_RWops *textureFile = _RWFromFile(file);
 	if (!textureFile) {
-		Env::Err() << "Could not Load Texture, using dummy texture" << std::endl;
-		return;
+		return false;
 	}
-	SDL_Surface *newTexture = IMG_Load_RW(textureFile, 1);
-	if (!newTexture) {
-		Env::Err() << "Could not Load Texture, using dummy texture" << std::endl;
-		return;
+	surface = IMG_Load_RW(textureFile, 1);
+	_CloseFile();
+	if (!surface) {
+		_SetError(std::string("Could not Load Texture, using dummy texture. ") + IMG_GetError());
+		return false;
 	}
-	
+	//uploaded as RGBA
+	_SetMemorySize(std::size_t(surface->w) * surface->h * 4);
+	//small textures go into the atlas. Converting them here leaves only the upload for the main thread
+	if (TextureAtlas::Fits(surface->w, surface->h)) {
+		TextureAtlas::PrepareImage(surface, atlasPixels);
+	}
+	else if (_Cook()) {
+		_SetMemorySize(cooked.GetMemorySize());
+	}
+	return true;
+}
 
-	texId = TailTipUI::SurfaceToTexture(newTexture);
+bool TextureResource::_LoadCooked()
+{
+	const ResourcePack& pack = Env::GetResourceManager().GetPack();
+	const char* data = nullptr;
+	std::size_t size = 0;
+	std::shared_ptr<const void> owner;
+	if (pack.Read(file + TextureCache::Extension, data, size, owner)) {
+		return TextureCache::Read(data, size, owner, maxSize, cooked);
+	}
+	return !pack.Contains(file) && TextureCache::Load(Env::GetGamepath() + file, maxSize, cooked);
+}
+
+bool TextureResource::_Cook()
+{
+	SDL_Surface* rgba = ConvertToRGBA(surface);
+	if (!rgba) {
+		return false;
+	}
+	SDL_LockSurface(rgba);
+	TextureCache::Build(static_cast<const unsigned char*>(rgba->pixels), rgba->w, rgba->h, rgba->pitch, maxSize, cooked);
+	SDL_UnlockSurface(rgba);
+	SDL_FreeSurface(rgba);
+	SDL_FreeSurface(surface);
+	surface = nullptr;
+
+	//games in a pack get their cooked textures from the pack, the others keep them next to the source
+	std::string path = Env::GetGamepath() + file;
+	std::uint64_t size;
+	std::int64_t mtime;
+	std::shared_ptr<const MappedFile> source;
+	if (!Env::GetResourceManager().GetPack().Contains(file) && MappedFile::Stat(path, size, mtime) && (source = MappedFile::Share(path))) {
+		TextureCache::Save(path, cooked, maxSize, size, mtime, MappedFile::Hash(source->GetData(), source->GetSize()));
+	}
+	return true;
+}
+
+bool TextureResource::Finalize()
+{
+	if (!cooked.levels.empty()) {
+		//all levels are allocated at once and filled straight from the cache mapping
+		const TextureCache::Level& full = cooked.levels[0];
+		GLsizei levels = GLsizei(cooked.levels.size());
+		glGenTextures(1, &texId);
+		glBindTexture(GL_TEXTURE_2D, texId);
+		if (GLEW_ARB_texture_storage) {
+			glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, full.width, full.height);
+		}
+		else {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+			for (GLsizei i = 0; i < levels; i++) {
+				glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, cooked.levels[i].width, cooked.levels[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			}
+		}
+		for (GLsizei i = 0; i < levels; i++) {
+			const TextureCache::Level& level = cooked.levels[i];
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, level.pixels);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		boundTexture = 0;
+		region = AtlasRegion(texId, full.width, full.height);
+		cooked = TextureCache::Image();
+		return true;
+	}
+	if (!atlasPixels.empty() && Env::GetResourceManager().GetAtlas().Insert(atlasPixels, surface->w, surface->h, region)) {
+		SDL_FreeSurface(surface);
+		boundTexture = 0;
+	}
+	else {
+		region = AtlasRegion(TailTipUI::SurfaceToTexture(surface), surface->w, surface->h);
+		texId = region.texture;
+	}
+	surface = nullptr;
+	std::vector<unsigned char>().swap(atlasPixels);
+	return true;
 }
 
 TextureResource::~TextureResource()
 {
-	//Free the texture on the gpu
+	if (surface) {
+		SDL_FreeSurface(surface);
+	}
+	if (region.atlas) {
+		region.atlas->Remove(region);
+	}
+	//Free the texture on the gpu. A new texture might get the same id, so it is not bound any more
 	glDeleteTextures(1, &texId);
+	glDeleteTextures(1, &copyId);
+	if (texId == boundTexture || copyId == boundTexture) {
+		boundTexture = 0;
+	}
 }
 
-GLuint TextureResource::GetTextureId() const
+GLuint TextureResource::GetTextureId()
 {
-	return texId;
+	if (IsReady()) {
+		if (region.atlas && copyId == 0) {
+			copyId = region.atlas->CopyRegion(region);
+			boundTexture = 0;
+			_SetMemorySize(GetMemorySize() + std::size_t(region.width) * region.height * 4);
+		}
+		givenId = copyId != 0 ? copyId : texId;
+		return givenId;
+	}
+	return GetState() == RESOURCE_FAILED ? fallbackTexture : placeholderTexture;
+}
+
+void TextureResource::Replace(Resource& old)
+{
+	TextureResource& oldTexture = static_cast<TextureResource&>(old);
+	GLuint given = oldTexture.givenId;
+	if (given == 0 || !IsReady()) {
+		return;
+	}
+	_CopyInto(region, given);
+	//the id is ours now, the old texture must not delete it
+	if (oldTexture.copyId == given) {
+		oldTexture.copyId = 0;
+	}
+	if (oldTexture.texId == given) {
+		oldTexture.texId = 0;
+	}
+	glDeleteTextures(1, &copyId);
+	copyId = given;
+	givenId = given;
+	_SetMemorySize(GetMemorySize() + std::size_t(region.width) * region.height * 4);
+}
+
+void TextureResource::_CopyInto(const AtlasRegion& source, GLuint target)
+{
+	GLuint framebuffers[2];
+	glGenFramebuffers(2, framebuffers);
+	GLint previousRead, previousDraw;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source.texture, 0);
+	glBindTexture(GL_TEXTURE_2D, target);
+	GLint immutable = GL_FALSE;
+	if (GLEW_ARB_texture_storage) {
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+	}
+	if (!immutable) {
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, source.width, source.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, source.x, source.y, source.width, source.height);
+	}
+	else {
+		GLint width, height;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+		glBlitFramebuffer(source.x, source.y, source.x + source.width, source.y + source.height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+	glDeleteFramebuffers(2, framebuffers);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	boundTexture = 0;
+}
+
+AtlasRegion TextureResource::GetAtlasRegion() const
+{
+	if (IsReady()) {
+		return region;
+	}
+	return GetState() == RESOURCE_FAILED ? AtlasRegion(fallbackTexture, 8, 8) : AtlasRegion(placeholderTexture, 1, 1);
+}
+
+bool TextureResource::IsAtlased() const
+{
+	return IsReady() && region.atlas != nullptr;
 }
 
 void TextureResource::Bind()
 {
-	if (texId != boundTexture && texId != 0) {
-		glBindTexture(GL_TEXTURE_2D, texId);
-		boundTexture = texId;
+	BindTexture(GetAtlasRegion().texture);
+}
+
+void TextureResource::BindTexture(GLuint texture)
+{
+	if (texture != boundTexture && texture != 0) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		boundTexture = texture;
+	}
+}
+
+void TextureResource::ResetBinding()
+{
+	boundTexture = 0;
+}
+
+void TextureResource::CreatePlaceholder()
+{
+	if (placeholderTexture != 0) {
+		return;
 	}
+	unsigned char pixel[4] = { 0, 0, 0, 0 };
+	glGenTextures(1, &placeholderTexture);
+	glBindTexture(GL_TEXTURE_2D, placeholderTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	//missing textures should be seen: a magenta and black checker board, 8x8 fields
+	unsigned char checker[8 * 8 * 4];
+	for (int i = 0; i < 8 * 8; i++) {
+		bool magenta = ((i % 8) + (i / 8)) % 2 == 0;
+		checker[i * 4 + 0] = magenta ? 255 : 0;
+		checker[i * 4 + 1] = 0;
+		checker[i * 4 + 2] = magenta ? 255 : 0;
+		checker[i * 4 + 3] = 255;
+	}
+	glGenTextures(1, &fallbackTexture);
+	glBindTexture(GL_TEXTURE_2D, fallbackTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	boundTexture = 0;
+}
+
+void TextureResource::SetMaxSize(int size)
+{
+	maxSize = size;
+}
+
+int TextureResource::GetMaxSize()
+{
+	return maxSize;
+}
+
+void TextureResource::DeletePlaceholder()
+{
+	glDeleteTextures(1, &placeholderTexture);
+	glDeleteTextures(1, &fallbackTexture);
+	placeholderTexture = 0;
+	fallbackTexture = 0;
 }
 
 //XML loading might not take forever, but files are accesed often.
 XMLResource::XMLResource() 
-: Resource("invalid")
+: Resource()
 {
 }
 
 XMLResource::XMLResource(std::string name, std::string file) 
-: Resource(name)
+: Resource(name, file)
+{
+}
+
+bool XMLResource::Decode()
 {
+	//the pack has the parsed document next to the file, if the game has no pack, it is cached next to the file. So usually nothing has to be parsed here
+	const ResourcePack& pack = Env::GetResourceManager().GetPack();
+	const char* data;
+	std::size_t size;
+	std::shared_ptr<const void> owner;
+	if (pack.Read(file + XMLCache::Extension, data, size, owner) && compactDocument.SetBuffer(data, size, owner)) {
+		_SetMemorySize(compactDocument.GetBufferSize());
+		return true;
+	}
 	std::string infile = Env::GetGamepath() + file;
-	document = HoardXML::Document(infile);
+	if (pack.Read(file, data, size, owner)) {
+		compactDocument.Load(data, size);
+	}
+	else if (!XMLCache::Load(infile, compactDocument)) {
+		_SetError("Cannot open xml file: " + infile);
+		return false;
+	}
+	_SetMemorySize(compactDocument.GetBufferSize());
+	return true;
+}
+
+XMLResource::XMLResource(const XMLResource& other)
+: Resource(other), compactDocument(other.compactDocument)
+{
+	if (other.document) {
+		document.reset(new HoardXML::Document(*other.document));
+	}
 }
 
 XMLResource::~XMLResource()
 {
 }
 
+const HoardXML::CompactDocument& XMLResource::GetCompactDocument() const
+{
+	return compactDocument;
+}
+
 HoardXML::Document& XMLResource::GetDocument()
 {
-	return document;
+	if (!document) {
+		document.reset(new HoardXML::Document(compactDocument.ToDocument()));
+	}
+	return *document;
 }
 
 //Font rescource stores fonts for text rendering
 FontResource::FontResource()
-: Resource("invalid")
+: Resource(), fontData(nullptr), fontSize(0)
 {
 }
 
 FontResource::FontResource(std::string name, std::string file)
-: Resource(name)
+: Resource(name, file), fontData(nullptr), fontSize(0)
 {
-	fontFile = _RWFromFile(file);
-	if (!fontFile)
-	{
-		return;
+}
+
+bool FontResource::Decode()
+{
+	//only read the file here: SDL_ttf is not thread safe, the font is opened in Finalize()
+	//the data stays as long as the font, SDL_ttf reads glyphs from it whenever it needs them. So it is a copy, a mapping would crash once the file is written
+	if (!_MapFile(file, fontData, fontSize)) {
+		return false;
 	}
+	_CopyFileData(fontData, fontSize);
+	_SetMemorySize(fontSize);
+	return true;
+}
+
+bool FontResource::Finalize()
+{
 	//TODO: fixed font size? dosnt seem like a good idea
-	font[64] = TTF_OpenFontRW(fontFile, 0, 64);
-	if (!font[64]) {
-		Env::Err() << "Error loading 16-points-sized testfont " << file << "!(" << TTF_GetError() << ") Font will cause errors!" << std::endl;
-		return;
+	if (!GetFont(64)) {
+		_SetError(std::string("Error loading 16-points-sized testfont ") + file + "!(" + TTF_GetError() + ") Font will cause errors!");
+		return false;
 	}
+	return true;
 }
 
 FontResource::~FontResource()
 { 
+	//the atlases rasterize with the fonts, they go first
+	glyphAtlas.clear();
 	for (auto fontPair = font.begin(); fontPair != font.end(); fontPair++) {
 		if (fontPair->second != NULL) {  
+			TextCache::RemoveFont(fontPair->second);
 			TTF_CloseFont(fontPair->second); 
 		}
-
-		if (fontFile != NULL) {
-			SDL_RWclose(fontFile);
-		}
 	}
 }
 
 TTF_Font* FontResource::GetFont(int size)
 {
-	for (auto fontPair = font.begin(); fontPair != font.end(); fontPair++) {
-		if (fontPair->first == size) {
-			return fontPair->second;
-		}
+	auto loaded = font.find(size);
+	if (loaded != font.end()) {
+		return loaded->second;
 	}
 	TTF_Font* newFont = nullptr;
-	if (fontFile) {
-		newFont = TTF_OpenFontRW(fontFile, 0, size);
+	if (fontData) {
+		//every size reads through its own SDL_RWops: a font seeks in it whenever it loads a glyph, a shared one would be moved under the others
+		SDL_RWops* fontFile = SDL_RWFromConstMem(fontData, (int)fontSize);
+		if (fontFile) {
+			newFont = TTF_OpenFontRW(fontFile, 1, size);
+		}
 	}
 	if (!newFont) {
 		Env::Out() << "Error Loading fong, will use empty (error) font!" << TTF_GetError() << std::endl;
 	}
+	else {
+		glyphAtlas[size] = std::make_shared<GlyphAtlas>(newFont);
+	}
 	font[size] = newFont;
 	return newFont;
 }
 
+GlyphAtlas* FontResource::GetGlyphAtlas(int size)
+{
+	if (!GetFont(size)) {
+		return nullptr;
+	}
+	return glyphAtlas[size].get();
+}
+
 GLuint _CompileShader(std::string source, GLenum shaderType)
 {
 	//Create Shader and compile
@@ -486,29 +1478,127 @@ GLuint _CompileShader(std::string source, GLenum shaderType)
 }
 
 GLuint GLProgramResource::boundProgram = 0;
+std::vector<std::string> GLProgramResource::uniformNames;
+std::uint64_t GLProgramResource::driverHash = 0;
 
 GLProgramResource::GLProgramResource()
-: Resource("invalid")
+: Resource(), sourceHash(0), binary(), programId(0), instanced(false)
 {
 }
 
 GLProgramResource::GLProgramResource(std::string name, std::string file)
-: Resource(name)
+: Resource(name, file), sourceHash(0), binary(), programId(0), instanced(false)
+{
+}
+
+void GLProgramResource::DetectDriver()
+{
+	GLint formats = 0;
+	if (GLEW_ARB_get_program_binary) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	}
+	if (formats == 0) {
+		driverHash = 0;
+		return;
+	}
+	//a driver update makes all binaries invalid, the version string changes with it
+	std::string driver;
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const GLubyte* value = glGetString(name);
+		driver += value ? reinterpret_cast<const char*>(value) : "";
+		driver += '\n';
+	}
+	driverHash = MappedFile::Hash(driver.data(), driver.size());
+}
+
+bool GLProgramResource::Decode()
+{
+	if (!Env::ReadGamefile(file, source)) {
+		_SetError("Cold not open " + file);
+		return false;
+	}
+	_FindConfigs();
+	//the binary from the last start, Finalize() tries it before compiling anything
+	sourceHash = MappedFile::Hash(source.data(), source.size());
+	if (driverHash != 0 && !Env::GetResourceManager().GetPack().Contains(file)) {
+		ProgramCache::Load(Env::GetGamepath() + file, sourceHash, driverHash, binary);
+	}
+	//the driver does not tell the size of the program, the source is a hint
+	_SetMemorySize(source.size());
+	return true;
+}
+
+void GLProgramResource::_FindConfigs()
+{
+	//the stages are marked by "#define CONFIG_HAS_VERTEX" and so on, commented ones do not count
+	static const std::string define = "#define ";
+	configs.clear();
+	std::size_t i = 0;
+	while (i < source.size()) {
+		if (source.compare(i, 2, "//") == 0) {
+			i = source.find('\n', i);
+		}
+		else if (source.compare(i, 2, "/*") == 0) {
+			i = source.find("*/", i + 2);
+			i = i == std::string::npos ? i : i + 2;
+		}
+		else if (source.compare(i, define.size(), define) == 0) {
+			std::size_t begin = i + define.size();
+			for (i = begin; i < source.size() && (std::isalnum((unsigned char)source[i]) || source[i] == '_'); i++);
+			if (source.compare(begin, 7, "CONFIG_") == 0) {
+				configs.push_back(source.substr(begin, i - begin));
+			}
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+bool GLProgramResource::Finalize()
+{
+	//a cached binary does not need to be compiled or linked
+	if (binary.owner) {
+		programId = glCreateProgram();
+		glProgramBinary(programId, (GLenum)binary.format, binary.data, (GLsizei)binary.size);
+		binary = ProgramCache::Binary();
+		GLint isLinked = 0;
+		glGetProgramiv(programId, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_TRUE) {
+			source.clear();
+			configs.clear();
+			_ReflectUniforms();
+			return true;
+		}
+		//the driver does not take it any more: compile the source
+		glDeleteProgram(programId);
+		programId = 0;
+	}
+	if (!_Compile()) {
+		return false;
+	}
+	_ReflectUniforms();
+
+	//store the binary for the next start
+	if (driverHash != 0 && !Env::GetResourceManager().GetPack().Contains(file)) {
+		GLint length = 0;
+		glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length > 0) {
+			std::vector<char> data(length);
+			GLenum format = 0;
+			glGetProgramBinary(programId, length, &length, &format, data.data());
+			ProgramCache::Save(Env::GetGamepath() + file, sourceHash, driverHash, format, data.data(), (std::size_t)length);
+		}
+	}
+	return true;
+}
+
+bool GLProgramResource::_Compile()
 {
 	std::list<GLuint> shaderList;
-	programId = 0;
-
-	std::fstream infile;
-	Env::Gamefile(file, std::ios::in, infile);
-	std::string instring = std::string(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
-	//well need to remove some of the comments, those that are definitly surrounding our config makros
-	std::regex removeCommentRe("\\/\\/.*|\\/\\*[\\w\\d#\\s]*\\*\\/");
-	std::regex configMakroRe("#define (CONFIG_\\w*)");
-	std::string noCommetInString = std::regex_replace(instring, removeCommentRe, "");
-	std::smatch m;
-	std::string s = noCommetInString;
-	while (std::regex_search(s, m, configMakroRe)) {
-		std::string configName = m[1];
+	std::string instring;
+	instring.swap(source);
+	for (const std::string& configName : configs) {
 		GLuint newShader = 0;
 		std::string shaderVersion = "#version 330 core\n";
 		//check the config macos
@@ -535,24 +1625,28 @@ GLProgramResource::GLProgramResource(std::string name, std::string file)
 		}
 		//error checking
 		if (newShader == 0) {
-			Env::Err() << "ERROR: Shader Compilation Error in " << file << std::endl;
 			//we should delete all the other shaders
 			for (GLuint s : shaderList) {
 				glDeleteShader(s);
 			}
 			shaderList.clear();
-			return;
+			_SetError("Shader Compilation Error in " + file);
+			return false;
 		}
 
 		shaderList.push_back(newShader);
-		s = m.suffix().str();
 	}
+	configs.clear();
 
 	//Create program and add all shaders to it
 	programId = glCreateProgram();
 	for (GLuint shaderId : shaderList) {
 		glAttachShader(programId, shaderId);
 	}
+	//the driver has to keep the binary for the program cache
+	if (driverHash != 0) {
+		glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	//Link them and check for errors
 	glLinkProgram(programId);
 	GLint isLinked = 0;
@@ -563,8 +1657,7 @@ GLProgramResource::GLProgramResource(std::string name, std::string file)
 		std::vector<char> errorLog(maxLength);
 		glGetProgramInfoLog(programId, maxLength, &maxLength, &errorLog[0]);
 		std::string errorString(errorLog.begin(), errorLog.end());
-		Env::Err() << "Error Linking " << file << "\n" << errorString << std::endl;
-		Env::Err() << "WARNING: ShaderResource will be invalid!";
+		_SetError("Error Linking " + file + "\n" + errorString + "\nShaderResource will be invalid!");
 		glDeleteProgram(programId);
 		programId = 0;
 	}
@@ -572,11 +1665,44 @@ GLProgramResource::GLProgramResource(std::string name, std::string file)
 		glDeleteShader(shaderId);
 	}
 	shaderList.clear();
+	return programId != 0;
+}
+
+void GLProgramResource::_ReflectUniforms()
+{
+	//every uniform the program has is looked up now, GetUniform() only indexes the table
+	uniforms.assign(uniformNames.size(), -1);
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> name(maxLength + 1);
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(programId, (GLuint)i, maxLength + 1, &length, &size, &type, name.data());
+		std::string uniformName(name.data(), length);
+		//arrays are reported as "name[0]", but set by "name"
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+			uniformName.resize(uniformName.size() - 3);
+		}
+		std::uint32_t id = GetUniformId(uniformName);
+		if (id >= uniforms.size()) {
+			uniforms.resize(id + 1, -1);
+		}
+		uniforms[id] = glGetUniformLocation(programId, uniformName.c_str());
+	}
+	//the SpriteBatch draws these with one call for many sprites
+	instanced = glGetAttribLocation(programId, "instancePosition") >= 0 && glGetAttribLocation(programId, "instanceOffset") >= 0;
 }
 
 GLProgramResource::~GLProgramResource()
 {
 	glDeleteProgram(programId);
+	if (programId == boundProgram) {
+		boundProgram = 0;
+	}
 }
 
 GLuint GLProgramResource::GetProgramId() const
@@ -593,32 +1719,55 @@ void GLProgramResource::Use()
 	}
 }
 
+bool GLProgramResource::IsInstanced() const
+{
+	return instanced;
+}
+
+void GLProgramResource::ResetBinding()
+{
+	boundProgram = 0;
+}
+
 GLuint GLProgramResource::operator[](std::string uniformName) 
 {
-	if (programId == 0) {
-		return 0;
-	}
-	auto p = uniforms.find(uniformName);
-	if (p == uniforms.end()) {
-		GLuint newPos = glGetUniformLocation(programId, uniformName.c_str());
-		uniforms[uniformName] = newPos;
-		return newPos;
+	return GetUniform(GetUniformId(uniformName));
+}
+
+std::uint32_t GLProgramResource::GetUniformId(std::string uniformName)
+{
+	static std::unordered_map<std::string, std::uint32_t> ids;
+	auto id = ids.find(uniformName);
+	if (id != ids.end()) {
+		return id->second;
 	}
-	return p->second;
+	std::uint32_t newId = (std::uint32_t)uniformNames.size();
+	ids[uniformName] = newId;
+	uniformNames.push_back(uniformName);
+	return newId;
+}
+
+GLuint GLProgramResource::GetUniform(std::uint32_t uniformId)
+{
+	//ids made after linking are not in the program
+	return uniformId < uniforms.size() ? (GLuint)uniforms[uniformId] : (GLuint)-1;
 }
 
 TextResource::TextResource()
-: Resource("invalid")
+: Resource()
 {
 
 }
 
 TextResource::TextResource(std::string name, std::string file)
-: Resource(name)
+: Resource(name, file)
 {
-	std::fstream infile;
-	Env::Gamefile(file, std::ios::in, infile);
-	std::string filestring = std::string(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+}
+
+bool TextResource::Decode()
+{
+	std::string filestring;
+	Env::ReadGamefile(file, filestring);
 	std::regex textRE("([\\w.])*\\s*=\\s*(.*)");
 	std::smatch m;
 	std::string s(filestring);
@@ -626,6 +1775,8 @@ TextResource::TextResource(std::string name, std::string file)
 		TextContainer[m[1]] = m[2];
 		s = m.suffix().str();
 	}
+	_SetMemorySize(filestring.size());
+	return true;
 }
 
 TextResource::~TextResource()
@@ -635,6 +1786,10 @@ TextResource::~TextResource()
 
 std::string TextResource::operator[](std::string key)
 {
+	//missing texts show their key, so they are noticed
+	if (GetState() == RESOURCE_FAILED) {
+		return key;
+	}
 	return TextContainer[key];
 }
 
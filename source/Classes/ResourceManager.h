@@ -3,6 +3,23 @@
 #include "base.h"
 
 #include "ScriptLibHelper.h"
+#include "ResourcePack.h"
+#include "TextureAtlas.h"
+#include "GlyphAtlas.h"
+#include "TextCache.h"
+#include "TextureCache.h"
+#include "ProgramCache.h"
+#include "FileWatcher.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
 
 namespace Dragon2D {
 
@@ -16,21 +33,351 @@ class GLProgramResource;
 class MapResource;
 class TextResource;
 
+//enum: ResourceState
+//note: loading state of a resource
+//RESOURCE_PENDING: waits for (or is in) Decode()
+//RESOURCE_DECODED: decoded, waits for Finalize() on the main thread
+//RESOURCE_READY: loaded and usable
+//RESOURCE_FAILED: could not be loaded. The resource stays empty.
+enum ResourceState
+{
+	RESOURCE_PENDING,
+	RESOURCE_DECODED,
+	RESOURCE_READY,
+	RESOURCE_FAILED
+};
+
+//class: ResourceHandle
+//note: Names a resource of type T by a small id. Get it once by name (ResourceManager::Get[Type]Handle()), then ResourceManager::Get() finds the resource without any string lookup.
+//note: A handle stays valid as long as the ResourceManager, even while its resource is not loaded.
+template<class T>
+class ResourceHandle
+{
+public:
+	//constructor: ResourceHandle
+	//note: creates an invalid handle
+	ResourceHandle() : id(InvalidId) {}
+
+	//function: IsValid
+	//note: returns false for handles that were not created by the ResourceManager
+	bool IsValid() const { return id != InvalidId; }
+private:
+	template<class> friend class ResourceSet;
+	explicit ResourceHandle(std::uint32_t handleId) : id(handleId) {}
+
+	//const: InvalidId
+	//note: id of invalid handles
+	static const std::uint32_t InvalidId = 0xFFFFFFFF;
+	std::uint32_t id;
+};
+
+//class: ResourceSet
+//note: The resources of one type. Loaded resources are kept by name, every name a handle was made for gets a slot in a vector, so handles are resolved by index.
+//note: Names that do not exist are remembered (the negative cache), they get the fallback resource of the type without asking the disk again.
+template<class T>
+class ResourceSet
+{
+public:
+	ResourceSet() : fallbackCount(0) {}
+
+	//function: Find
+	//note: returns the loaded resource name, or nullptr
+	T* Find(const std::string& name) const
+	{
+		auto res = loaded.find(name);
+		return res == loaded.end() ? nullptr : res->second;
+	}
+	//function: Find
+	//note: returns the loaded resource of handle, or nullptr
+	T* Find(ResourceHandle<T> handle) const
+	{
+		return handle.id < slots.size() ? slots[handle.id] : nullptr;
+	}
+	//function: Insert
+	//note: adds a loaded resource
+	void Insert(const std::string& name, T* resource)
+	{
+		loaded[name] = resource;
+		auto id = ids.find(name);
+		if (id != ids.end()) {
+			slots[id->second] = resource;
+		}
+	}
+	//function: Erase
+	//note: removes a resource that is unloaded. The handles of name stay valid.
+	void Erase(const std::string& name)
+	{
+		loaded.erase(name);
+		auto id = ids.find(name);
+		if (id != ids.end()) {
+			slots[id->second] = nullptr;
+		}
+	}
+	//function: Intern
+	//note: returns the handle of name, creating it on first call
+	ResourceHandle<T> Intern(const std::string& name)
+	{
+		auto id = ids.find(name);
+		if (id != ids.end()) {
+			return ResourceHandle<T>(id->second);
+		}
+		std::uint32_t newId = (std::uint32_t)slots.size();
+		ids[name] = newId;
+		names.push_back(name);
+		slots.push_back(Find(name));
+		return ResourceHandle<T>(newId);
+	}
+	//function: GetName
+	//note: returns the name of handle ("" for invalid handles)
+	std::string GetName(ResourceHandle<T> handle) const
+	{
+		return handle.id < names.size() ? names[handle.id] : std::string();
+	}
+	//function: GetLoaded
+	//note: returns all loaded resources by name
+	const std::map<std::string, T*>& GetLoaded() const
+	{
+		return loaded;
+	}
+
+	//function: IsMissing
+	//note: returns true if name is known not to exist
+	bool IsMissing(const std::string& name) const
+	{
+		return missing.count(name) > 0;
+	}
+	//function: AddMissing
+	//note: remembers that name does not exist. Its handles resolve to the fallback from now on.
+	void AddMissing(const std::string& name)
+	{
+		missing.insert(name);
+		auto id = ids.find(name);
+		if (id != ids.end()) {
+			slots[id->second] = fallback.get();
+		}
+	}
+	//function: ClearMissing
+	//note: forgets all missing names, so they are looked for again
+	void ClearMissing()
+	{
+		missing.clear();
+		for (auto& slot : slots) {
+			if (slot == fallback.get()) {
+				slot = nullptr;
+			}
+		}
+	}
+
+	//function: SetFallback
+	//note: sets the resource that is used for missing (and failed) resources
+	void SetFallback(std::shared_ptr<T> resource)
+	{
+		fallback = resource;
+	}
+	//function: ServeFallback
+	//note: counts and returns the fallback
+	T& ServeFallback()
+	{
+		fallbackCount++;
+		return *fallback;
+	}
+	//function: IsFallback
+	//note: returns true if resource is the fallback
+	bool IsFallback(const T* resource) const
+	{
+		return resource == fallback.get();
+	}
+	//function: GetFallbackCount
+	//note: returns how often the fallback (or a failed resource) was served
+	std::uint64_t GetFallbackCount() const
+	{
+		return fallbackCount;
+	}
+	//function: CountFallback
+	//note: counts a failed resource that was served instead of the fallback
+	void CountFallback()
+	{
+		fallbackCount++;
+	}
+private:
+	//var: loaded. the loaded resources
+	std::map<std::string, T*> loaded;
+	//var: ids, slots, names. handle id by name, loaded resource (or nullptr) by handle id, name by handle id
+	std::unordered_map<std::string, std::uint32_t> ids;
+	std::vector<T*> slots;
+	std::vector<std::string> names;
+	//var: missing. names that do not exist
+	std::unordered_set<std::string> missing;
+	//var: fallback. served for missing resources. Shared, so ResourceSets can be copied
+	std::shared_ptr<T> fallback;
+	//var: fallbackCount. see GetFallbackCount()
+	std::uint64_t fallbackCount;
+};
+
+//class: ResourceLoader
+//note: The loader threads of the ResourceManager. Resources are decoded by one of the threads and finalized on the main thread in Update().
+class ResourceLoader
+{
+public:
+	//constructor: ResourceLoader
+	//note: starts the threads
+	//param:	threads: number of loader threads. 0 uses one thread less then the cpu has cores (at least 1).
+	ResourceLoader(int threads);
+	//destructor: ~ResourceLoader
+	//note: stops the threads. Resources that are still queued stay pending.
+	~ResourceLoader();
+
+	ResourceLoader(const ResourceLoader&) = delete;
+	ResourceLoader& operator=(const ResourceLoader&) = delete;
+
+	//function: Enqueue
+	//note: hands a new resource to the loader threads
+	void Enqueue(Resource* resource);
+	//function: Finish
+	//note: Makes sure resource is ready (or failed) when it returns. Decodes it on the calling thread if no loader thread has started it yet.
+	void Finish(Resource* resource);
+	//function: Cancel
+	//note: Takes resource out of the queues (waits if a loader thread decodes it right now), so it can be deleted. Main thread only.
+	void Cancel(Resource* resource);
+	//function: Update
+	//note: finalizes the resources the loader threads are done with and returns how many. Main thread only.
+	int Update();
+	//function: GetThreadCount
+	//note: returns the number of loader threads
+	int GetThreadCount() const;
+private:
+	//function: _WorkerMain
+	//note: main function of the loader threads. Decodes resources from decodeQueue until stopWorkers is set.
+	void _WorkerMain();
+	//function: _Finalize
+	//note: finalizes a decoded resource on the main thread and reports errors
+	void _Finalize(Resource* resource);
+
+	//var: workers. the loader threads
+	std::vector<std::thread> workers;
+	//var: queueMutex. protects decodeQueue, finalizeQueue, stopWorkers and the state of queued resources
+	std::mutex queueMutex;
+	//var: queueCondition. signals the workers that there is something to decode (or that they should stop)
+	std::condition_variable queueCondition;
+	//var: decodedCondition. signals the main thread that a resource was decoded
+	std::condition_variable decodedCondition;
+	//var: decodeQueue. resources waiting for a loader thread
+	std::deque<Resource*> decodeQueue;
+	//var: finalizeQueue. decoded resources waiting for Update()
+	std::vector<Resource*> finalizeQueue;
+	//var: stopWorkers. set to true to end the loader threads
+	bool stopWorkers;
+};
+
 //class: ResourceManager
 //note: The ResouceManager manages Game Resources (as sounds, images, ...)
 //note: it acutally retunrs the SDL or OpenGL formats for the resources (gluints, sdl_samples,...) and manages the memory of them
 //note: its harldy reccomend to , at loading level, Request() files so they are loaded into memory before they are Acces()ed
+//note: Request() returns at once: reading and decoding the files happens on worker threads, only the last step (uploading to OpenGL, ...) is done on the main thread in Update().
+//note: Get() waits for resources that are not loaded yet, except for textures: they show a transparent placeholder until they are ready.
+//note: Free() does not unload at once: resources nobody requested any more stay loaded, so requesting them again is cheap. Once a type uses more memory than its budget, the least recently freed of them are unloaded.
+//note: References from Get() are only valid while the resource is requested (or until the next Update()).
+//note: Files that change while the game runs can be loaded again (see Reload() and WatchFiles()). The new resource replaces the old one in Update(), handles get the new one, references from Get() are invalid then.
 class ResourceManager
 {
 public:
+	//typedef: ReloadListener
+	//note: called with the file that changed ("texture/player.png"), see AddReloadListener()
+	typedef std::function<void(const std::string&)> ReloadListener;
+
+	//const: DefaultMemoryBudget
+	//note: memory budget of types without one in the settings (64 MB)
+	static const std::size_t DefaultMemoryBudget = 64 * 1024 * 1024;
+
 	//constructor:ResourceManager
 	//note: standart constructor. loads all resources from files and makes shure the singleton is initialised properly
-	ResourceManager();
+	//param:	loaderThreads: number of threads that load resources. 0 uses one thread less then the cpu has cores (at least 1).
+	ResourceManager(int loaderThreads = 0);
 
 	//deconstructor: ~ResourceManager
 	//note: closes files, ...
 	~ResourceManager();
 
+	//function: Update
+	//note: Finishes resources the loader threads are done with. Has to be called on the main thread (with the OpenGL context), once every frame.
+	void Update();
+
+	//function: GetTextureHandle
+	//note: returns the handle of a texture. Resolve it once, Get() with it is O(1).
+	ResourceHandle<TextureResource> GetTextureHandle(std::string name);
+	//function: GetFontHandle
+	//note: returns the handle of a font
+	ResourceHandle<FontResource> GetFontHandle(std::string name);
+	//function: GetGLProgramHandle
+	//note: returns the handle of a shader program
+	ResourceHandle<GLProgramResource> GetGLProgramHandle(std::string name);
+	//function: Get
+	//note: Returns the resource of a handle, like the Get[Type]Resource functions (textures do not wait, they have a placeholder). Loads it again if it was unloaded.
+	TextureResource& Get(ResourceHandle<TextureResource> handle);
+	FontResource& Get(ResourceHandle<FontResource> handle);
+	GLProgramResource& Get(ResourceHandle<GLProgramResource> handle);
+
+	//function: GetPack
+	//note: returns the ResourcePack of the game. It is closed if the game has no game.pak, then all files are read from the game folder.
+	const ResourcePack& GetPack() const;
+	//function: GetAtlas
+	//note: returns the atlas that small textures are packed into
+	TextureAtlas& GetAtlas();
+	//function: GetTextCache
+	//note: returns the cache of rendered texts (see CachedText)
+	TextCache& GetTextCache();
+	//function: GetTextCacheHits
+	//note: returns how often the text cache found a rendered text
+	std::uint64_t GetTextCacheHits();
+	//function: GetTextCacheMisses
+	//note: returns how often the text cache had to render a text
+	std::uint64_t GetTextCacheMisses();
+	//function: GetTextCacheMemory
+	//note: returns the bytes of texture memory used by the text cache
+	std::size_t GetTextCacheMemory();
+
+	//function: GetMemoryUsage
+	//note: returns the bytes used by the loaded resources of a type ("audio", "video", "texture", "xml", "font", "shader", "map" or "text")
+	std::size_t GetMemoryUsage(std::string type);
+	//function: GetUnusedMemoryUsage
+	//note: returns the bytes of the resources of a type that are not requested any more, but still loaded
+	std::size_t GetUnusedMemoryUsage(std::string type);
+	//function: GetMemoryBudget
+	//note: returns the memory budget of a type in bytes
+	std::size_t GetMemoryBudget(std::string type);
+	//function: SetMemoryBudget
+	//note: Sets the memory budget of a type. Unused resources are unloaded in the next Update() if the type uses more.
+	void SetMemoryBudget(std::string type, std::size_t bytes);
+
+	//function: GetFallbackCount
+	//note: returns how often a type served its fallback, because a resource was missing or failed to load
+	std::uint64_t GetFallbackCount(std::string type);
+	//function: ClearMissingResources
+	//note: Forgets which names were missing, so they are looked for again on the next request. Call it when files were added to the game.
+	void ClearMissingResources();
+
+	//function: WatchFiles
+	//note: Starts (or stops) watching the game folder. Changed files are reloaded in Update(), see Reload(). Does nothing for games in a pack and on systems without a FileWatcher.
+	void WatchFiles(bool watch);
+	//function: IsWatchingFiles
+	//note: returns true if changed files are reloaded
+	bool IsWatchingFiles() const;
+	//function: Reload
+	//note: Loads the loaded resources of a file again (textures, xml, shaders and texts). The new resource is decoded by the loader threads and replaces the old one in Update() once it is ready, the old one stays if it fails.
+	//note: The reload listeners are called once the file is replaced, or at once if no resource uses it. Fonts are not reloaded, the ui keeps their TTF_Font.
+	//param:	file: the changed file, relative to the game folder ("texture/player.png")
+	void Reload(std::string file);
+	//function: AddReloadListener
+	//note: Adds a function that is called (in Update()) for every file that was reloaded, so objects that read the file themselves (scripts, quiz files, ...) can reload it. Returns an id for RemoveReloadListener().
+	int AddReloadListener(ReloadListener listener);
+	//function: RemoveReloadListener
+	//note: removes a reload listener
+	void RemoveReloadListener(int id);
+
+	//function: FinishTextureResource
+	//note: Waits until a requested texture is loaded. Use it if the texture id is stored somewhere and would never get away from the placeholder.
+	void FinishTextureResource(std::string name);
+
 	//function: RequestAudioResource()
 	//note: Request Access to an audio resource, causing it to be loaded if it wasnt. Increment ref count if already loaded
 	void RequestAudioResource(std::string name);
@@ -135,21 +482,56 @@ private:
 	std::map<std::string, std::string> textDb;
 
 	//var: audioResources. Contains the currently loaded Audio Resourcess
-	std::map<std::string, AudioResource*> audioResources;
+	ResourceSet<AudioResource> audioResources;
 	//var: videoResources. Contains the currently loaded Video Resourcess
-	std::map<std::string, VideoResource*> videoResources;
+	ResourceSet<VideoResource> videoResources;
 	//var: textureResources. Contains the currently loaded Texture Resourcess
-	std::map<std::string, TextureResource*> textureResources;
+	ResourceSet<TextureResource> textureResources;
 	//var: XMLResources. Contains the currently loaded XML Resourcess
-	std::map<std::string, XMLResource*> XMLResources;
+	ResourceSet<XMLResource> XMLResources;
 	//var: fontResources. Contains the currently loaded Font Resourcess
-	std::map<std::string, FontResource*> fontResources;
+	ResourceSet<FontResource> fontResources;
 	//var: glProgramResources. Contains the currently loaded Shader Resourcess
-	std::map<std::string, GLProgramResource*> glProgramResources;
+	ResourceSet<GLProgramResource> glProgramResources;
 	//var: mapResources. Contains the currently loaded Map Resourcess
-	std::map<std::string, MapResource*> mapResources;
+	ResourceSet<MapResource> mapResources;
 	//var: textResources. Contains the currently loaded Text Resourcess
-	std::map<std::string, TextResource*> textResources;
+	ResourceSet<TextResource> textResources;
+
+	//var: budgets. memory budget per type in bytes
+	std::map<std::string, std::size_t> budgets;
+	//var: trimNeeded. set when resources were freed or loaded, the next Update() checks the budgets
+	bool trimNeeded;
+
+	//var: pack. the game.pak, if the game has one
+	ResourcePack pack;
+	//var: atlas. the pages of the small textures. Shared, so the ResourceManager can be copied
+	std::shared_ptr<TextureAtlas> atlas;
+	//var: textCache. the rendered texts of the ui
+	std::shared_ptr<TextCache> textCache;
+
+	//var: loader. loads requested resources in the background
+	std::shared_ptr<ResourceLoader> loader;
+
+	//class: PendingReload
+	//note: a reloaded resource that is still loading
+	struct PendingReload
+	{
+		//var: file. the file that changed
+		std::string file;
+		//var: resource. the new resource
+		Resource* resource;
+		//var: replace. swaps the old resource for the new one once it is loaded. Returns false while it is not.
+		std::function<bool()> replace;
+	};
+	//var: watcher. watches the game folder for WatchFiles()
+	std::shared_ptr<FileWatcher> watcher;
+	//var: reloads. resources that replace others once they are loaded
+	std::vector<PendingReload> reloads;
+	//var: reloadListeners. the listeners by id
+	std::map<int, ReloadListener> reloadListeners;
+	//var: nextListenerId. id of the next listener
+	int nextListenerId;
 protected:
 	//function: _CheckResMgr
 	//note: checks singleton
@@ -158,74 +540,237 @@ protected:
 	//function: _LoadDbIntoMap
 	//note: Loads a filestring into a std::map. 
 	std::map<std::string, std::string> _LoadDbIntoMap(std::string FileString, std::string resFolder);
+	//function: _LoadDbFiles
+	//note: Fills the dbs with the .db files of the resource folders (made by buildDB.sh)
+	void _LoadDbFiles();
+	//function: _LoadDbsFromPack
+	//note: Fills the dbs with the files in the pack, instead of reading the .db files
+	void _LoadDbsFromPack();
+
+	//function: _Exists
+	//note: returns true if file is in the pack or the game folder
+	bool _Exists(const std::string& file) const;
+
+	//function: _TrimResources
+	//note: unloads unused resources of all types that are over their budget
+	void _TrimResources();
+
+	//function: _UpdateReloads
+	//note: replaces the reloaded resources that are ready and calls the listeners
+	void _UpdateReloads();
+	//function: _AddFile
+	//note: adds a new file to its db, so it can be found by name
+	void _AddFile(const std::string& file);
+	//function: _NotifyReload
+	//note: calls the reload listeners for file
+	void _NotifyReload(const std::string& file);
+	//function: _Replace
+	//note: lets the reloaded newRes take what it needs from oldRes (see Resource::Replace())
+	static void _Replace(Resource* newRes, Resource* oldRes);
+
+	//function: _ReloadGeneralResource
+	//note: Helper for Reload(). Starts loading the resources of file again. Returns false if no resource of the set uses the file.
+	template<class T>
+	bool _ReloadGeneralResource(const std::string& file, ResourceSet<T>&resources)
+	{
+		bool found = false;
+		for (auto& res : resources.GetLoaded()) {
+			if (res.second->file != file) {
+				continue;
+			}
+			std::string name = res.first;
+			T* newRes = new T(name, file);
+			loader->Enqueue(newRes);
+			PendingReload reload;
+			reload.file = file;
+			reload.resource = newRes;
+			reload.replace = [this, name, newRes, &resources]() {
+				if (newRes->GetState() != RESOURCE_READY && newRes->GetState() != RESOURCE_FAILED) {
+					return false;
+				}
+				T* oldRes = resources.Find(name);
+				if (newRes->GetState() == RESOURCE_FAILED || !oldRes) {
+					//the old one stays (or was unloaded while the new one loaded). A failed decode might still wait in the finalize queue
+					loader->Cancel(newRes);
+					delete newRes;
+					return true;
+				}
+				//the new one takes over the requests of the old one, handles find it in its slot
+				newRes->references = oldRes->references;
+				newRes->lastUse = oldRes->lastUse;
+				_Replace(newRes, oldRes);
+				loader->Cancel(oldRes);
+				resources.Insert(name, newRes);
+				delete oldRes;
+				trimNeeded = true;
+				return true;
+			};
+			reloads.push_back(reload);
+			found = true;
+		}
+		return found;
+	}
 
 	//function: _RequestGeneralResource
 	//note: helper for Resource access. Used by the Request[ResourceTyoe]Access functions.
 	template<class T>
-	bool _RequestGeneralResource(std::string name, std::map<std::string, std::string>&db, std::map<std::string, T*>&resources)
+	bool _RequestGeneralResource(std::string name, std::map<std::string, std::string>&db, ResourceSet<T>&resources)
 	{
 		//Since template functions are unreadable, some more comments here
 		//Try to get a resource from the given resource set 
-		auto res = resources.find(name);
-		if (res == resources.end()) {
+		T* res = resources.Find(name);
+		if (!res) {
+			//we already know it does not exist
+			if (resources.IsMissing(name)) {
+				return false;
+			}
 			//If not in the resource set, try to find it in the db
 			auto dbdata = db.find(name);
-			if (dbdata == db.end()) {
-				//if not there, return false - we cannot add an unknown resource. or can we?
-				//try to see if the resource loads when we give that name to it.
-				T* newRes = new  T(name, name);
-				if (newRes->GetName() != "invalid") { //yay
-					resources[name] = newRes;
-					return true;
-				}
-				//ok we tried
+			//If not there, try to see if the resource loads when we give that name to it.
+			std::string file = dbdata == db.end() ? name : dbdata->second;
+			if (dbdata == db.end() && !_Exists(file)) {
+				resources.AddMissing(name);
 				return false;
 			}
-			//If we know it, Load it. T is our resource-class (i.e. AudioResource)
-			T* newRes = new  T(name, dbdata->second);
-			resources[name] = newRes;
+			//T is our resource-class (i.e. AudioResource). It is only created here, the loader threads load it
+			T* newRes = new  T(name, file);
+			if (newRes->GetName() == "invalid") {
+				//some types can not be loaded at all
+				delete newRes;
+				resources.AddMissing(name);
+				return false;
+			}
+			resources.Insert(name, newRes);
+			loader->Enqueue(newRes);
+			trimNeeded = true;
 			return true;
 		}
-		//If we have the resource in the set, increse ref count
-		res->second->Access();
+		//If we have the resource in the set, increse ref count. This also brings back unused ones
+		res->Access();
 		return true;
 	}
 
 	//function: _RequestGeneralResource
 	//note: helper for Resource access. Used by the Free[ResourceTyoe]Access functions.
 	template<class T>
-	void _FreeGeneralResource(std::string name, std::map<std::string, T*>&resources)
+	void _FreeGeneralResource(std::string name, ResourceSet<T>&resources)
 	{
 		//Find res in the given resource set
-		auto res = resources.find(name);
+		T* res = resources.Find(name);
 		//If we dont know the resource do nothing
-		if (res != resources.end()) {
-			//Decres ref count
-			res->second->Free();
+		if (res) {
+			//Decres ref count. At 0 it is unused, and unloaded when the budget needs the memory
+			res->Free();
+			trimNeeded = true;
+		}
+	}
+
+	//function: _GetGeneralMemoryUsage
+	//note: returns the bytes used by resources. Only counts unused ones if onlyUnused is set.
+	template<class T>
+	std::size_t _GetGeneralMemoryUsage(ResourceSet<T>&resources, bool onlyUnused)
+	{
+		std::size_t bytes = 0;
+		for (auto& res : resources.GetLoaded()) {
+			if (!onlyUnused || res.second->GetResourceCount() <= 0) {
+				bytes += res.second->GetMemorySize();
+			}
+		}
+		return bytes;
+	}
+
+	//function: _TrimGeneralResources
+	//note: Unloads unused resources, least recently freed first, until the type fits into its budget. Resources that are still requested are never unloaded.
+	template<class T>
+	void _TrimGeneralResources(std::string type, ResourceSet<T>&resources)
+	{
+		std::size_t budget = GetMemoryBudget(type);
+		std::size_t used = _GetGeneralMemoryUsage(resources, false);
+		if (used <= budget) {
+			return;
+		}
+		//only loaded (or failed) ones: unloading something that is still loading frees nothing
+		std::vector<T*> unused;
+		for (auto& res : resources.GetLoaded()) {
+			ResourceState state = res.second->GetState();
+			if (res.second->GetResourceCount() <= 0 && (state == RESOURCE_READY || state == RESOURCE_FAILED)) {
+				unused.push_back(res.second);
+			}
+		}
+		std::sort(unused.begin(), unused.end(), [](T* a, T* b) { return a->GetLastUse() < b->GetLastUse(); });
+		for (T* res : unused) {
+			if (used <= budget) {
+				break;
+			}
+			used -= std::min(used, res->GetMemorySize());
+			loader->Cancel(res);
+			resources.Erase(res->GetName());
+			delete res;
 		}
 	}
 
 	//function: _GetGeneralResource
 	//note: helper for Resource access. Used by the Get[ResourceType] functions.
+	//param:	wait: if true, waits until the resource is loaded. Otherwise the resource might still be pending.
 	template<class T>
-	T& _GetGeneralResource(std::string name, std::map<std::string, std::string>&db, std::map<std::string, T*>&resources)
+	T& _GetGeneralResource(std::string name, std::map<std::string, std::string>&db, ResourceSet<T>&resources, bool wait = true)
 	{
 		//Find res in the given resource set
-		auto res = resources.find(name);
-		if (res != resources.end()) {
-			return *res->second;
+		T* res = resources.Find(name);
+		if (!res) {
+			//Try to load it. Will take a long time, but better then having black tiles cause someone cant edit map files
+			if (!_RequestGeneralResource(name, db, resources)) {
+				//missing: the shared fallback, every time without looking for the file again
+				return resources.ServeFallback();
+			}
+			res = resources.Find(name);
+		}
+		if (wait) {
+			loader->Finish(res);
 		}
-		//Try to load it. Will take a long time, but better then having black tiles cause someone cant edit map files
-		if (_RequestGeneralResource(name, db, resources)) {
-			return *resources[name];
+		if (res->GetState() == RESOURCE_FAILED) {
+			resources.CountFallback();
 		}
+		return *res;
+	}
+
 
-		//Return invalid resource.
-		return *(new T);
+	//function: _GetHandleResource
+	//note: helper for Get() with handles. Only looks up the name if the resource is not loaded.
+	template<class T>
+	T& _GetHandleResource(ResourceHandle<T> handle, std::map<std::string, std::string>&db, ResourceSet<T>&resources, bool wait = true)
+	{
+		T* res = resources.Find(handle);
+		if (!res) {
+			return _GetGeneralResource(resources.GetName(handle), db, resources, wait);
+		}
+		if (resources.IsFallback(res)) {
+			return resources.ServeFallback();
+		}
+		if (wait) {
+			loader->Finish(res);
+		}
+		if (res->GetState() == RESOURCE_FAILED) {
+			resources.CountFallback();
+		}
+		return *res;
 	}
 };
 
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(ResourceManager)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, FinishTextureResource)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetMemoryUsage)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetUnusedMemoryUsage)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetMemoryBudget)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, SetMemoryBudget)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetFallbackCount)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetTextCacheHits)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetTextCacheMisses)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, GetTextCacheMemory)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, ClearMissingResources)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, WatchFiles)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, IsWatchingFiles)
+D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, Reload)
 D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, RequestAudioResource)
 D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, RequestVideoResource)
 D2DCLASS_SCRIPTINFO_MEMBER(ResourceManager, RequestTextureResource)
@@ -272,24 +817,99 @@ public:
 
 //class: Resource
 //note: base class for resource classes
+//note: Resources are loaded in two steps: Decode() reads and decodes the file on a loader thread, Finalize() does the rest on the main thread.
+//note: The constructor only remembers name and file, so Resources can be created anywhere. 
 class Resource 
 {
 public:
 	Resource();
-	Resource(std::string resourceName);
+	Resource(std::string resourceName, std::string resourceFile = "");
 	virtual ~Resource();
 
+	Resource(const Resource& other);
+	Resource& operator=(const Resource& other);
+
 	virtual void Access();
 	virtual void Free();
 	virtual int  GetResourceCount();
 
 	std::string GetName();
+
+	//function: GetState
+	//note: returns the loading state of the resource
+	ResourceState GetState() const;
+	//function: IsReady
+	//note: returns true if the resource is loaded and usable
+	bool IsReady() const;
+	//function: GetError
+	//note: returns why loading failed
+	std::string GetError() const;
+	//function: GetMemorySize
+	//note: returns the bytes the loaded resource uses (roughly: decoded samples, texture pixels, ...). 0 until it is loaded.
+	std::size_t GetMemorySize() const;
+	//function: GetLastUse
+	//note: returns when Access() or Free() was called last. Larger is later.
+	std::uint64_t GetLastUse() const;
+
+	//function: Load
+	//note: loads the resource on the calling thread (Decode() and Finalize()). Only for resources that are not loaded by the ResourceManager.
+	void Load();
 private:
+	friend class ResourceLoader;
+	//ResourceManager: a reloaded resource takes over references and lastUse of the old one
+	friend class ResourceManager;
 	int references;
 	std::string name;
-	std::vector<char> tmpFilestring;
+	//var: fileData. keeps the memory behind the SDL_RWops of _RWFromFile alive (the pack, a mapped file or an unpacked copy)
+	std::shared_ptr<const void> fileData;
+	//var: state. a ResourceState. Set by the ResourceManager, read everywhere
+	std::atomic<int> state;
+	//var: error. why loading failed. 
+	std::string error;
+	//var: memorySize. see GetMemorySize(). Set by Decode() on a loader thread
+	std::atomic<std::size_t> memorySize;
+	//var: lastUse. see GetLastUse()
+	std::uint64_t lastUse;
+	//var: useClock. counts Access() and Free() calls, gives lastUse
+	static std::uint64_t useClock;
 protected:
+	//var: file. the file this resource is loaded from 
+	std::string file;
+
+	//function: Decode
+	//note: Reads and decodes the file. Runs on a loader thread, so it must not touch OpenGL, the Env output streams or anything else that belongs to the main thread.
+	//note: Return false (and call _SetError()) if the resource can not be loaded
+	virtual bool Decode();
+	//function: Finalize
+	//note: Finishes the decoded resource on the main thread. Return false (and call _SetError()) if the resource can not be loaded
+	virtual bool Finalize();
+	//function: Replace
+	//note: Called on the main thread when this reloaded resource takes the place of old, before old is deleted. Resources that gave out something that stays in use (like GL ids) hand it over here.
+	virtual void Replace(Resource& old);
+
+	//function: _SetError
+	//note: sets the error message for GetError()
+	void _SetError(std::string message);
+	//function: _SetMemorySize
+	//note: sets the size for GetMemorySize(). Call it in Decode() or Finalize().
+	void _SetMemorySize(std::size_t bytes);
+
+	//function: _MapFile
+	//note: Gets the content of the game file "file" without copying it, from the pack if it has the file, else from the memory mapped file. Returns false if it can not be opened. The memory stays like the one of _RWFromFile.
+	//note: Only read the mapping while decoding, and close it then. Use _CopyFileData() for data that is kept.
+	bool _MapFile(std::string file, const char*& data, std::size_t& size);
+	//function: _RWFromFile
+	//note: Returns a read-only SDL_RWops on the game file "file", from the pack if it has the file, else on the memory mapped file. The memory is shared with other resources and stays until _CloseFile() (or the resource is destroyed).
 	SDL_RWops* _RWFromFile(std::string file);
+	//function: _CloseFile
+	//note: Releases the file of _RWFromFile. Only call it once the SDL_RWops is closed.
+	void _CloseFile();
+	//function: _CopyFileData
+	//note: Replaces the memory of _MapFile() by a copy, data then points into the copy. For data that is used as long as the resource lives (fonts, streamed music): a mapped file that is written while it is mapped (the game files can change with hot reload) crashes the next read with SIGBUS.
+	void _CopyFileData(const char*& data, std::size_t size);
+	//function: _GetFileData
+	//note: returns what keeps the memory of _MapFile() alive, for users that need it longer then the resource
+	std::shared_ptr<const void> _GetFileData() const;
 	
 };
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(Resource)
@@ -298,10 +918,15 @@ D2DCLASS_SCRIPTINFO_MEMBER(Resource, Access)
 D2DCLASS_SCRIPTINFO_MEMBER(Resource, Free)
 D2DCLASS_SCRIPTINFO_MEMBER(Resource, GetResourceCount)
 D2DCLASS_SCRIPTINFO_MEMBER(Resource, GetName)
+D2DCLASS_SCRIPTINFO_MEMBER(Resource, IsReady)
+D2DCLASS_SCRIPTINFO_MEMBER(Resource, GetMemorySize)
+D2DCLASS_SCRIPTINFO_MEMBER(Resource, Load)
 D2DCLASS_SCRIPTINFO_END
 
 //class: AudioResource
 //note: stores audio chunk that is used by sdl stuff
+//note: Ogg vorbis files from GetStreamSize() bytes on (music) are not decoded while loading. They stay mapped and are decoded while they are played, see AudioStream.
+//note: Everything else (short effects) is decoded and converted to the format and rate of the audio device by the loader threads, so playing it only starts mixing the ready samples.
 class AudioResource : public Resource
 {
 public:
@@ -309,15 +934,50 @@ public:
 	AudioResource(std::string name, std::string file);
 	~AudioResource();
 
+	//function: Play
+	//note: Plays the resource, streamed or as chunk. Returns the channel, -1 if none is free.
+	//param:	fadetime: milliseconds to fade in
+	//		loops: like Mix_PlayChannel, -1 loops forever
+	//		channel: the channel to play on (what plays there stops), -1 for a free one
+	int Play(int fadetime, int loops, int channel = -1);
+	//function: GetChunk
+	//note: returns the samples. Returns a silent chunk if the resource is missing, failed or streamed.
 	Mix_Chunk* GetChunk() const;
+	//function: IsStreamed
+	//note: returns true if the resource is decoded while it is played
+	bool IsStreamed() const;
+
+	//function: SetStreamSize
+	//note: sets the file size (in bytes) from which on ogg vorbis files are streamed. 0 streams all of them. Resources that are loaded already stay like they are.
+	static void SetStreamSize(std::size_t bytes);
+	//function: GetStreamSize
+	//note: returns the size set by SetStreamSize(). The default is 512 KB, the effects of the demo game are smaller, the music is larger.
+	static std::size_t GetStreamSize();
+
+	//function: CreateFallback
+	//note: creates the silent chunk. Called by the ResourceManager.
+	static void CreateFallback();
+	//function: DeleteFallback
+	//note: deletes the silent chunk
+	static void DeleteFallback();
+protected:
+	bool Decode();
 private:
 	Mix_Chunk* mixChunk;
+	static Mix_Chunk* silentChunk;
+	//var: streamData, streamSize. the mapped file of streamed resources, nullptr for chunks
+	const char* streamData;
+	std::size_t streamSize;
+	//var: streamThreshold. see SetStreamSize(). Read by the loader threads
+	static std::atomic<std::size_t> streamThreshold;
 };
 
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(AudioResource)
 D2DCLASS_SCRIPTINFO_PARENTINFO(Resource, AudioResource)
 D2DCLASS_SCRIPTINFO_CONSTRUCTOR(AudioResource, std::string, std::string)
 D2DCLASS_SCRIPTINFO_MEMBER(AudioResource, GetChunk)
+D2DCLASS_SCRIPTINFO_MEMBER(AudioResource, Play)
+D2DCLASS_SCRIPTINFO_MEMBER(AudioResource, IsStreamed)
 D2DCLASS_SCRIPTINFO_END
 
 //class: VideoResource
@@ -325,8 +985,8 @@ D2DCLASS_SCRIPTINFO_END
 class VideoResource : public Resource
 {
 public:
-	VideoResource():Resource("invaldi"){}
-	VideoResource(std::string name, std::string file):Resource("invaldi"){}
+	VideoResource():Resource(){}
+	VideoResource(std::string name, std::string file):Resource("invalid"){}
 	~VideoResource(){}
 private:
 	
@@ -345,11 +1005,73 @@ public:
 	TextureResource(std::string name, std::string file);
 	~TextureResource();
 
-	GLuint		GetTextureId() const;
+	//function: GetTextureId
+	//note: returns the texture. Returns the (transparent) placeholder while the texture is loading, and the (magenta checker) fallback if it is missing or failed.
+	//note: Textures in the atlas get a copy of their region the first time this is called. Renderers that can use uvs should take GetAtlasRegion() instead.
+	GLuint		GetTextureId();
+	//function: GetAtlasRegion
+	//note: returns the texture with the uv rectangle of the image: an atlas page or a texture of its own (or the placeholder or fallback)
+	AtlasRegion GetAtlasRegion() const;
+	//function: IsAtlased
+	//note: returns true if the texture is in the atlas
+	bool IsAtlased() const;
+	//function: Bind
+	//note: binds the texture of GetAtlasRegion()
 	void Bind();
+	//function: BindTexture
+	//note: binds a GL texture (i.e. an AtlasRegion::texture) to GL_TEXTURE_2D, unless it is bound already
+	static void BindTexture(GLuint texture);
+	//function: ResetBinding
+	//note: forgets which texture is bound. Call it after binding textures without Bind() or BindTexture().
+	static void ResetBinding();
+
+	//function: CreatePlaceholder
+	//note: creates the placeholder texture (one transparent pixel) and the fallback texture. Called by the ResourceManager.
+	static void CreatePlaceholder();
+	//function: DeletePlaceholder
+	//note: deletes the placeholder and fallback textures
+	static void DeletePlaceholder();
+
+	//function: SetMaxSize
+	//note: Sets the limit for width and height of textures that are not in the atlas, larger ones are scaled down (see TextureCache). 0 for no limit. Set it before textures are requested.
+	static void SetMaxSize(int size);
+	//function: GetMaxSize
+	//note: returns the limit for width and height of textures
+	static int GetMaxSize();
+protected:
+	bool Decode();
+	bool Finalize();
+	//function: Replace
+	//note: The ui keeps the id of GetTextureId(). It gets the new image and stays valid, instead of being deleted with old.
+	void Replace(Resource& old);
 private:
+	//function: _CopyInto
+	//note: copies the image of source into the GL texture target. Mutable textures get the size of source, the storage of cooked textures keeps its size and the image is scaled into it.
+	static void _CopyInto(const AtlasRegion& source, GLuint target);
+	//function: _LoadCooked
+	//note: loads the cooked texture from the pack or the TextureCache. Returns false if there is none.
+	bool _LoadCooked();
+	//function: _Cook
+	//note: builds the cooked texture from surface and writes the cache for the next time
+	bool _Cook();
+
 	GLuint texId;
+	//var: surface. the decoded image, until it is uploaded in Finalize()
+	SDL_Surface* surface;
+	//var: atlasPixels. the decoded image prepared for the atlas (see TextureAtlas::PrepareImage), until Finalize()
+	std::vector<unsigned char> atlasPixels;
+	//var: region. where the image is, set in Finalize()
+	AtlasRegion region;
+	//var: copyId. the copy of an atlas region for GetTextureId(), or the id of the replaced texture after a reload
+	GLuint copyId;
+	//var: givenId. the id GetTextureId() gave out, 0 if it was never called
+	GLuint givenId;
+	//var: cooked. the scaled image with its mip levels, until Finalize() uploads it
+	TextureCache::Image cooked;
+	static std::atomic<int> maxSize;
 	static GLuint boundTexture;
+	static GLuint placeholderTexture;
+	static GLuint fallbackTexture;
 };
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(TextureResource)
 D2DCLASS_SCRIPTINFO_PARENTINFO(Resource, TextureResource)
@@ -358,17 +1080,26 @@ D2DCLASS_SCRIPTINFO_MEMBER(TextureResource, GetTextureId)
 D2DCLASS_SCRIPTINFO_END
 
 //class: XMLResource
-//note: stores script. //TODO: dont be a dummy!
+//note: stores a xml document. It is kept as HoardXML::CompactDocument, a modifiable HoardXML::Document is only created when someone asks for it.
 class XMLResource : public Resource
 {
 public:
 	XMLResource();
 	XMLResource(std::string name, std::string file);
+	XMLResource(const XMLResource& other);
 	~XMLResource();
 
+	//function: GetCompactDocument
+	//note: returns the read-only document. Use this whenever possible.
+	const HoardXML::CompactDocument& GetCompactDocument() const;
+	//function: GetDocument
+	//note: returns a modifiable copy of the document, created on first call. Changes are not visible in GetCompactDocument.
 	HoardXML::Document& GetDocument();
+protected:
+	bool Decode();
 private:
-	HoardXML::Document document;
+	HoardXML::CompactDocument compactDocument;
+	std::unique_ptr<HoardXML::Document> document;
 };
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(XMLResource)
 D2DCLASS_SCRIPTINFO_PARENTINFO(Resource, XMLResource)
@@ -385,9 +1116,19 @@ public:
 	~FontResource();
 
 	TTF_Font* GetFont(int size);
+	//function: GetGlyphAtlas
+	//note: returns the glyph atlas of the font at "size", nullptr if the font can not be opened
+	GlyphAtlas* GetGlyphAtlas(int size);
+protected:
+	bool Decode();
+	bool Finalize();
 private:
 	std::map<int,TTF_Font*>		font;
-	SDL_RWops*					fontFile;
+	//var: glyphAtlas. the glyphs of each size. shared, so copies of the resource stay copyable
+	std::map<int, std::shared_ptr<GlyphAtlas>> glyphAtlas;
+	//var: fontData, fontSize. the font file, copied by Decode()
+	const char*					fontData;
+	std::size_t					fontSize;
 };
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(FontResource)
 D2DCLASS_SCRIPTINFO_PARENTINFO(Resource, FontResource)
@@ -407,10 +1148,54 @@ public:
 	GLuint GetProgramId() const;
 	void Use();
 	GLuint operator[](std::string uniformName);
+	//function: IsInstanced
+	//note: returns true if the program takes sprites as instance attributes ("instancePosition" and "instanceOffset"), see SpriteBatch
+	bool IsInstanced() const;
+	//function: ResetBinding
+	//note: forgets which program is used. Call it after using programs without Use().
+	static void ResetBinding();
+
+	//function: GetUniformId
+	//note: Returns a small id for an uniform name, the same for all programs. Get it once (i.e. in a static var), GetUniform() with it does not look up any string.
+	static std::uint32_t GetUniformId(std::string uniformName);
+	//function: GetUniform
+	//note: returns the location of the uniform with the id from GetUniformId(), -1 if the program does not have it
+	GLuint GetUniform(std::uint32_t uniformId);
+
+	//function: DetectDriver
+	//note: reads the driver strings the program binaries are checked against. Called by the ResourceManager.
+	static void DetectDriver();
+protected:
+	bool Decode();
+	bool Finalize();
 private:
+	//function: _FindConfigs
+	//note: finds the CONFIG_ makros of source that are not commented out
+	void _FindConfigs();
+	//function: _Compile
+	//note: compiles and links the stages of source. Returns false on errors.
+	bool _Compile();
+	//function: _ReflectUniforms
+	//note: fills uniforms with all active uniforms of the linked program, and checks the instance attributes
+	void _ReflectUniforms();
+
+	//var: source, configs. the shader source and its CONFIG_ makros, read in Decode() and compiled in Finalize()
+	std::string source;
+	std::vector<std::string> configs;
+	//var: sourceHash. hash of source, the program cache is checked against it
+	std::uint64_t sourceHash;
+	//var: binary. the cached program, mapped in Decode()
+	ProgramCache::Binary binary;
 	GLuint programId;
-	std::map<std::string, GLuint> uniforms;
+	//var: uniforms. location by uniform id, filled when the program is linked. -1 for uniforms the program does not have
+	std::vector<GLint> uniforms;
+	//var: instanced. see IsInstanced()
+	bool instanced;
 	static GLuint boundProgram;
+	//var: uniformNames. uniform name by id
+	static std::vector<std::string> uniformNames;
+	//var: driverHash. hash of the driver strings, 0 if the driver can not give program binaries
+	static std::uint64_t driverHash;
 };
 D2DCLASS_SCRIPTINFO_BEGIN_GENERAL(GLProgramResource)
 D2DCLASS_SCRIPTINFO_PARENTINFO(Resource, GLProgramResource)
@@ -425,7 +1210,7 @@ D2DCLASS_SCRIPTINFO_END
 class MapResource : public Resource
 {
 public:
-	MapResource() :Resource("invalid"){};
+	MapResource() :Resource(){};
 	MapResource(std::string name, std::string file) :Resource("invalid"){}
 	~MapResource(){}
 private:
@@ -445,6 +1230,8 @@ public:
 	~TextResource();
 
 	std::string operator[](std::string);
+protected:
+	bool Decode();
 private:
 	std::map<std::string, std::string> TextContainer;
 };
@@ -0,0 +1,394 @@
+#include "ResourcePack.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Dragon2D
+{
+	const char* ResourcePack::FileName = "game.pak";
+	const std::uint32_t ResourcePack::FLAG_COMPRESSED;
+	const std::uint32_t ResourcePack::EmptySlot;
+
+	//all offsets of files in the pack are aligned to this
+	static const std::uint64_t PackAlignment = 16;
+
+	static std::uint64_t AlignPack(std::uint64_t offset)
+	{
+		return (offset + PackAlignment - 1) & ~(PackAlignment - 1);
+	}
+
+	ResourcePack::ResourcePack()
+		: header(nullptr), entries(nullptr), slots(nullptr), names(nullptr)
+	{
+
+	}
+
+	bool ResourcePack::Open(const std::string& filename)
+	{
+		file = MappedFile::Share(filename);
+		if (!file || file->GetSize() < sizeof(Header)) {
+			file.reset();
+			return false;
+		}
+		const char* base = file->GetData();
+		header = reinterpret_cast<const Header*>(base);
+		if (!_Validate()) {
+			file.reset();
+			header = nullptr;
+			return false;
+		}
+		entries = reinterpret_cast<const Entry*>(base + header->entryOffset);
+		slots = reinterpret_cast<const std::uint32_t*>(base + header->slotOffset);
+		names = base + header->nameOffset;
+		return true;
+	}
+
+	bool ResourcePack::IsOpen() const
+	{
+		return file != nullptr;
+	}
+
+	std::size_t ResourcePack::GetFileCount() const
+	{
+		return header ? header->entryCount : 0;
+	}
+
+	std::string ResourcePack::GetPath(std::size_t index) const
+	{
+		if (index >= GetFileCount()) {
+			return std::string();
+		}
+		return std::string(names + entries[index].nameOffset, entries[index].nameLength);
+	}
+
+	bool ResourcePack::Contains(const std::string& path) const
+	{
+		return _Find(path) != nullptr;
+	}
+
+	bool ResourcePack::Read(const std::string& path, const char*& data, std::size_t& size, std::shared_ptr<const void>& owner) const
+	{
+		const Entry* entry = _Find(path);
+		if (!entry) {
+			return false;
+		}
+		const char* stored = file->GetData() + entry->offset;
+		if (!(entry->flags & FLAG_COMPRESSED)) {
+			data = stored;
+			size = (std::size_t)entry->size;
+			owner = file;
+			return true;
+		}
+		std::shared_ptr<std::vector<char>> unpacked = std::make_shared<std::vector<char>>((std::size_t)entry->size);
+		if (!Decompress(stored, (std::size_t)entry->storedSize, unpacked->data(), unpacked->size())) {
+			return false;
+		}
+		data = unpacked->data();
+		size = unpacked->size();
+		owner = unpacked;
+		return true;
+	}
+
+	bool ResourcePack::Read(const std::string& path, std::string& out) const
+	{
+		const char* data;
+		std::size_t size;
+		std::shared_ptr<const void> owner;
+		if (!Read(path, data, size, owner)) {
+			return false;
+		}
+		out.assign(data, size);
+		return true;
+	}
+
+	const ResourcePack::Entry* ResourcePack::_Find(const std::string& path) const
+	{
+		if (!header) {
+			return nullptr;
+		}
+		std::uint64_t hash = MappedFile::Hash(path.data(), path.size());
+		std::uint32_t mask = header->slotCount - 1;
+		//open addressing: walk from the home slot to the next empty one
+		for (std::uint32_t i = (std::uint32_t)hash & mask;; i = (i + 1) & mask) {
+			std::uint32_t slot = slots[i];
+			if (slot == EmptySlot) {
+				return nullptr;
+			}
+			const Entry& entry = entries[slot];
+			if (entry.hash == hash && entry.nameLength == path.size() && std::memcmp(names + entry.nameOffset, path.data(), path.size()) == 0) {
+				return &entry;
+			}
+		}
+	}
+
+	bool ResourcePack::_Validate() const
+	{
+		std::uint64_t fileSize = file->GetSize();
+		const Header& h = *header;
+		if (std::memcmp(h.magic, "D2DP", 4) != 0 || h.version != Version
+			|| h.slotCount == 0 || (h.slotCount & (h.slotCount - 1)) != 0 || h.slotCount <= h.entryCount
+			|| h.entryOffset % 8 != 0 || h.slotOffset % 4 != 0
+			|| h.entryOffset + std::uint64_t(h.entryCount) * sizeof(Entry) > fileSize
+			|| h.slotOffset + std::uint64_t(h.slotCount) * sizeof(std::uint32_t) > fileSize
+			|| h.nameOffset + h.nameBytes > fileSize) {
+			return false;
+		}
+		const Entry* e = reinterpret_cast<const Entry*>(file->GetData() + h.entryOffset);
+		for (std::uint32_t i = 0; i < h.entryCount; i++) {
+			if (std::uint64_t(e[i].nameOffset) + e[i].nameLength > h.nameBytes
+				|| e[i].offset + e[i].storedSize > fileSize
+				|| (!(e[i].flags & FLAG_COMPRESSED) && e[i].storedSize != e[i].size)) {
+				return false;
+			}
+		}
+		const std::uint32_t* s = reinterpret_cast<const std::uint32_t*>(file->GetData() + h.slotOffset);
+		for (std::uint32_t i = 0; i < h.slotCount; i++) {
+			if (s[i] != EmptySlot && s[i] >= h.entryCount) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ResourcePack::Write(const std::string& filename, std::vector<File> files, bool compress)
+	{
+		//sorted, so files of one folder are next to each other and the same folder gives the same pack
+		std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.path < b.path; });
+
+		Header h;
+		std::memcpy(h.magic, "D2DP", 4);
+		h.version = Version;
+		h.entryCount = (std::uint32_t)files.size();
+		h.slotCount = 1;
+		//at most half of the slots are used, so probe chains stay short
+		while (h.slotCount < files.size() * 2) {
+			h.slotCount *= 2;
+		}
+		h.entryOffset = AlignPack(sizeof(Header));
+		h.slotOffset = AlignPack(h.entryOffset + files.size() * sizeof(Entry));
+		h.nameOffset = AlignPack(h.slotOffset + std::uint64_t(h.slotCount) * sizeof(std::uint32_t));
+
+		std::vector<Entry> entryTable(files.size());
+		std::vector<std::uint32_t> slotTable(h.slotCount, EmptySlot);
+		std::string nameTable;
+		std::vector<std::string> stored(files.size());
+		for (std::size_t i = 0; i < files.size(); i++) {
+			Entry& e = entryTable[i];
+			std::memset(&e, 0, sizeof(Entry));
+			e.hash = MappedFile::Hash(files[i].path.data(), files[i].path.size());
+			e.nameOffset = (std::uint32_t)nameTable.size();
+			e.nameLength = (std::uint32_t)files[i].path.size();
+			nameTable += files[i].path;
+			e.size = files[i].data.size();
+			if (compress && !files[i].data.empty()) {
+				std::string packed = Compress(files[i].data.data(), files[i].data.size());
+				//only worth it if it saves something. images and sounds are compressed already
+				if (packed.size() < files[i].data.size() - files[i].data.size() / 8) {
+					e.flags |= FLAG_COMPRESSED;
+					stored[i].swap(packed);
+				}
+			}
+			if (!(e.flags & FLAG_COMPRESSED)) {
+				stored[i].swap(files[i].data);
+			}
+			e.storedSize = stored[i].size();
+
+			std::uint32_t mask = h.slotCount - 1;
+			std::uint32_t slot = (std::uint32_t)e.hash & mask;
+			while (slotTable[slot] != EmptySlot) {
+				slot = (slot + 1) & mask;
+			}
+			slotTable[slot] = (std::uint32_t)i;
+		}
+		h.nameBytes = nameTable.size();
+
+		std::uint64_t offset = AlignPack(h.nameOffset + h.nameBytes);
+		for (std::size_t i = 0; i < files.size(); i++) {
+			entryTable[i].offset = offset;
+			offset = AlignPack(offset + entryTable[i].storedSize);
+		}
+
+		//write to a temporary file and rename it, so a running game never sees half a pack
+		std::string tempName = filename + ".tmp";
+		std::FILE* out = std::fopen(tempName.c_str(), "wb");
+		if (!out) {
+			return false;
+		}
+		std::uint64_t written = 0;
+		bool ok = true;
+		auto put = [&](std::uint64_t at, const void* data, std::size_t size) {
+			static const char padding[PackAlignment] = { 0 };
+			while (ok && written < at) {
+				std::size_t pad = (std::size_t)std::min<std::uint64_t>(at - written, PackAlignment);
+				ok = std::fwrite(padding, 1, pad, out) == pad;
+				written += pad;
+			}
+			ok = ok && (size == 0 || std::fwrite(data, 1, size, out) == size);
+			written += size;
+		};
+		put(0, &h, sizeof(Header));
+		put(h.entryOffset, entryTable.data(), entryTable.size() * sizeof(Entry));
+		put(h.slotOffset, slotTable.data(), slotTable.size() * sizeof(std::uint32_t));
+		put(h.nameOffset, nameTable.data(), nameTable.size());
+		for (std::size_t i = 0; i < files.size(); i++) {
+			put(entryTable[i].offset, stored[i].data(), stored[i].size());
+		}
+		ok = std::fclose(out) == 0 && ok;
+		if (ok) {
+#ifdef _WIN32
+			//rename does not replace files on windows
+			std::remove(filename.c_str());
+#endif
+			ok = std::rename(tempName.c_str(), filename.c_str()) == 0;
+		}
+		if (!ok) {
+			std::remove(tempName.c_str());
+		}
+		return ok;
+	}
+
+	//LZ4 block format: a sequence is a token (4 bit literal length, 4 bit match length - 4), the literals, and a 2 byte offset of the match.
+	//Lengths of 15 continue in the following bytes. The last sequence only has literals.
+	static const std::size_t MinMatch = 4;
+	//the last match has to start 12 bytes before the end, the last 5 bytes are always literals
+	static const std::size_t MatchStartLimit = 12;
+	static const std::size_t LastLiterals = 5;
+	static const int HashBits = 14;
+
+	static std::uint32_t Read32(const char* p)
+	{
+		std::uint32_t v;
+		std::memcpy(&v, p, 4);
+		return v;
+	}
+
+	static void PutLength(std::string& out, std::size_t length)
+	{
+		while (length >= 255) {
+			out += (char)255;
+			length -= 255;
+		}
+		out += (char)length;
+	}
+
+	static void PutSequence(std::string& out, const char* literals, std::size_t literalLength, std::size_t offset, std::size_t matchLength)
+	{
+		std::size_t tokenLiterals = std::min<std::size_t>(literalLength, 15);
+		std::size_t tokenMatch = matchLength ? std::min<std::size_t>(matchLength - MinMatch, 15) : 0;
+		out += (char)((tokenLiterals << 4) | tokenMatch);
+		if (literalLength >= 15) {
+			PutLength(out, literalLength - 15);
+		}
+		out.append(literals, literalLength);
+		if (matchLength) {
+			out += (char)(offset & 0xFF);
+			out += (char)(offset >> 8);
+			if (matchLength - MinMatch >= 15) {
+				PutLength(out, matchLength - MinMatch - 15);
+			}
+		}
+	}
+
+	std::string ResourcePack::Compress(const char* data, std::size_t size)
+	{
+		std::string out;
+		out.reserve(size / 2 + 16);
+		std::size_t anchor = 0;
+		if (size > MatchStartLimit) {
+			//last position a match was seen for each hash, +1 so 0 means none
+			std::vector<std::uint32_t> table(std::size_t(1) << HashBits, 0);
+			std::size_t limit = size - MatchStartLimit;
+			std::size_t i = 0;
+			while (i < limit) {
+				std::uint32_t sequence = Read32(data + i);
+				std::uint32_t hash = (sequence * 2654435761U) >> (32 - HashBits);
+				std::size_t candidate = table[hash];
+				table[hash] = (std::uint32_t)(i + 1);
+				if (candidate == 0 || i - (candidate - 1) > 0xFFFF || Read32(data + candidate - 1) != sequence) {
+					i++;
+					continue;
+				}
+				candidate--;
+				std::size_t length = MinMatch;
+				while (i + length < size - LastLiterals && data[candidate + length] == data[i + length]) {
+					length++;
+				}
+				PutSequence(out, data + anchor, i - anchor, i - candidate, length);
+				i += length;
+				anchor = i;
+			}
+		}
+		PutSequence(out, data + anchor, size - anchor, 0, 0);
+		return out;
+	}
+
+	bool ResourcePack::Decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize)
+	{
+		const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+		const unsigned char* iend = ip + srcSize;
+		char* op = dst;
+		char* oend = dst + dstSize;
+		while (ip < iend) {
+			unsigned token = *ip++;
+			std::size_t literals = token >> 4;
+			if (literals == 15) {
+				unsigned b;
+				do {
+					if (ip >= iend) {
+						return false;
+					}
+					b = *ip++;
+					literals += b;
+				} while (b == 255);
+			}
+			if (literals > (std::size_t)(iend - ip) || literals > (std::size_t)(oend - op)) {
+				return false;
+			}
+			std::memcpy(op, ip, literals);
+			op += literals;
+			ip += literals;
+			if (ip == iend) {
+				//the last sequence has no match
+				break;
+			}
+
+			if (iend - ip < 2) {
+				return false;
+			}
+			std::size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (std::size_t)(op - dst)) {
+				return false;
+			}
+			std::size_t length = token & 15;
+			if (length == 15) {
+				unsigned b;
+				do {
+					if (ip >= iend) {
+						return false;
+					}
+					b = *ip++;
+					length += b;
+				} while (b == 255);
+			}
+			length += MinMatch;
+			if (length > (std::size_t)(oend - op)) {
+				return false;
+			}
+			//matches can overlap the bytes they produce, so copy byte by byte then
+			const char* match = op - offset;
+			if (offset >= length) {
+				std::memcpy(op, match, length);
+				op += length;
+			}
+			else {
+				for (std::size_t i = 0; i < length; i++) {
+					*op++ = match[i];
+				}
+			}
+		}
+		return op == oend;
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+namespace Dragon2D
+{
+	class MappedFile;
+
+	//class: ResourcePack
+	//note: All files of a game in one file. Files are found by their path in the game folder (i.e. "texture/BaseTileset.png") with a hash table, so a lookup does not depend on the number of files.
+	//note: The pack is memory mapped once. Uncompressed files are used right from the mapping, compressed ones (LZ4 block format) are unpacked when they are read.
+	//note: Build packs with "make gamepack" (source/tools/PackTool.cpp).
+	class ResourcePack
+	{
+	public:
+		//const: FileName
+		//note: name of the pack in the game folder
+		static const char* FileName;
+		//const: Version
+		//note: Version of the pack format. Increase when Header or Entry change.
+		static const std::uint32_t Version = 1;
+
+		//struct: File
+		//note: a file to put into a pack by Write()
+		struct File
+		{
+			std::string path;
+			std::string data;
+		};
+
+		//constructor: ResourcePack
+		//note: creates a closed pack
+		ResourcePack();
+
+		//function: Open
+		//note: Opens the pack "filename". Returns false if it does not exist or is damaged.
+		bool Open(const std::string& filename);
+		//function: IsOpen
+		//note: returns true if a pack is open
+		bool IsOpen() const;
+
+		//function: GetFileCount
+		//note: returns the number of files in the pack
+		std::size_t GetFileCount() const;
+		//function: GetPath
+		//note: returns the path of the index-th file
+		std::string GetPath(std::size_t index) const;
+		//function: Contains
+		//note: returns true if the pack contains "path"
+		bool Contains(const std::string& path) const;
+
+		//function: Read
+		//note: Gets the content of "path" without copying it if possible. Returns false if the file is not in the pack (or damaged).
+		//note: data stays valid as long as owner (or the pack) lives. Thread safe.
+		//param:	path: path of the file in the game folder
+		//		data, size: get the content
+		//		owner: keeps data alive
+		bool Read(const std::string& path, const char*& data, std::size_t& size, std::shared_ptr<const void>& owner) const;
+		//function: Read
+		//note: Copies the content of "path" to out. Returns false if the file is not in the pack.
+		bool Read(const std::string& path, std::string& out) const;
+
+		//function: Write
+		//note: Writes a pack containing files. Returns false if the file can not be written.
+		//param:	filename: the pack to write
+		//		files: the files to pack
+		//		compress: compress files (only the ones that get smaller by it)
+		static bool Write(const std::string& filename, std::vector<File> files, bool compress);
+
+		//function: Compress
+		//note: compresses size bytes at data in LZ4 block format
+		static std::string Compress(const char* data, std::size_t size);
+		//function: Decompress
+		//note: Decompresses LZ4 block data. Returns false if src is damaged or does not unpack to exactly dstSize bytes.
+		static bool Decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize);
+
+	private:
+		//struct: Header
+		//note: starts the pack. Entries, hash slots, names and the file data follow.
+		struct Header
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint32_t entryCount;
+			std::uint32_t slotCount;
+			std::uint64_t entryOffset;
+			std::uint64_t slotOffset;
+			std::uint64_t nameOffset;
+			std::uint64_t nameBytes;
+		};
+
+		//struct: Entry
+		//note: describes one file
+		struct Entry
+		{
+			std::uint64_t hash;
+			std::uint64_t offset;
+			std::uint64_t size;
+			std::uint64_t storedSize;
+			std::uint32_t nameOffset;
+			std::uint32_t nameLength;
+			std::uint32_t flags;
+			std::uint32_t reserved;
+		};
+
+		//const: FLAG_COMPRESSED
+		//note: the file is stored LZ4 compressed
+		static const std::uint32_t FLAG_COMPRESSED = 1;
+		//const: EmptySlot
+		//note: marks unused hash slots
+		static const std::uint32_t EmptySlot = 0xFFFFFFFF;
+
+		//function: _Find
+		//note: returns the entry of path, or nullptr
+		const Entry* _Find(const std::string& path) const;
+		//function: _Validate
+		//note: checks that all tables and entries are inside the file
+		bool _Validate() const;
+
+		std::shared_ptr<const MappedFile> file;
+		const Header* header;
+		const Entry* entries;
+		const std::uint32_t* slots;
+		const char* names;
+	};
+}
@@ -14,13 +14,20 @@ namespace Dragon2D
 		}
 		activeEngine = this;
 		LoadClasses(chai);
-		std::fstream runfile;
-		Env::Gamefile("script/run.chai", std::ios::in, runfile);
-		if (!runfile.is_open()) {
+		//changed scripts are evaluated again, if the ResourceManager watches the files
+		reloadListener = Env::GetResourceManager().AddReloadListener([this](const std::string& file) {
+			const std::string folder = "script/", extension = ".chai";
+			if (file.size() > folder.size() + extension.size() && file.compare(0, folder.size(), folder) == 0
+				&& file.compare(file.size() - extension.size(), extension.size(), extension) == 0) {
+				_ReloadScript(file.substr(folder.size(), file.size() - folder.size() - extension.size()));
+			}
+		});
+		//from the game.pak if the game has one
+		std::string filestring;
+		if (!Env::ReadGamefile("script/run.chai", filestring)) {
 			throw ScriptEngineException("Can open runfile. Is there a script/run.chai?");
 		}
 
-		std::string filestring = std::string(std::istreambuf_iterator<char>(runfile), std::istreambuf_iterator<char>());
 		try {
 			chai.eval(filestring);
 			chai.eval("Init()");
@@ -59,6 +66,7 @@ namespace Dragon2D
 
 	ScriptEngine::~ScriptEngine()
 	{
+		Env::GetResourceManager().RemoveReloadListener(reloadListener);
 		chai.eval("Stop()");
 		activeEngine = nullptr;
 	}
@@ -91,21 +99,109 @@ namespace Dragon2D
 		}
 		knownFiles.push_back(name);
 
-		std::fstream includefile;
-		Env::Gamefile(std::string("script/")+name+".chai", std::ios::in, includefile);
-		if (!includefile.is_open()) {
-			Env::Err() << "WARNING: cannot open script " << name << std::endl;
+		std::string filestring;
+		if (_ReadScript(name, filestring)) {
+			scriptClasses[name] = _FindClasses(filestring);
+			_RawEval(filestring, "script/" + name + ".chai");
+		}
+	}
+
+	void ScriptEngine::ReloadScript(std::string name)
+	{
+		if (activeEngine == nullptr) {
+			throw ScriptEngineException("Cannot reload script without valid engine!");
+		}
+
+		activeEngine->_ReloadScript(name);
+	}
+
+	void ScriptEngine::_ReloadScript(std::string name)
+	{
+		if (std::find(knownFiles.begin(), knownFiles.end(), name) == knownFiles.end()) {
+			return;
+		}
+		std::string filestring;
+		if (!_ReadScript(name, filestring)) {
 			return;
 		}
-		std::string filestring = std::string(std::istreambuf_iterator<char>(includefile), std::istreambuf_iterator<char>());
-		_RawEval(filestring);
-		
+		std::string filename = "script/" + name + ".chai";
+		const std::set<std::string>& classes = scriptClasses[name];
+		//chaiscript does not allow to define a function twice, so the ones of the old script go first
+		chaiscript::ChaiScript::State state = chai.get_state();
+		auto& functions = state.engine_state.m_functions;
+		auto& functionObjects = state.engine_state.m_function_objects;
+		for (auto f = functions.begin(); f != functions.end();) {
+			auto& overloads = f->second;
+			std::size_t count = overloads.size();
+			//constructors keep their function to themselves, they are found by the name of their class
+			bool isClass = classes.count(f->first) > 0;
+			overloads.erase(std::remove_if(overloads.begin(), overloads.end(), [&](const chaiscript::Proxy_Function& o) {
+				return _DefinedIn(o, filename) || (isClass && std::dynamic_pointer_cast<const chaiscript::dispatch::detail::Dynamic_Object_Constructor>(o));
+			}), overloads.end());
+			if (overloads.size() == count) {
+				f++;
+				continue;
+			}
+			//the function object of a name dispatches to all its overloads, it is built like Dispatch_Engine::add_function does
+			if (overloads.empty()) {
+				functionObjects.erase(f->first);
+				f = functions.erase(f);
+				continue;
+			}
+			if (overloads.size() == 1 && !overloads.front()->has_arithmetic_param()) {
+				functionObjects[f->first] = overloads.front();
+			}
+			else {
+				functionObjects[f->first] = std::make_shared<chaiscript::detail::Dispatch_Function>(overloads);
+			}
+			f++;
+		}
+		chai.set_state(state);
+		Env::Out() << "Reloading script " << name << std::endl;
+		scriptClasses[name] = _FindClasses(filestring);
+		_RawEval(filestring, filename);
+	}
+
+	bool ScriptEngine::_ReadScript(std::string name, std::string& script)
+	{
+		if (!Env::ReadGamefile(std::string("script/")+name+".chai", script)) {
+			Env::Err() << "WARNING: cannot open script " << name << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	std::set<std::string> ScriptEngine::_FindClasses(const std::string& script)
+	{
+		//"class Name {" and the old "def Name::Name(" for constructors outside of a class block
+		std::set<std::string> classes;
+		std::regex classDefinition("\\bclass\\s+(\\w+)|\\bdef\\s+(\\w+)::\\2\\s*\\(");
+		for (std::sregex_iterator m(script.begin(), script.end(), classDefinition), end; m != end; m++) {
+			classes.insert((*m)[1].matched ? (*m)[1].str() : (*m)[2].str());
+		}
+		return classes;
+	}
+
+	bool ScriptEngine::_DefinedIn(const chaiscript::Const_Proxy_Function& f, const std::string& filename)
+	{
+		auto scriptFunction = std::dynamic_pointer_cast<const chaiscript::dispatch::Dynamic_Proxy_Function>(f);
+		if (scriptFunction) {
+			chaiscript::AST_NodePtr tree = scriptFunction->get_parse_tree();
+			return tree && tree->filename() == filename;
+		}
+		//methods of script classes wrap the script function
+		for (auto& contained : f->get_contained_functions()) {
+			if (_DefinedIn(contained, filename)) {
+				return true;
+			}
+		}
+		return false;
 	}
 
-	void ScriptEngine::_RawEval(std::string command)
+	void ScriptEngine::_RawEval(std::string command, std::string filename)
 	{
 		try {
-			chai.eval(command);
+			chai.eval(command, chaiscript::Exception_Handler(), filename);
 		}
 		catch (chaiscript::exception::eval_error e) {
 			Env::Err() << e.what() << std::endl;
@@ -2,6 +2,8 @@
 
 #include "Env.h"
 #include "ScriptLibHelper.h"
+
+#include <set>
 //Heders of everything used within the engine, so it can be piped into chaiscript
 
 namespace Dragon2D
@@ -27,6 +29,12 @@ namespace Dragon2D
 		//note: includes a script file and evals it
 		static void IncludeScript(std::string name);
 
+		//function: ReloadScript
+		//note: Evals an included script again, after its file changed. The functions it defined before are removed first, so they can be defined again. Code outside of functions runs again, too.
+		//note: Called for changed scripts when the ResourceManager watches the files. Scripts that were never included (and run.chai) are left alone.
+		//param:	name: the script, like for IncludeScript()
+		static void ReloadScript(std::string name);
+
 		//function: RawEval
 		//note: evals a script 
 		//param:	command: the stuff to eval. should be chaiscript.
@@ -42,9 +50,27 @@ namespace Dragon2D
 		static ScriptEngine* activeEngine;
 		//var: knownFiles. Holds names of the included files. used to avoid inlcludes breaking the engine
 		std::vector<std::string> knownFiles;
+		//var: reloadListener. id of the reload listener at the ResourceManager
+		int reloadListener;
+		//var: scriptClasses. the classes each included script defines. Their constructors do not know their script, see _DefinedIn()
+		std::map<std::string, std::set<std::string>> scriptClasses;
 	protected:
 		void _IncludeScript(std::string name);
-		void _RawEval(std::string command);
+		//function: _ReloadScript
+		//note: see ReloadScript()
+		void _ReloadScript(std::string name);
+		//function: _RawEval
+		//note: evals command. Functions defined in it remember filename, so _ReloadScript() can find them.
+		void _RawEval(std::string command, std::string filename = "__EVAL__");
+		//function: _ReadScript
+		//note: reads script/name.chai. Returns false if it can not be opened.
+		bool _ReadScript(std::string name, std::string& script);
+		//function: _FindClasses
+		//note: returns the names of the classes script defines
+		static std::set<std::string> _FindClasses(const std::string& script);
+		//function: _DefinedIn
+		//note: returns true if the script function f was defined by the script in filename. Does not work for constructors, see scriptClasses.
+		static bool _DefinedIn(const chaiscript::Const_Proxy_Function& f, const std::string& filename);
 	};
 
 	//class: ScriptEngine
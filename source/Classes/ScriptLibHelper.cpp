@@ -30,6 +30,7 @@ namespace Dragon2D {
 		//Script engine foo
 		SCRIPTFUNCTION_ADD(ScriptEngine::IncludeScript, "Include", chai);
 		SCRIPTFUNCTION_ADD(ScriptEngine::RawEval, "RawEval", chai);
+		SCRIPTFUNCTION_ADD(ScriptEngine::ReloadScript, "ReloadScript", chai);
 		SCRIPTTYPE_ADD(std::ostream, "ostream", chai);
 		//Some stuff		
 		SCRIPTFUNCTION_ADD(StrToInt, "StrToInt", chai);
@@ -42,6 +43,8 @@ namespace Dragon2D {
 		SCRIPTFUNCTION_ADD(Env::ClearFramebuffer, "ClearScreen", chai);
 		SCRIPTFUNCTION_ADD(Env::ResetCurrentTextInput, "ResetCurrentTextInput", chai);
 		SCRIPTFUNCTION_ADD(Env::GetCurrentText, "GetCurrentText", chai);
+		SCRIPTFUNCTION_ADD(Env::GetDrawCalls, "GetDrawCalls", chai);
+		SCRIPTFUNCTION_ADD(Env::GetDrawnQuads, "GetDrawnQuads", chai);
 		//Base Types
 		SCRIPTCLASS_ADD(vec4, chai);
 		SCRIPTCLASS_ADD(XMLUI, chai);
@@ -8,6 +8,7 @@ namespace Dragon2D
 		: programName("defaultSprite"), textureName(), textureOffset(.0f, .0f, 1.f, 1.f)
 	{
 		Env::GetResourceManager().RequestGLProgramResource(programName);
+		programHandle = Env::GetResourceManager().GetGLProgramHandle(programName);
 	}
 
 	Sprite::Sprite(std::string name)
@@ -15,6 +16,8 @@ namespace Dragon2D
 	{
 		Env::GetResourceManager().RequestGLProgramResource(programName);
 		Env::GetResourceManager().RequestTextureResource(textureName);
+		programHandle = Env::GetResourceManager().GetGLProgramHandle(programName);
+		textureHandle = Env::GetResourceManager().GetTextureHandle(textureName);
 	}
 
 	Sprite::Sprite(std::string name, std::string program)
@@ -22,6 +25,8 @@ namespace Dragon2D
 	{
 		Env::GetResourceManager().RequestGLProgramResource(programName);
 		Env::GetResourceManager().RequestTextureResource(textureName);
+		programHandle = Env::GetResourceManager().GetGLProgramHandle(programName);
+		textureHandle = Env::GetResourceManager().GetTextureHandle(textureName);
 	}
 
 	Sprite::~Sprite()
@@ -35,6 +40,7 @@ namespace Dragon2D
 		Env::GetResourceManager().FreeGLProgramResource(programName);
 		programName = program;
 		Env::GetResourceManager().RequestGLProgramResource(programName);
+		programHandle = Env::GetResourceManager().GetGLProgramHandle(programName);
 	}
 
 	void Sprite::UseTexture(std::string texture)
@@ -42,6 +48,7 @@ namespace Dragon2D
 		Env::GetResourceManager().FreeTextureResource(textureName);
 		textureName = texture;
 		Env::GetResourceManager().RequestTextureResource(textureName);
+		textureHandle = Env::GetResourceManager().GetTextureHandle(textureName);
 	}
 
 	void Sprite::SetOffset(glm::vec4 offset)
@@ -56,16 +63,12 @@ namespace Dragon2D
 	
 	void Sprite::Render()
 	{
-		TextureResource &t = Env::GetResourceManager().GetTextureResource(textureName);
-		GLProgramResource &p = Env::GetResourceManager().GetGLProgramResource(programName);
+		TextureResource &t = Env::GetResourceManager().Get(textureHandle);
+		GLProgramResource &p = Env::GetResourceManager().Get(programHandle);
 
-		p.Use();
-		glUniform4f(p["position"], position[0], position[1], position[2], position[3]);
-		glUniform4f(p["offset"], textureOffset[0], textureOffset[1], textureOffset[2], textureOffset[3]);
-		glActiveTexture(GL_TEXTURE0);
-		t.Bind();
-		glUniform1i(p["textureSampler"], 0);
-		Env::RenderQuad();
+		//the texture might be a region of an atlas page. Sprites on the same page are drawn together
+		AtlasRegion region = t.GetAtlasRegion();
+		Env::GetSpriteBatch().Add(p, region.texture, position, region.MapOffset(textureOffset));
 
 		BaseClass::Render();
 	}
@@ -1,6 +1,7 @@
 #pragma once
 #include "base.h"
 #include "GameObject.h"
+#include "ResourceManager.h"
 
 namespace Dragon2D
 {
@@ -46,9 +47,13 @@ namespace Dragon2D
 		virtual glm::vec4 GetOffset();
 
 		//function: Render
-		//note: Renders the sprite.
+		//note: Renders the sprite. The quad goes into the SpriteBatch, it is drawn when the batch is flushed.
 		virtual void Render() override;
 
+	protected:
+		//var: textureHandle, programHandle. handles of textureName and programName, so rendering does not look up the names
+		ResourceHandle<TextureResource> textureHandle;
+		ResourceHandle<GLProgramResource> programHandle;
 	private:
 		std::string programName;
 		std::string textureName;
@@ -0,0 +1,158 @@
+#include "SpriteBatch.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	SpriteBatch::SpriteBatch(GLuint quadVertices)
+		: layer(0), quadBuffer(quadVertices), instanceBuffer(0), instanceCapacity(0), drawCalls(0), quadCount(0), lastDrawCalls(0), lastQuadCount(0)
+	{
+		glGenBuffers(1, &instanceBuffer);
+	}
+
+	SpriteBatch::~SpriteBatch()
+	{
+		glDeleteBuffers(1, &instanceBuffer);
+	}
+
+	void SpriteBatch::Add(GLProgramResource& program, GLuint texture, const glm::vec4& position, const glm::vec4& offset)
+	{
+		//programs that are loading (or failed) draw nothing
+		if (program.GetProgramId() == 0) {
+			return;
+		}
+		Quad quad;
+		quad.layer = layer;
+		quad.program = &program;
+		quad.texture = texture;
+		quad.position = position;
+		quad.offset = offset;
+		quads.push_back(quad);
+	}
+
+	void SpriteBatch::NextLayer()
+	{
+		layer++;
+	}
+
+	void SpriteBatch::Flush()
+	{
+		if (quads.empty()) {
+			return;
+		}
+		//the layers keep their order, within a layer equal programs and textures come together. Stable, so equal quads stay in the order they were added
+		std::stable_sort(quads.begin(), quads.end(), [](const Quad& a, const Quad& b) {
+			if (a.layer != b.layer) {
+				return a.layer < b.layer;
+			}
+			if (a.program != b.program) {
+				return std::less<GLProgramResource*>()(a.program, b.program);
+			}
+			return a.texture < b.texture;
+		});
+
+		//all instances go up at once, the draw calls only point at their part
+		instances.clear();
+		instances.reserve(quads.size() * 2);
+		for (auto& quad : quads) {
+			instances.push_back(quad.position);
+			instances.push_back(quad.offset);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		if (instances.size() > instanceCapacity) {
+			instanceCapacity = std::max(instances.size(), instanceCapacity * 2);
+		}
+		//a new store every flush, so the driver does not wait for the draws of the last one
+		glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::vec4), &instances[0][0]);
+
+		//the ui binds its own programs and textures, the remembered bindings might be wrong
+		GLProgramResource::ResetBinding();
+		TextureResource::ResetBinding();
+		glActiveTexture(GL_TEXTURE0);
+
+		glEnableVertexAttribArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribDivisor(1, 1);
+		glVertexAttribDivisor(2, 1);
+		std::size_t first = 0;
+		for (std::size_t i = 1; i <= quads.size(); i++) {
+			if (i == quads.size() || quads[i].program != quads[first].program || quads[i].texture != quads[first].texture || quads[i].layer != quads[first].layer) {
+				_Draw(first, i);
+				first = i;
+			}
+		}
+		//tiles and glyph texts use attribute 1 per vertex
+		glVertexAttribDivisor(1, 0);
+		glVertexAttribDivisor(2, 0);
+		glDisableVertexAttribArray(2);
+		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(0);
+
+		quadCount += (int)quads.size();
+		quads.clear();
+	}
+
+	void SpriteBatch::EndFrame()
+	{
+		Flush();
+		lastDrawCalls = drawCalls;
+		lastQuadCount = quadCount;
+		drawCalls = 0;
+		quadCount = 0;
+		layer = 0;
+	}
+
+	void SpriteBatch::CountDrawCalls(int calls)
+	{
+		drawCalls += calls;
+	}
+
+	int SpriteBatch::GetDrawCalls() const
+	{
+		return lastDrawCalls;
+	}
+
+	int SpriteBatch::GetQuads() const
+	{
+		return lastQuadCount;
+	}
+
+	void SpriteBatch::_Draw(std::size_t first, std::size_t last)
+	{
+		static const std::uint32_t positionUniform = GLProgramResource::GetUniformId("position");
+		static const std::uint32_t offsetUniform = GLProgramResource::GetUniformId("offset");
+		static const std::uint32_t samplerUniform = GLProgramResource::GetUniformId("textureSampler");
+		GLProgramResource& p = *quads[first].program;
+		p.Use();
+		glUniform1i(p.GetUniform(samplerUniform), 0);
+		TextureResource::BindTexture(quads[first].texture);
+		if (p.IsInstanced()) {
+			_SetInstances(first);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)(last - first));
+			drawCalls++;
+			return;
+		}
+		//a program of its own that still takes the sprite as uniforms
+		for (std::size_t i = first; i < last; i++) {
+			const glm::vec4& position = quads[i].position;
+			const glm::vec4& offset = quads[i].offset;
+			glUniform4f(p.GetUniform(positionUniform), position[0], position[1], position[2], position[3]);
+			glUniform4f(p.GetUniform(offsetUniform), offset[0], offset[1], offset[2], offset[3]);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			drawCalls++;
+		}
+	}
+
+	void SpriteBatch::_SetInstances(std::size_t first)
+	{
+		//position and offset of a quad follow each other
+		const GLsizei stride = sizeof(glm::vec4) * 2;
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(first * stride));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(first * stride + sizeof(glm::vec4)));
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "base.h"
+#include "ResourceManager.h"
+
+namespace Dragon2D
+{
+	//class: SpriteBatch
+	//note: Collects the quads of all sprites (tilesets, players, ...) while the objects are rendered, and draws them in Flush(): sorted by render layer, program and texture (the atlas page), every run of equal program and texture with one instanced draw call.
+	//note: Programs with the instance attributes (location 1 "instancePosition", location 2 "instanceOffset", like defaultSprite) are drawn instanced. Programs with the old "position" and "offset" uniforms still work, they get one draw call per quad.
+	//note: Everything that draws by itself (maps, ui, ...) has to call Flush() first, so the sprites below it are drawn before it. Env::SwapBuffers() flushes at the end of every frame.
+	class SpriteBatch
+	{
+	public:
+		//constructor: SpriteBatch
+		//param:	quadBuffer: the vertex buffer of Env::RenderQuad(), the corners of every quad
+		SpriteBatch(GLuint quadBuffer);
+		~SpriteBatch();
+
+		SpriteBatch(const SpriteBatch&) = delete;
+		SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+		//function: Add
+		//note: adds a quad, drawn by the next Flush()
+		//param:	program: the program of the sprite. Must stay loaded until the flush (resources are only freed in ResourceManager::Update())
+		//		texture: the GL texture (the atlas page)
+		//		position: x, y, width, height on the screen, like the "position" uniform of the sprites
+		//		offset: the region on texture, like the "offset" uniform
+		void Add(GLProgramResource& program, GLuint texture, const glm::vec4& position, const glm::vec4& offset);
+		//function: NextLayer
+		//note: Starts the next render layer. Called by the render traversal for every layer, quads are only sorted within a layer, so they never move above or below a quad of another layer.
+		void NextLayer();
+		//function: Flush
+		//note: draws the collected quads
+		void Flush();
+		//function: EndFrame
+		//note: flushes and starts the draw call counts of the next frame. Called by Env::SwapBuffers().
+		void EndFrame();
+
+		//function: CountDrawCalls
+		//note: counts draw calls made outside the batch (tiles, glyph texts, Env::RenderQuad()), so GetDrawCalls() has the whole frame
+		void CountDrawCalls(int calls = 1);
+		//function: GetDrawCalls
+		//note: returns the draw calls of the last frame. The elements of TailTipUI do not count theirs.
+		int GetDrawCalls() const;
+		//function: GetQuads
+		//note: returns the quads the batch drew in the last frame
+		int GetQuads() const;
+	private:
+		//class: Quad
+		//note: a quad waiting for Flush()
+		struct Quad
+		{
+			unsigned int layer;
+			GLProgramResource* program;
+			GLuint texture;
+			glm::vec4 position;
+			glm::vec4 offset;
+		};
+
+		//function: _Draw
+		//note: draws the quads [first, last) that have the same program and texture
+		void _Draw(std::size_t first, std::size_t last);
+		//function: _SetInstances
+		//note: points the instance attributes at the instance first of the instance buffer
+		void _SetInstances(std::size_t first);
+
+		//var: quads. the quads of this flush
+		std::vector<Quad> quads;
+		//var: instances. position and offset of the sorted quads, uploaded to instanceBuffer
+		std::vector<glm::vec4> instances;
+		//var: layer. the current render layer, counted up by NextLayer()
+		unsigned int layer;
+		GLuint quadBuffer;
+		//var: instanceBuffer, instanceCapacity. the instance attributes, and how many vec4 fit in it
+		GLuint instanceBuffer;
+		std::size_t instanceCapacity;
+		//var: drawCalls, quadCount. counts of this frame
+		int drawCalls;
+		int quadCount;
+		//var: lastDrawCalls, lastQuadCount. counts of the last frame
+		int lastDrawCalls;
+		int lastQuadCount;
+	};
+}
@@ -0,0 +1,115 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	const int StreamBuffer::Segments;
+
+	//bytes of a part when the buffer is created, a thousand tiles
+	static const std::size_t InitialSegmentSize = 64 * 1024;
+
+	StreamBuffer::StreamBuffer()
+		: buffer(0), segmentSize(0), segment(0), persistent(nullptr)
+	{
+		for (auto& fence : fences) {
+			fence = nullptr;
+		}
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		_Release();
+	}
+
+	void* StreamBuffer::Map(std::size_t size)
+	{
+		if (size > segmentSize || buffer == 0) {
+			_Release();
+			_Allocate(std::max(size, std::max(segmentSize * 2, InitialSegmentSize)));
+		}
+		//three frames ago, the GPU is done with it in all but the worst cases
+		_Wait(segment);
+		std::size_t offset = segment * segmentSize;
+		if (persistent) {
+			return persistent + offset;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		//the fence says the GPU is done with the part, the driver does not have to check again
+		return glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	std::size_t StreamBuffer::Unmap()
+	{
+		if (!persistent) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		return segment * segmentSize;
+	}
+
+	void StreamBuffer::Fence()
+	{
+		if (fences[segment]) {
+			glDeleteSync(fences[segment]);
+		}
+		fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		segment = (segment + 1) % Segments;
+	}
+
+	GLuint StreamBuffer::GetBuffer() const
+	{
+		return buffer;
+	}
+
+	void StreamBuffer::_Allocate(std::size_t partSize)
+	{
+		segmentSize = partSize;
+		segment = 0;
+		std::size_t size = segmentSize * Segments;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		if (GLEW_ARB_buffer_storage) {
+			//coherent: what is written is seen by the next draw, without flushing
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+			persistent = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+			if (persistent) {
+				return;
+			}
+			//the driver has the extension, but can not map it: start again without
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		}
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	}
+
+	void StreamBuffer::_Release()
+	{
+		for (int i = 0; i < Segments; i++) {
+			_Wait(i);
+		}
+		if (persistent) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			persistent = nullptr;
+		}
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+
+	void StreamBuffer::_Wait(int part)
+	{
+		if (!fences[part]) {
+			return;
+		}
+		GLenum result = glClientWaitSync(fences[part], 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED) {
+			//the commands might still wait in the driver, flush them so the fence can be reached
+			result = glClientWaitSync(fences[part], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fences[part]);
+		fences[part] = nullptr;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "base.h"
+
+namespace Dragon2D
+{
+	//class: StreamBuffer
+	//note: A vertex buffer for data that is written again every frame. The buffer is a ring of Segments parts used in turn, each with a fence, so writing waits only if the GPU still reads that part and the buffer is never reallocated by the driver (like it is with glBufferData every frame).
+	//note: With ARB_buffer_storage the buffer stays mapped (persistent and coherent), else every part is mapped unsynchronized when it is written.
+	//note: Meant for data that is drawn once per frame, using more then Segments parts per frame waits for the GPU.
+	class StreamBuffer
+	{
+	public:
+		//const: Segments
+		//note: the parts of the ring, one written by the CPU while the GPU reads the others
+		static const int Segments = 3;
+
+		StreamBuffer();
+		~StreamBuffer();
+
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		//function: Map
+		//note: Returns memory to write size bytes to, in the next part of the ring. The buffer grows if size does not fit in a part (that waits for the GPU once). Returns nullptr (and Unmap() must not be called) if the driver can not map the buffer.
+		void* Map(std::size_t size);
+		//function: Unmap
+		//note: ends writing, returns the offset of the written data in the buffer (for glVertexAttribPointer)
+		std::size_t Unmap();
+		//function: Fence
+		//note: Call it after the draws that read the data. The part is written again once the GPU is past them.
+		void Fence();
+		//function: GetBuffer
+		//note: returns the GL buffer. It changes when the buffer grows, so get it after Map().
+		GLuint GetBuffer() const;
+	private:
+		//function: _Allocate
+		//note: creates the buffer with parts of partSize bytes
+		void _Allocate(std::size_t partSize);
+		//function: _Release
+		//note: waits for all parts and deletes the buffer
+		void _Release();
+		//function: _Wait
+		//note: waits until the GPU is done with part
+		void _Wait(int part);
+
+		GLuint buffer;
+		//var: segmentSize. bytes of a part
+		std::size_t segmentSize;
+		//var: segment. the part written next
+		int segment;
+		//var: fences. one for each part, nullptr if the GPU does not read it
+		GLsync fences[Segments];
+		//var: persistent. the mapped buffer with ARB_buffer_storage, nullptr without
+		char* persistent;
+	};
+}
@@ -0,0 +1,139 @@
+#include "TextCache.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	std::vector<TextCache*> TextCache::caches;
+
+	TextCache::Texture::Texture(GLuint textTexture, int textWidth, int textHeight)
+		: texture(textTexture), width(textWidth), height(textHeight)
+	{
+
+	}
+
+	TextCache::Texture::~Texture()
+	{
+		glDeleteTextures(1, &texture);
+	}
+
+	std::size_t TextCache::Texture::GetMemorySize() const
+	{
+		return std::size_t(width) * height * 4;
+	}
+
+	TextCache::TextCache(std::size_t cacheBudget)
+		: budget(cacheBudget), memorySize(0), hits(0), misses(0)
+	{
+		caches.push_back(this);
+	}
+
+	TextCache::~TextCache()
+	{
+		caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+	}
+
+	std::shared_ptr<const TextCache::Texture> TextCache::Get(TTF_Font* font, glm::vec4 color, const std::string& text, int wrapWidth)
+	{
+		if (!font || text.empty()) {
+			return nullptr;
+		}
+		SDL_Color textColor;
+		textColor.r = Uint8(std::min(std::max(color[0], 0.0f), 1.0f) * 255.0f + 0.5f);
+		textColor.g = Uint8(std::min(std::max(color[1], 0.0f), 1.0f) * 255.0f + 0.5f);
+		textColor.b = Uint8(std::min(std::max(color[2], 0.0f), 1.0f) * 255.0f + 0.5f);
+		textColor.a = Uint8(std::min(std::max(color[3], 0.0f), 1.0f) * 255.0f + 0.5f);
+
+		//the key holds everything the texture depends on: font, color, wrap width and the text itself
+		std::string key(reinterpret_cast<const char*>(&font), sizeof(font));
+		key.append(reinterpret_cast<const char*>(&textColor), sizeof(textColor));
+		key.append(reinterpret_cast<const char*>(&wrapWidth), sizeof(wrapWidth));
+		key.append(text);
+
+		auto cached = index.find(key);
+		if (cached != index.end()) {
+			hits++;
+			entries.splice(entries.begin(), entries, cached->second);
+			return cached->second->texture;
+		}
+
+		misses++;
+		SDL_Surface* surface = wrapWidth > 0
+			? TTF_RenderUTF8_Blended_Wrapped(font, text.c_str(), textColor, Uint32(wrapWidth))
+			: TTF_RenderUTF8_Blended(font, text.c_str(), textColor);
+		if (!surface) {
+			return nullptr;
+		}
+		auto texture = std::make_shared<const Texture>(TailTipUI::SurfaceToTexture(surface), surface->w, surface->h);
+		SDL_FreeSurface(surface);
+
+		Entry entry = { key, font, texture };
+		entries.push_front(entry);
+		index[key] = entries.begin();
+		memorySize += texture->GetMemorySize();
+		_Trim();
+		return texture;
+	}
+
+	void TextCache::RemoveFont(TTF_Font* font)
+	{
+		for (TextCache* cache : caches) {
+			for (auto entry = cache->entries.begin(); entry != cache->entries.end();) {
+				entry = entry->font == font ? cache->_Remove(entry) : std::next(entry);
+			}
+		}
+	}
+
+	void TextCache::Clear()
+	{
+		entries.clear();
+		index.clear();
+		memorySize = 0;
+	}
+
+	void TextCache::SetBudget(std::size_t bytes)
+	{
+		budget = bytes;
+		_Trim();
+	}
+
+	std::size_t TextCache::GetBudget() const
+	{
+		return budget;
+	}
+
+	std::size_t TextCache::GetMemorySize() const
+	{
+		return memorySize;
+	}
+
+	std::size_t TextCache::GetCount() const
+	{
+		return entries.size();
+	}
+
+	std::uint64_t TextCache::GetHits() const
+	{
+		return hits;
+	}
+
+	std::uint64_t TextCache::GetMisses() const
+	{
+		return misses;
+	}
+
+	void TextCache::_Trim()
+	{
+		//the newest text always stays, even if it alone is larger than the budget
+		while (memorySize > budget && entries.size() > 1) {
+			_Remove(std::prev(entries.end()));
+		}
+	}
+
+	std::list<TextCache::Entry>::iterator TextCache::_Remove(std::list<Entry>::iterator entry)
+	{
+		memorySize -= entry->texture->GetMemorySize();
+		index.erase(entry->key);
+		return entries.erase(entry);
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "base.h"
+
+#include <unordered_map>
+
+namespace Dragon2D
+{
+	//class: TextCache
+	//note: Keeps rendered texts as textures, shared by all CachedText elements. A text is rendered again only if no element used it (with the same font, color and wrap width) recently.
+	//note: The least recently used textures are dropped once the textures take more than the budget. Elements that still show a dropped texture keep it until they change.
+	//note: A TTF_Font is one font at one size, so the font in the key also stands for the size.
+	class TextCache
+	{
+	public:
+		//const: DefaultBudget
+		//note: bytes of texture memory the cache keeps by default
+		static const std::size_t DefaultBudget = 16 * 1024 * 1024;
+
+		//class: Texture
+		//note: a rendered text. The texture is deleted with the last reference
+		struct Texture
+		{
+			Texture(GLuint texture, int width, int height);
+			~Texture();
+			Texture(const Texture&) = delete;
+			Texture& operator=(const Texture&) = delete;
+
+			//function: GetMemorySize
+			//note: returns the bytes of the texture
+			std::size_t GetMemorySize() const;
+
+			GLuint texture;
+			int width;
+			int height;
+		};
+
+		//constructor: TextCache
+		//param:	budget: bytes of texture memory to keep
+		TextCache(std::size_t budget = DefaultBudget);
+		~TextCache();
+
+		TextCache(const TextCache&) = delete;
+		TextCache& operator=(const TextCache&) = delete;
+
+		//function: Get
+		//note: Returns the texture of a text, rendering it if it is not cached. Returns nullptr for empty texts and texts that can not be rendered. Main thread only.
+		//param:	font: the font (and size)
+		//		color: the RGBA color of the text, 0 to 1
+		//		text: the text in UTF-8
+		//		wrapWidth: lines are wrapped at this width in pixels, 0 for one line
+		std::shared_ptr<const Texture> Get(TTF_Font* font, glm::vec4 color, const std::string& text, int wrapWidth = 0);
+
+		//function: RemoveFont
+		//note: drops the texts of a font from all caches. Call it before the font is closed, another font might get its address.
+		static void RemoveFont(TTF_Font* font);
+		//function: Clear
+		//note: drops all texts
+		void Clear();
+
+		//function: SetBudget
+		//note: sets the bytes of texture memory to keep and drops texts until they fit
+		void SetBudget(std::size_t bytes);
+		//function: GetBudget
+		//note: returns the bytes of texture memory to keep
+		std::size_t GetBudget() const;
+		//function: GetMemorySize
+		//note: returns the bytes of the cached textures
+		std::size_t GetMemorySize() const;
+		//function: GetCount
+		//note: returns the number of cached textures
+		std::size_t GetCount() const;
+		//function: GetHits
+		//note: returns how often Get() found its text in the cache
+		std::uint64_t GetHits() const;
+		//function: GetMisses
+		//note: returns how often Get() had to render its text
+		std::uint64_t GetMisses() const;
+	private:
+		//class: Entry
+		//note: a cached text
+		struct Entry
+		{
+			std::string key;
+			TTF_Font* font;
+			std::shared_ptr<const Texture> texture;
+		};
+
+		//function: _Trim
+		//note: drops the least recently used texts until the cache fits the budget
+		void _Trim();
+		//function: _Remove
+		//note: drops one text
+		std::list<Entry>::iterator _Remove(std::list<Entry>::iterator entry);
+
+		//var: entries. the texts, most recently used first
+		std::list<Entry> entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> index;
+		std::size_t budget;
+		std::size_t memorySize;
+		std::uint64_t hits;
+		std::uint64_t misses;
+
+		//var: caches. all caches, for RemoveFont()
+		static std::vector<TextCache*> caches;
+	};
+}
@@ -0,0 +1,96 @@
+#include "TextElement.h"
+
+#include <typeinfo>
+
+namespace Dragon2D
+{
+	TextElement::TextElement()
+		: dirty(true), textWidth(0), textHeight(0), widthLock(false)
+	{
+
+	}
+
+	TextElement::~TextElement()
+	{
+
+	}
+
+	void TextElement::SetName(std::string newname)
+	{
+		if (newname == name) {
+			return;
+		}
+		ChildElement::SetName(newname);
+		dirty = true;
+	}
+
+	void TextElement::SetFont(TTF_Font* newfont)
+	{
+		if (newfont == font) {
+			return;
+		}
+		ChildElement::SetFont(newfont);
+		dirty = true;
+	}
+
+	glm::vec4 TextElement::RelativePositionToParent()
+	{
+		glm::vec4 absolute = pos;
+		if (parent) {
+			glm::vec4 p = parent->RelativePositionToParent();
+			absolute = glm::vec4(p.x + pos.x * p[2], p.y + pos.y * p[3], pos[2] * p[2], pos[3] * p[3]);
+		}
+		//the height is the line, the width follows the text (pixels are square, the position is relative to the window)
+		float width = 0.0f;
+		if (textWidth > 0 && textHeight > 0) {
+			width = absolute[3] * textWidth / textHeight * TailTipUI::Info::height / TailTipUI::Info::width;
+		}
+		if (widthLock && width > absolute[2]) {
+			absolute[3] *= absolute[2] / width;
+		}
+		else {
+			absolute[2] = width;
+		}
+		if (centered) {
+			absolute.x -= absolute[2] / 2.0f;
+		}
+		return absolute;
+	}
+
+	void TextElement::SetWidthLock(bool b)
+	{
+		widthLock = b;
+	}
+
+	bool TextElement::GetWidthLock()
+	{
+		return widthLock;
+	}
+
+	TailTipUI::Text* TextElement::_GetReplaceable(TailTipUI::GeneralElement* element)
+	{
+		TailTipUI::Text* text = dynamic_cast<TailTipUI::Text*>(element);
+		if (!text || typeid(*text) != typeid(TailTipUI::Text) || !text->GetParent()) {
+			return nullptr;
+		}
+		return text;
+	}
+
+	TailTipUI::GeneralElement* TextElement::_Swap(TailTipUI::Text* text, TextElement* replacement)
+	{
+		replacement->SetId(text->GetId());
+		replacement->SetPos(text->GetPos());
+		replacement->SetCentered(text->GetCentered());
+		replacement->SetHidden(text->GetHidden());
+		replacement->SetForgroundColor(text->GetForgroundColor());
+		replacement->SetFont(text->GetFont());
+		replacement->SetWidthLock(text->GetWidthLock());
+		replacement->SetName(text->GetName());
+
+		TailTipUI::GeneralElement* textParent = text->GetParent();
+		textParent->DeattatchChild(text);
+		delete text;
+		textParent->AttatchChild(replacement);
+		return replacement;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "base.h"
+
+namespace Dragon2D
+{
+	//class: TextElement
+	//note: Base of the text elements that replace TailTipUI::Text (GlyphText, CachedText). Keeps the behaviour of the Text: the height of the position is the height of the line, the width follows the text.
+	//note: SetName() with the name the element already has does nothing, most callers set all their texts again whenever something changes.
+	class TextElement : public TailTipUI::ChildElement
+	{
+	public:
+		TextElement();
+		virtual ~TextElement();
+
+		virtual void SetName(std::string newname) override;
+		virtual void SetFont(TTF_Font* newfont) override;
+
+		//function: RelativePositionToParent
+		//note: returns the absolute position, with the width of the text
+		virtual glm::vec4 RelativePositionToParent() override;
+
+		//function: SetWidthLock
+		//note: With a width lock, text wider than the width of the position is scaled down (keeping its aspect) until it fits
+		virtual void SetWidthLock(bool b);
+		//function: GetWidthLock
+		//note: returns if the width is locked
+		virtual bool GetWidthLock();
+
+		//function: Replace
+		//note: Replaces a TailTipUI::Text in its tree with a T (a TextElement) with the same id, name, position, color, font and width lock, and deletes the Text.
+		//note: Returns the new element, or "element" if it is no plain Text (buttons and inputs stay) or has no parent.
+		template<class T>
+		static TailTipUI::GeneralElement* Replace(TailTipUI::GeneralElement* element)
+		{
+			TailTipUI::Text* text = _GetReplaceable(element);
+			return text ? _Swap(text, new T()) : element;
+		}
+	protected:
+		//var: dirty. the name, font or color changed since the text was prepared last
+		bool dirty;
+		//var: textWidth, textHeight. size of the prepared text in pixels of the font
+		int textWidth;
+		int textHeight;
+		//var: widthLock. see SetWidthLock()
+		bool widthLock;
+	private:
+		//function: _GetReplaceable
+		//note: returns element as Text if Replace() can replace it, else nullptr
+		static TailTipUI::Text* _GetReplaceable(TailTipUI::GeneralElement* element);
+		//function: _Swap
+		//note: copies the settings of text to replacement, puts replacement in its place and deletes text
+		static TailTipUI::GeneralElement* _Swap(TailTipUI::Text* text, TextElement* replacement);
+	};
+}
@@ -0,0 +1,217 @@
+#include "TextureAtlas.h"
+#include "RGBASurface.h"
+
+#include <algorithm>
+
+namespace Dragon2D
+{
+	AtlasRegion::AtlasRegion()
+		: texture(0), uv(0.0f, 0.0f, 1.0f, 1.0f), x(0), y(0), width(0), height(0), atlas(nullptr)
+	{
+
+	}
+
+	AtlasRegion::AtlasRegion(GLuint regionTexture, int regionWidth, int regionHeight)
+		: texture(regionTexture), uv(0.0f, 0.0f, 1.0f, 1.0f), x(0), y(0), width(regionWidth), height(regionHeight), atlas(nullptr)
+	{
+
+	}
+
+	glm::vec2 AtlasRegion::MapUV(glm::vec2 imageUV) const
+	{
+		return glm::vec2(uv[0] + imageUV.x * uv[2], uv[1] + imageUV.y * uv[3]);
+	}
+
+	glm::vec4 AtlasRegion::MapOffset(glm::vec4 offset) const
+	{
+		//offsets count y from the top of the image, the sprite shader turns that into 1 - y
+		return glm::vec4(uv[0] + offset[0] * uv[2], 1.0f - uv[1] - uv[3] + offset[1] * uv[3], offset[2] * uv[2], offset[3] * uv[3]);
+	}
+
+	TextureAtlas::TextureAtlas(int atlasPageSize)
+		: pageSize(atlasPageSize), enabled(true), copyFramebuffer(0)
+	{
+
+	}
+
+	TextureAtlas::~TextureAtlas()
+	{
+		for (auto& page : pages) {
+			glDeleteTextures(1, &page.texture);
+		}
+		if (copyFramebuffer != 0) {
+			glDeleteFramebuffers(1, &copyFramebuffer);
+		}
+	}
+
+	bool TextureAtlas::Fits(int width, int height)
+	{
+		return width > 0 && height > 0 && width <= MaxImageSize && height <= MaxImageSize;
+	}
+
+	bool TextureAtlas::PrepareImage(SDL_Surface* surface, std::vector<unsigned char>& pixels)
+	{
+		SDL_Surface* rgba = ConvertToRGBA(surface);
+		if (!rgba) {
+			return false;
+		}
+		int width = rgba->w;
+		int height = rgba->h;
+		int paddedWidth = width + 2 * Padding;
+		int paddedHeight = height + 2 * Padding;
+		pixels.resize(std::size_t(paddedWidth) * paddedHeight * 4);
+		SDL_LockSurface(rgba);
+		const unsigned char* source = static_cast<const unsigned char*>(rgba->pixels);
+		for (int row = 0; row < paddedHeight; row++) {
+			//GL starts with the bottom row. The padding repeats the closest row and column of the image
+			int imageRow = height - 1 - std::min(std::max(row - Padding, 0), height - 1);
+			const unsigned char* sourceRow = source + std::size_t(imageRow) * rgba->pitch;
+			unsigned char* target = &pixels[std::size_t(row) * paddedWidth * 4];
+			for (int column = 0; column < paddedWidth; column++) {
+				int imageColumn = std::min(std::max(column - Padding, 0), width - 1);
+				std::memcpy(target + column * 4, sourceRow + imageColumn * 4, 4);
+			}
+		}
+		SDL_UnlockSurface(rgba);
+		SDL_FreeSurface(rgba);
+		return true;
+	}
+
+	bool TextureAtlas::Insert(const std::vector<unsigned char>& pixels, int width, int height, AtlasRegion& region)
+	{
+		if (!enabled || !Fits(width, height)) {
+			return false;
+		}
+		int paddedWidth = width + 2 * Padding;
+		int paddedHeight = height + 2 * Padding;
+		if (pixels.size() != std::size_t(paddedWidth) * paddedHeight * 4) {
+			return false;
+		}
+
+		Page* page = nullptr;
+		int x = 0, y = 0;
+		for (auto& candidate : pages) {
+			if (_Place(candidate, paddedWidth, paddedHeight, x, y)) {
+				page = &candidate;
+				break;
+			}
+		}
+		if (!page) {
+			Page newPage;
+			newPage.top = 0;
+			newPage.images = 0;
+			glGenTextures(1, &newPage.texture);
+			glBindTexture(GL_TEXTURE_2D, newPage.texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize, pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			pages.push_back(newPage);
+			page = &pages.back();
+			_Place(*page, paddedWidth, paddedHeight, x, y);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, page->texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+		page->images++;
+
+		region.texture = page->texture;
+		region.x = x + Padding;
+		region.y = y + Padding;
+		region.width = width;
+		region.height = height;
+		region.uv = glm::vec4(region.x, region.y, width, height) / float(pageSize);
+		region.atlas = this;
+		return true;
+	}
+
+	void TextureAtlas::Remove(const AtlasRegion& region)
+	{
+		for (auto& page : pages) {
+			if (page.texture == region.texture) {
+				if (--page.images == 0) {
+					page.shelves.clear();
+					page.top = 0;
+				}
+				return;
+			}
+		}
+	}
+
+	GLuint TextureAtlas::CopyRegion(const AtlasRegion& region)
+	{
+		GLuint copy;
+		glGenTextures(1, &copy);
+		glBindTexture(GL_TEXTURE_2D, copy);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, region.width, region.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		if (copyFramebuffer == 0) {
+			glGenFramebuffers(1, &copyFramebuffer);
+		}
+		GLint previousFramebuffer;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFramebuffer);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, region.texture, 0);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, region.x, region.y, region.width, region.height);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return copy;
+	}
+
+	void TextureAtlas::SetEnabled(bool enable)
+	{
+		enabled = enable;
+	}
+
+	bool TextureAtlas::IsEnabled() const
+	{
+		return enabled;
+	}
+
+	std::size_t TextureAtlas::GetPageCount() const
+	{
+		return pages.size();
+	}
+
+	std::size_t TextureAtlas::GetImageCount() const
+	{
+		std::size_t count = 0;
+		for (auto& page : pages) {
+			count += page.images;
+		}
+		return count;
+	}
+
+	bool TextureAtlas::_Place(Page& page, int width, int height, int& x, int& y)
+	{
+		//the lowest shelf that is high enough wastes the least space
+		Shelf* best = nullptr;
+		for (auto& shelf : page.shelves) {
+			if (shelf.height >= height && shelf.x + width <= pageSize && (!best || shelf.height < best->height)) {
+				best = &shelf;
+			}
+		}
+		//a shelf more than twice as high as the image only takes it once the page has no room for a new shelf
+		bool newShelf = page.top + height <= pageSize && width <= pageSize;
+		if (!best || (best->height > 2 * height && newShelf)) {
+			if (!newShelf) {
+				return false;
+			}
+			Shelf shelf;
+			shelf.y = page.top;
+			shelf.height = height;
+			shelf.x = 0;
+			page.shelves.push_back(shelf);
+			page.top += height;
+			best = &page.shelves.back();
+		}
+		x = best->x;
+		y = best->y;
+		best->x += width;
+		return true;
+	}
+}
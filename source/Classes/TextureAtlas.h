@@ -0,0 +1,130 @@
+#pragma once
+
+#include "base.h"
+
+namespace Dragon2D
+{
+	class TextureAtlas;
+
+	//class: AtlasRegion
+	//note: The part of a GL texture an image uses. Images in an atlas share their page with others, all other images have their own texture and the whole uv range.
+	class AtlasRegion
+	{
+	public:
+		//constructor: AtlasRegion
+		//note: creates an empty region on texture 0
+		AtlasRegion();
+		//constructor: AtlasRegion
+		//note: creates a region that covers the whole texture
+		//param:	texture: the GL texture
+		//		width, height: size of the texture in pixels
+		AtlasRegion(GLuint texture, int width, int height);
+
+		//function: MapUV
+		//note: maps a uv of the image to the uv on the texture
+		glm::vec2 MapUV(glm::vec2 uv) const;
+		//function: MapOffset
+		//note: maps a sprite offset of the image ([0]=x, [1]=y from the top, [2]=width, [3]=height, see Sprite::SetOffset) to the same offset on the texture
+		glm::vec4 MapOffset(glm::vec4 offset) const;
+
+		//var: texture. the GL texture (the atlas page)
+		GLuint texture;
+		//var: uv. [0]=u, [1]=v of the lower left corner, [2]=width, [3]=height of the region in uv space
+		glm::vec4 uv;
+		//var: x, y, width, height. the region in pixels, y counted from the bottom of the texture like in GL
+		int x, y, width, height;
+		//var: atlas. the atlas of the page, nullptr for images with their own texture
+		TextureAtlas* atlas;
+	};
+
+	//class: TextureAtlas
+	//note: Packs small textures into shared pages, so everything drawn with them can be drawn with one texture bound.
+	//note: The pages are filled shelf by shelf: images go into the first shelf (row) they fit into, or open a new shelf at the top of a page.
+	//note: Space is not reused image by image, but a page starts over when all of its images are removed.
+	class TextureAtlas
+	{
+	public:
+		//const: DefaultPageSize
+		//note: width and height of the pages in pixels, if the constructor is not given another size
+		static const int DefaultPageSize = 2048;
+		//const: MaxImageSize
+		//note: images with a side larger than this get their own texture
+		static const int MaxImageSize = 256;
+		//const: Padding
+		//note: border around each image in pixels. The border repeats the edge of the image, so filtering does not bleed into the neighbours.
+		static const int Padding = 1;
+
+		//constructor: TextureAtlas
+		//param:	pageSize: width and height of the pages in pixels
+		TextureAtlas(int pageSize = DefaultPageSize);
+		~TextureAtlas();
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		//function: Fits
+		//note: returns true if an image of width x height pixels goes into the atlas
+		static bool Fits(int width, int height);
+		//function: PrepareImage
+		//note: Converts a surface into the pixels Insert() takes: RGBA, flipped like every uploaded texture and with the padding. Does not need GL, so it is done by the loader threads.
+		//param:	surface: the image
+		//		pixels: gets (width + 2 * Padding) x (height + 2 * Padding) RGBA pixels
+		static bool PrepareImage(SDL_Surface* surface, std::vector<unsigned char>& pixels);
+
+		//function: Insert
+		//note: Uploads an image into a page. Returns false if the atlas is disabled or the image does not fit. Main thread only.
+		//param:	pixels: the image from PrepareImage()
+		//		width, height: size of the image without the padding
+		//		region: gets the region of the image
+		bool Insert(const std::vector<unsigned char>& pixels, int width, int height, AtlasRegion& region);
+		//function: Remove
+		//note: Removes an image. The page is reused once it is empty.
+		void Remove(const AtlasRegion& region);
+		//function: CopyRegion
+		//note: Creates a texture of its own with the content of a region, for code that only takes whole textures. Binds texture 0 afterwards.
+		GLuint CopyRegion(const AtlasRegion& region);
+
+		//function: SetEnabled
+		//note: Disabled atlases do not take new images. On by default.
+		void SetEnabled(bool enable);
+		//function: IsEnabled
+		//note: returns true if new images go into the atlas
+		bool IsEnabled() const;
+		//function: GetPageCount
+		//note: returns the number of pages
+		std::size_t GetPageCount() const;
+		//function: GetImageCount
+		//note: returns the number of images in all pages
+		std::size_t GetImageCount() const;
+	private:
+		//class: Shelf
+		//note: a row of a page. Images are put in from left to right
+		struct Shelf
+		{
+			int y;
+			int height;
+			int x;
+		};
+		//class: Page
+		//note: a GL texture with its shelves
+		struct Page
+		{
+			GLuint texture;
+			std::vector<Shelf> shelves;
+			//var: top. the first row above the shelves
+			int top;
+			//var: images. the number of images in the page
+			int images;
+		};
+
+		//function: _Place
+		//note: finds a place for width x height pixels on page. Returns false if the page is full.
+		bool _Place(Page& page, int width, int height, int& x, int& y);
+
+		std::vector<Page> pages;
+		int pageSize;
+		bool enabled;
+		//var: copyFramebuffer. reads the pages in CopyRegion()
+		GLuint copyFramebuffer;
+	};
+}
@@ -0,0 +1,233 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Dragon2D
+{
+	const char* TextureCache::Extension = ".d2t";
+
+	std::size_t TextureCache::Image::GetMemorySize() const
+	{
+		std::size_t bytes = 0;
+		for (auto& level : levels) {
+			bytes += std::size_t(level.width) * level.height * 4;
+		}
+		return bytes;
+	}
+
+	void TextureCache::Build(const unsigned char* rgba, int width, int height, std::size_t pitch, int maxSize, Image& image)
+	{
+		//the size of the texture: as large as allowed, same aspect
+		int targetWidth = width;
+		int targetHeight = height;
+		if (maxSize > 0 && std::max(width, height) > maxSize) {
+			double scale = double(maxSize) / std::max(width, height);
+			targetWidth = std::max(1, int(width * scale + 0.5));
+			targetHeight = std::max(1, int(height * scale + 0.5));
+		}
+
+		//all levels go into one buffer
+		std::size_t bytes = 0;
+		for (int w = targetWidth, h = targetHeight;; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+			bytes += std::size_t(w) * h * 4;
+			if (w == 1 && h == 1) {
+				break;
+			}
+		}
+		auto data = std::make_shared<std::vector<unsigned char>>(bytes);
+		unsigned char* level = data->data();
+
+		//OpenGL starts with the bottom row. Images that are scaled down are flipped into a temporary buffer first
+		std::vector<unsigned char> flipped;
+		unsigned char* full = level;
+		if (targetWidth != width || targetHeight != height) {
+			flipped.resize(std::size_t(width) * height * 4);
+			full = flipped.data();
+		}
+		for (int row = 0; row < height; row++) {
+			std::memcpy(full + std::size_t(row) * width * 4, rgba + std::size_t(height - 1 - row) * pitch, std::size_t(width) * 4);
+		}
+		if (full != level) {
+			_Scale(full, width, height, level, targetWidth, targetHeight);
+		}
+
+		//every level is the one before at half the size
+		image.levels.clear();
+		int levelWidth = targetWidth;
+		int levelHeight = targetHeight;
+		while (true) {
+			Level next = { levelWidth, levelHeight, level };
+			image.levels.push_back(next);
+			if (levelWidth == 1 && levelHeight == 1) {
+				break;
+			}
+			unsigned char* smaller = level + std::size_t(levelWidth) * levelHeight * 4;
+			_Scale(level, levelWidth, levelHeight, smaller, std::max(1, levelWidth / 2), std::max(1, levelHeight / 2));
+			level = smaller;
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+		image.owner = data;
+	}
+
+	bool TextureCache::Load(const std::string& file, int maxSize, Image& image)
+	{
+		std::uint64_t size;
+		std::int64_t mtime;
+		if (!MappedFile::Stat(file, size, mtime)) {
+			return false;
+		}
+		std::shared_ptr<MappedFile> cache = std::make_shared<MappedFile>(file + Extension);
+		if (!cache->IsOpen() || cache->GetSize() < sizeof(Header)) {
+			return false;
+		}
+		Header header;
+		std::memcpy(&header, cache->GetData(), sizeof(Header));
+		if (header.sourceSize != size || header.maxSize != maxSize) {
+			return false;
+		}
+		//same size and time: use it without touching the source
+		if (header.sourceMtime == mtime) {
+			image.owner = cache;
+			return _Parse(cache->GetData(), cache->GetSize(), maxSize, image);
+		}
+
+		//only the time changed (e.g. the file was copied or checked out again): check the content
+		MappedFile source(file);
+		if (!source.IsOpen()) {
+			return false;
+		}
+		std::uint64_t hash = MappedFile::Hash(source.GetData(), source.GetSize());
+		if (header.sourceHash != hash) {
+			return false;
+		}
+		//update the time, so the next start does not have to hash again. The image does not need the old mapping then.
+		auto copy = std::make_shared<std::vector<char>>(cache->GetData(), cache->GetData() + cache->GetSize());
+		cache.reset();
+		image.owner = copy;
+		if (!_Parse(copy->data(), copy->size(), maxSize, image)) {
+			return false;
+		}
+		Save(file, image, maxSize, size, mtime, hash);
+		return true;
+	}
+
+	bool TextureCache::Read(const char* data, std::size_t size, std::shared_ptr<const void> owner, int maxSize, Image& image)
+	{
+		image.owner = owner;
+		return _Parse(data, size, maxSize, image);
+	}
+
+	bool TextureCache::Save(const std::string& file, const Image& image, int maxSize, std::uint64_t size, std::int64_t mtime, std::uint64_t hash)
+	{
+		if (image.levels.empty()) {
+			return false;
+		}
+		Header header;
+		std::memcpy(header.magic, "D2TX", 4);
+		header.version = Version;
+		header.sourceSize = size;
+		header.sourceMtime = mtime;
+		header.sourceHash = hash;
+		header.maxSize = maxSize;
+		header.width = image.levels[0].width;
+		header.height = image.levels[0].height;
+		header.levels = std::uint32_t(image.levels.size());
+		header.dataSize = image.GetMemorySize();
+
+		std::vector<std::pair<const void*, std::size_t>> parts;
+		parts.push_back(std::make_pair(&header, sizeof(Header)));
+		for (auto& level : image.levels) {
+			parts.push_back(std::make_pair(level.pixels, std::size_t(level.width) * level.height * 4));
+		}
+		return MappedFile::WriteAtomic(file + Extension, parts);
+	}
+
+	bool TextureCache::IsCurrent(const std::string& file, int maxSize)
+	{
+		std::uint64_t size;
+		std::int64_t mtime;
+		if (!MappedFile::Stat(file, size, mtime)) {
+			return false;
+		}
+		MappedFile cache(file + Extension);
+		if (!cache.IsOpen() || cache.GetSize() < sizeof(Header)) {
+			return false;
+		}
+		Header header;
+		std::memcpy(&header, cache.GetData(), sizeof(Header));
+		if (std::memcmp(header.magic, "D2TX", 4) != 0 || header.version != Version || header.sourceSize != size
+			|| (maxSize != -1 && header.maxSize != maxSize)) {
+			return false;
+		}
+		if (header.sourceMtime == mtime) {
+			return true;
+		}
+		MappedFile source(file);
+		return source.IsOpen() && header.sourceHash == MappedFile::Hash(source.GetData(), source.GetSize());
+	}
+
+	bool TextureCache::_Parse(const char* data, std::size_t size, int maxSize, Image& image)
+	{
+		image.levels.clear();
+		if (size < sizeof(Header)) {
+			return false;
+		}
+		Header header;
+		std::memcpy(&header, data, sizeof(Header));
+		if (std::memcmp(header.magic, "D2TX", 4) != 0 || header.version != Version || header.maxSize != maxSize
+			|| header.dataSize != size - sizeof(Header) || header.width <= 0 || header.height <= 0) {
+			return false;
+		}
+		const unsigned char* pixels = reinterpret_cast<const unsigned char*>(data + sizeof(Header));
+		std::uint64_t bytes = 0;
+		int width = header.width;
+		int height = header.height;
+		for (std::uint32_t i = 0; i < header.levels; i++) {
+			Level level = { width, height, pixels + bytes };
+			bytes += std::uint64_t(width) * height * 4;
+			if (bytes > header.dataSize) {
+				image.levels.clear();
+				return false;
+			}
+			image.levels.push_back(level);
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+		return !image.levels.empty();
+	}
+
+	void TextureCache::_Scale(const unsigned char* source, int width, int height, unsigned char* target, int targetWidth, int targetHeight)
+	{
+		for (int y = 0; y < targetHeight; y++) {
+			int y0 = int(std::int64_t(y) * height / targetHeight);
+			int y1 = std::max(y0 + 1, int(std::int64_t(y + 1) * height / targetHeight));
+			for (int x = 0; x < targetWidth; x++) {
+				int x0 = int(std::int64_t(x) * width / targetWidth);
+				int x1 = std::max(x0 + 1, int(std::int64_t(x + 1) * width / targetWidth));
+				//colors are weighted by alpha, so transparent pixels do not darken the edges
+				std::uint64_t color[3] = { 0, 0, 0 };
+				std::uint64_t plain[3] = { 0, 0, 0 };
+				std::uint64_t alpha = 0;
+				for (int sy = y0; sy < y1; sy++) {
+					const unsigned char* pixel = source + (std::size_t(sy) * width + x0) * 4;
+					for (int sx = x0; sx < x1; sx++, pixel += 4) {
+						for (int c = 0; c < 3; c++) {
+							color[c] += std::uint64_t(pixel[c]) * pixel[3];
+							plain[c] += pixel[c];
+						}
+						alpha += pixel[3];
+					}
+				}
+				std::uint64_t count = std::uint64_t(x1 - x0) * (y1 - y0);
+				unsigned char* out = target + (std::size_t(y) * targetWidth + x) * 4;
+				for (int c = 0; c < 3; c++) {
+					out[c] = (unsigned char)(alpha > 0 ? (color[c] + alpha / 2) / alpha : (plain[c] + count / 2) / count);
+				}
+				out[3] = (unsigned char)((alpha + count / 2) / count);
+			}
+		}
+	}
+}
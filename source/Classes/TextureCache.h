@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+namespace Dragon2D
+{
+	//class: TextureCache
+	//note: Keeps textures ready for the GPU on disk: decoded RGBA, scaled down to a maximum size and with all mip levels. "file.png" is cooked into "file.png.d2t".
+	//note: A cooked texture is memory mapped and uploaded as it is, nothing is decoded or scaled at runtime. Like the XMLCache, it is rebuild when the source changes.
+	//note: Cook all textures of a game with source/tools/TextureTool.cpp ("make gamepack" does it), or let the engine write the caches on the first start.
+	class TextureCache
+	{
+	public:
+		//const: Extension
+		//note: appended to the name of the source to get the name of the cache
+		static const char* Extension;
+		//const: Version
+		//note: Version of the cache file format. Increase when Header changes, caches with other versions are rebuild.
+		static const std::uint32_t Version = 1;
+		//const: DefaultMaxSize
+		//note: the default limit for width and height of textures
+		static const int DefaultMaxSize = 2048;
+
+		//class: Level
+		//note: a mip level: RGBA pixels, starting with the bottom row like OpenGL wants them
+		struct Level
+		{
+			int width;
+			int height;
+			const unsigned char* pixels;
+		};
+
+		//class: Image
+		//note: a cooked texture. The pixels stay valid as long as the Image (or a copy of owner) lives.
+		struct Image
+		{
+			//var: levels. the mip levels, the full size first
+			std::vector<Level> levels;
+			//var: owner. the memory behind the levels: the mapped cache or the pixels of Build()
+			std::shared_ptr<const void> owner;
+
+			//function: GetMemorySize
+			//note: returns the bytes of all levels
+			std::size_t GetMemorySize() const;
+		};
+
+		//function: Build
+		//note: Cooks an image: scales it down until it fits into maxSize x maxSize (keeping its aspect) and builds the mip levels down to 1x1.
+		//param:	rgba: RGBA pixels, top row first (like SDL surfaces)
+		//		width, height: size of the image
+		//		pitch: bytes per row in rgba
+		//		maxSize: the limit for width and height, 0 for none
+		//		image: gets the cooked texture
+		static void Build(const unsigned char* rgba, int width, int height, std::size_t pitch, int maxSize, Image& image);
+
+		//function: Load
+		//note: Loads the cache of the file "file". Returns false if there is none, or it belongs to another version of the file or another maxSize. Then the file has to be decoded and Build().
+		//param:	file: the source image
+		//		maxSize: the limit the cache must have been built with
+		//		image: gets the cooked texture
+		static bool Load(const std::string& file, int maxSize, Image& image);
+		//function: Read
+		//note: Reads a cooked texture from memory (i.e. a ResourcePack). Returns false if it is damaged or was built with another maxSize.
+		//param:	data, size: the content of a cache file
+		//		owner: keeps data alive, the image shares it
+		static bool Read(const char* data, std::size_t size, std::shared_ptr<const void> owner, int maxSize, Image& image);
+
+		//function: Save
+		//note: Writes the cache for an image built from a source with the given size, mtime and hash. Returns false if the cache can not be written.
+		//param:	file: the source image
+		//		image: the cooked texture
+		//		maxSize: the limit it was built with
+		//		size, mtime, hash: describe the source, see MappedFile::Stat and MappedFile::Hash
+		static bool Save(const std::string& file, const Image& image, int maxSize, std::uint64_t size, std::int64_t mtime, std::uint64_t hash);
+
+		//function: IsCurrent
+		//note: returns true if "file" has a cache that matches its current content
+		//param:	file: the source image
+		//		maxSize: the limit the cache must have been built with, -1 for any
+		static bool IsCurrent(const std::string& file, int maxSize);
+	private:
+		//struct: Header
+		//note: starts every cache file. The levels follow directly, one after another.
+		struct Header
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sourceSize;
+			std::int64_t sourceMtime;
+			std::uint64_t sourceHash;
+			std::int32_t maxSize;
+			std::int32_t width;
+			std::int32_t height;
+			std::uint32_t levels;
+			std::uint64_t dataSize;
+		};
+
+		//function: _Parse
+		//note: checks a header and fills image.levels with the data behind it
+		static bool _Parse(const char* data, std::size_t size, int maxSize, Image& image);
+		//function: _Scale
+		//note: scales rgba (bottom row first, tightly packed) to the target size by averaging the covered pixels
+		static void _Scale(const unsigned char* source, int width, int height, unsigned char* target, int targetWidth, int targetHeight);
+	};
+}
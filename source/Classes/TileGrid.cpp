@@ -0,0 +1,89 @@
+#include "TileGrid.h"
+
+namespace Dragon2D
+{
+	const int TileGrid::ChunkSize;
+	const int TileGrid::MaxId;
+	const TileGrid::Cell TileGrid::NoTile;
+	const TileGrid::Cell TileGrid::DefaultTile;
+
+	TileGrid::TileGrid()
+		: defaultId(-1)
+	{
+	}
+
+	void TileGrid::SetDefault(int id)
+	{
+		defaultId = id;
+	}
+
+	int TileGrid::GetDefault() const
+	{
+		return defaultId;
+	}
+
+	int TileGrid::Get(int x, int y) const
+	{
+		int cx = ChunkOf(x);
+		int cy = ChunkOf(y);
+		const Cell* chunk = _FindChunk(cx, cy);
+		if (!chunk) {
+			return defaultId;
+		}
+		return _Resolve(chunk[(y - cy*ChunkSize)*ChunkSize + x - cx*ChunkSize]);
+	}
+
+	bool TileGrid::Set(int x, int y, int id)
+	{
+		if (id > MaxId) {
+			return false;
+		}
+		int cx = ChunkOf(x);
+		int cy = ChunkOf(y);
+		std::size_t index;
+		auto chunk = chunkIndex.find(_Key(cx, cy));
+		if (chunk == chunkIndex.end()) {
+			index = chunkPositions.size();
+			chunkIndex[_Key(cx, cy)] = index;
+			chunkPositions.push_back(std::make_pair(cx, cy));
+			cells.resize(cells.size() + ChunkSize*ChunkSize, DefaultTile);
+		}
+		else {
+			index = chunk->second;
+		}
+		cells[index*ChunkSize*ChunkSize + (y - cy*ChunkSize)*ChunkSize + x - cx*ChunkSize] = id < 0 ? NoTile : (Cell)id;
+		return true;
+	}
+
+	const std::vector<std::pair<int, int>>& TileGrid::GetChunks() const
+	{
+		return chunkPositions;
+	}
+
+	int TileGrid::ChunkOf(int tile)
+	{
+		return tile >= 0 ? tile / ChunkSize : (tile + 1) / ChunkSize - 1;
+	}
+
+	std::uint64_t TileGrid::_Key(int cx, int cy)
+	{
+		return ((std::uint64_t)(std::uint32_t)cx << 32) | (std::uint32_t)cy;
+	}
+
+	const TileGrid::Cell* TileGrid::_FindChunk(int cx, int cy) const
+	{
+		auto chunk = chunkIndex.find(_Key(cx, cy));
+		if (chunk == chunkIndex.end()) {
+			return nullptr;
+		}
+		return &cells[chunk->second*ChunkSize*ChunkSize];
+	}
+
+	int TileGrid::_Resolve(Cell cell) const
+	{
+		if (cell == DefaultTile) {
+			return defaultId;
+		}
+		return cell == NoTile ? -1 : cell;
+	}
+}
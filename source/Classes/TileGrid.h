@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace Dragon2D
+{
+	//class: TileGrid
+	//note: The tile ids of a map layer, dense in chunks of ChunkSize*ChunkSize. Only chunks where a tile was set are stored, all others are default tiles. Get() is one hash lookup and an index.
+	//note: Ids are stored in 16 bit: 0 to MaxId, and -1 for "no tile". Tiles that were never set follow SetDefault(), also when it is called later.
+	class TileGrid
+	{
+	public:
+		//const: ChunkSize
+		//note: width and height of a chunk in tiles
+		static const int ChunkSize = 32;
+		//const: MaxId
+		//note: the largest id that can be stored
+		static const int MaxId = 0xFFFD;
+
+		TileGrid();
+
+		//function: SetDefault
+		//note: sets the id of all tiles that were not set, -1 for no tile
+		void SetDefault(int id);
+		//function: GetDefault
+		//note: returns the default id
+		int GetDefault() const;
+
+		//function: Get
+		//note: returns the id at x, y, -1 if there is no tile
+		int Get(int x, int y) const;
+		//function: Set
+		//note: sets the id at x, y. Returns false (and does not set it) if id is larger than MaxId.
+		bool Set(int x, int y, int id);
+
+		//function: ForEach
+		//note: calls f(x, y, id) for every tile of x0 to x1 and y0 to y1 (without x1 and y1), row by row. Looks up every chunk once per row.
+		template<class F>
+		void ForEach(int x0, int y0, int x1, int y1, F f) const;
+
+		//function: GetChunks
+		//note: returns the positions (in chunks) of the stored chunks
+		const std::vector<std::pair<int, int>>& GetChunks() const;
+
+		//function: ChunkOf
+		//note: returns the chunk of a tile position, rounded down for negative positions too
+		static int ChunkOf(int tile);
+	private:
+		typedef std::uint16_t Cell;
+		//const: NoTile, DefaultTile. the cells of -1 and of tiles that were not set
+		static const Cell NoTile = 0xFFFF;
+		static const Cell DefaultTile = 0xFFFE;
+
+		//function: _Key
+		//note: the key of a chunk in chunkIndex
+		static std::uint64_t _Key(int cx, int cy);
+		//function: _FindChunk
+		//note: returns the cells of a chunk (row by row), nullptr if it is not stored
+		const Cell* _FindChunk(int cx, int cy) const;
+		//function: _Resolve
+		//note: returns the id of a cell
+		int _Resolve(Cell cell) const;
+
+		//var: chunkIndex. the index of a chunk in chunkPositions, its cells start at index*ChunkSize*ChunkSize
+		std::unordered_map<std::uint64_t, std::size_t> chunkIndex;
+		//var: cells. the cells of all chunks, one after the other
+		std::vector<Cell> cells;
+		std::vector<std::pair<int, int>> chunkPositions;
+		int defaultId;
+	};
+
+	template<class F>
+	void TileGrid::ForEach(int x0, int y0, int x1, int y1, F f) const
+	{
+		for (int y = y0; y < y1; y++) {
+			int cy = ChunkOf(y);
+			int row = (y - cy*ChunkSize)*ChunkSize;
+			int x = x0;
+			while (x < x1) {
+				int cx = ChunkOf(x);
+				int end = std::min(x1, (cx + 1)*ChunkSize);
+				const Cell* chunk = _FindChunk(cx, cy);
+				if (!chunk) {
+					for (; x < end; x++) {
+						f(x, y, defaultId);
+					}
+				}
+				else {
+					const Cell* cell = chunk + row;
+					for (; x < end; x++) {
+						f(x, y, _Resolve(cell[x - cx*ChunkSize]));
+					}
+				}
+			}
+		}
+	}
+}
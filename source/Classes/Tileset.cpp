@@ -1,25 +1,25 @@
 #include "Tileset.h"
 
 #include "Env.h"
+
+#include <algorithm>
 namespace Dragon2D
 {
 	D2DCLASS_REGISTER(Tileset);
 	Tileset::Tileset()
-		: name(""), defaultId(0), tiles()
+		: name(""), defaultId(0), tiles(), revision(0)
 	{
 
 	}
 
 	Tileset::Tileset(std::string name)
-		: name(name), defaultId(0), tiles()
+		: name(name), defaultId(0), tiles(), revision(0)
 	{
 		Load(name);
 	}
 
 	Tileset::~Tileset()
 	{
-		std::string infilename = std::string("tilesets/") + name + ".xml";
-		Env::GetResourceManager().FreeXMLResource(infilename);
 	}
 
 	void Tileset::Load(std::string loadName)
@@ -28,38 +28,35 @@ namespace Dragon2D
 		std::string texture;
 		std::string infilename = std::string("tilesets/") + name + ".xml";
 		Uint32 bt = SDL_GetTicks();
-		Env::GetResourceManager().RequestXMLResource(infilename);
-		HoardXML::Document &indoc = Env::GetResourceManager().GetXMLResource(infilename).GetDocument();
+		std::string indata;
+		HoardXML::ReadFile(Env::GetGamepath() + infilename, indata);
+		HoardXML::Reader reader(indata.data(), indata.size());
 
-		Uint32 tges = SDL_GetTicks() - bt;
-		std::cout << "LoadTime:" << tges << std::endl;
 		//we silently quit if we cant find what we load. used for editing in the editor when creating new tilesets.
-		if (indoc["tileset"].size() < 1) {
+		bool foundTileset = false;
+		while (!foundTileset && reader.NextChild(0)) {
+			foundTileset = reader.GetName() == "tileset";
+		}
+		if (!foundTileset) {
 			return;
 		}
 
-		auto contentTags = indoc["tileset"][0]->GetChildren();
-		for (auto tag : contentTags) {
-			std::string tagname = tag.GetName();
+		std::size_t tilesetDepth = reader.GetDepth();
+		while (reader.NextChild(tilesetDepth)) {
+			HoardXML::StringRef tagname = reader.GetName();
+			std::size_t tagDepth = reader.GetDepth();
 			if (tagname == "texture") {
-				texture = tag.GetAttribute("name");
+				texture = reader.GetAttribute("name").Str();
 			} 
 			else if (tagname == "default") {
-				std::string idString = tag.GetAttribute("id");
-				defaultId = atoi(idString.c_str());
+				defaultId = reader.GetAttribute("id").ToInt();
 			}
 			else if (tagname == "tiles") {
-				auto tileTags = tag.GetChildren();
-				for (auto tileTag : tileTags) {
-					std::string tileTagName = tileTag.GetName();
+				while (reader.NextChild(tagDepth)) {
+					HoardXML::StringRef tileTagName = reader.GetName();
 					if (tileTagName == "tile") {
-						std::string idString = tileTag.GetAttribute("id");
-						std::string xString = tileTag.GetAttribute("x");
-						std::string yString = tileTag.GetAttribute("y");
-						std::string wString = tileTag.GetAttribute("w");
-						std::string hString = tileTag.GetAttribute("h");
-						unsigned int newId = atoi(idString.c_str());
-						tiles[newId] = glm::vec4(atof(xString.c_str()), atof(yString.c_str()), atof(wString.c_str()), atof(hString.c_str()));
+						unsigned int newId = reader.GetAttribute("id").ToInt();
+						tiles[newId] = glm::vec4(reader.GetAttribute("x").ToFloat(), reader.GetAttribute("y").ToFloat(), reader.GetAttribute("w").ToFloat(), reader.GetAttribute("h").ToFloat());
 					}
 					else {
 						Env::Out() << "WARNING: unknown tag \"" << tileTagName << "\" in tileset " << name << std::endl;
@@ -68,16 +65,16 @@ namespace Dragon2D
 			}
 			else if (tagname == "animation") {
 				TileAnimation newAnim;
-				newAnim.name = tag.GetAttribute("name");
-				newAnim.loop = tag.GetAttribute("loop") == "true";
-				for (auto animTile : tag.GetChildren()) {
-					if (animTile.GetName() == "tile") {
-						int id = atoi(animTile.GetAttribute("id").c_str());
-						int len = atoi(animTile.GetAttribute("len").c_str());
+				newAnim.name = reader.GetAttribute("name").Str();
+				newAnim.loop = reader.GetAttribute("loop") == "true";
+				while (reader.NextChild(tagDepth)) {
+					if (reader.GetName() == "tile") {
+						int id = reader.GetAttribute("id").ToInt();
+						int len = reader.GetAttribute("len").ToInt();
 						newAnim.tileList.push_back(std::make_pair(id, len));
 					}
 					else {
-						Env::Out() << "WARNING: unknown animation tag \"" << animTile.GetName() << "\" in tileset " << name << std::endl;
+						Env::Out() << "WARNING: unknown animation tag \"" << reader.GetName() << "\" in tileset " << name << std::endl;
 					}	
 				}
 				animations[newAnim.name] = newAnim;
@@ -86,7 +83,10 @@ namespace Dragon2D
 				Env::Out() << "WARNING: unknown tag \"" << tagname << "\" in tileset " << name << std::endl;
 			}
 		}
+		Uint32 tges = SDL_GetTicks() - bt;
+		std::cout << "LoadTime:" << tges << std::endl;
 		UseTexture(texture);
+		revision++;
 
 	}
 
@@ -119,7 +119,8 @@ namespace Dragon2D
 		textureTag.SetAttribute("name", GetTexture());
 		textureTag.SetEmptyTag(true);
 		tilesTag.SetName("tiles");
-		for (auto tPair : tiles) {
+		tilesTag.GetChildren().reserve(tiles.size());
+		for (auto& tPair : tiles) {
 			HoardXML::Tag newTileTag;
 			newTileTag.SetName("tile");
 			newTileTag.SetAttribute("id", std::to_string(tPair.first));
@@ -128,12 +129,12 @@ namespace Dragon2D
 			newTileTag.SetAttribute("w", std::to_string(tPair.second[2]));
 			newTileTag.SetAttribute("h", std::to_string(tPair.second[3]));
 			newTileTag.SetEmptyTag(true);
-			tilesTag.AddChild(newTileTag);
+			tilesTag.AddChild(std::move(newTileTag));
 		}
-		baseTag.AddChild(textureTag);
-		baseTag.AddChild(defaultTag);
-		baseTag.AddChild(tilesTag);
-		outdoc.AddChild(baseTag);
+		baseTag.AddChild(std::move(textureTag));
+		baseTag.AddChild(std::move(defaultTag));
+		baseTag.AddChild(std::move(tilesTag));
+		outdoc.AddChild(std::move(baseTag));
 		std::string outfilename = Env::GetGamepath() + std::string("tilesets/") + name + ".xml";
 		outdoc.Save(outfilename);
 	}
@@ -158,11 +159,18 @@ namespace Dragon2D
 	void Tileset::SetTile(int id, glm::vec4 t)
 	{
 		tiles[id] = t;
+		revision++;
 	}
 
 	void Tileset::ResetTiles()
 	{
 		tiles.clear();
+		revision++;
+	}
+
+	unsigned int Tileset::GetRevision() const
+	{
+		return revision;
 	}
 
 	int Tileset::GetTileAtTexturePosition(glm::vec4 p) const
@@ -178,76 +186,197 @@ namespace Dragon2D
 	}
 
 	//Batched Tilesets for FASTR RENARING
+	TileMesh::TileMesh()
+		: buffer(0), tiles(0), revision(0)
+	{
+	}
+
+	TileMesh::~TileMesh()
+	{
+		glDeleteBuffers(1, &buffer);
+	}
+
 	D2DCLASS_REGISTER(BatchedTileset);
+	std::weak_ptr<GLuint> BatchedTileset::sharedIndexBuffer;
+	std::size_t BatchedTileset::indexedTiles = 0;
+
 	BatchedTileset::BatchedTileset()
 		: Tileset()
 	{
 		UseProgram("batchedTiles");
-		glGenBuffers(1, &vertexBuffer);
-		glGenBuffers(1, &uvBuffer);
 	}
 
 	BatchedTileset::BatchedTileset(std::string name)
 		: Tileset(name)
 	{
 		UseProgram("batchedTiles");
-		glGenBuffers(1, &vertexBuffer);
-		glGenBuffers(1, &uvBuffer);
 	}
 
 	void BatchedTileset::Render(int id)
 	{
 		glm::vec4 pos = GetPosition();
-		//We render quads, so we need to 1st scale it, 2nd move it and 3rd push it to the rawVertexBuffer
-		//glm::vec2 rpos(pos.x * 2 - 1, (1.0f-pos.y-pos[3]) * 2.0f - 1.0f);
-		//glm::vec2 rsize(pos[2] * 2.0f, pos[3] * 2.0f);
 		glm::vec2 rpos(pos.x, (1.0f-pos.y-pos[3])); //we need to invert y and stuff
 		glm::vec2 rsize(pos[2], pos[3]);
-		rawVertexBuffer.push_back(rpos);
-		rawVertexBuffer.push_back(rpos + glm::vec2(rsize.x, 0.0f));
-		rawVertexBuffer.push_back(rpos + glm::vec2(0.0f, rsize.y));
-		rawVertexBuffer.push_back(rpos + glm::vec2(0.0f, rsize.y));
-		rawVertexBuffer.push_back(rpos + glm::vec2(rsize.x, 0.0f));
-		rawVertexBuffer.push_back(rpos + glm::vec2(rsize.x, rsize.y));
-		//and calcualte the uv
+		_AddTile(rawVertices, rpos, rsize, id);
+		//done, the actual rendering happens in the flush!
+	}
+
+	void BatchedTileset::AddMeshTile(int id, int x, int y)
+	{
+		//y goes down in tiles, the lower left corner is at y+1
+		_AddTile(meshVertices, glm::vec2((float)x, (float)(y + 1)), glm::vec2(1.0f, -1.0f), id);
+	}
+
+	void BatchedTileset::BuildMesh(TileMesh& mesh)
+	{
+		TextureResource &t = Env::GetResourceManager().Get(textureHandle);
+		mesh.region = t.GetAtlasRegion();
+		mesh.revision = GetRevision();
+		mesh.tiles = meshVertices.size() / 4;
+		for (auto& v : meshVertices) {
+			v.uv = mesh.region.MapUV(v.uv);
+		}
+		if (mesh.buffer == 0) {
+			glGenBuffers(1, &mesh.buffer);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+		glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(TileVertex), meshVertices.empty() ? nullptr : &meshVertices[0], GL_STATIC_DRAW);
+		meshVertices.clear();
+	}
+
+	bool BatchedTileset::IsMeshCurrent(const TileMesh& mesh)
+	{
+		if (mesh.revision != GetRevision()) {
+			return false;
+		}
+		TextureResource &t = Env::GetResourceManager().Get(textureHandle);
+		AtlasRegion region = t.GetAtlasRegion();
+		return region.texture == mesh.region.texture && region.uv == mesh.region.uv;
+	}
+
+	void BatchedTileset::DrawMesh(const TileMesh& mesh, const glm::vec4& transform)
+	{
+		static const std::uint32_t samplerUniform = GLProgramResource::GetUniformId("textureSampler");
+		static const std::uint32_t transformUniform = GLProgramResource::GetUniformId("tileTransform");
+		if (mesh.tiles == 0) {
+			return;
+		}
+		GLProgramResource &p = Env::GetResourceManager().Get(programHandle);
+		_ReserveIndices(mesh.tiles);
+		//bind
+		p.Use();
+		TextureResource::BindTexture(mesh.region.texture);
+		glUniform1i(p.GetUniform(samplerUniform), 0);
+		glUniform4f(p.GetUniform(transformUniform), transform[0], transform[1], transform[2], transform[3]);
+		//render
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void*)sizeof(glm::vec2));
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *indexBuffer);
+		glDrawElements(GL_TRIANGLES, (GLsizei)(mesh.tiles * 6), GL_UNSIGNED_INT, (void*)0);
+		Env::GetSpriteBatch().CountDrawCalls();
+		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(0);
+	}
+
+	void BatchedTileset::_AddTile(std::vector<TileVertex>& vertices, glm::vec2 pos, glm::vec2 size, int id)
+	{
+		//calcualte the uv
 		glm::vec4 rawOffset = GetTile(id);
 		glm::vec2 uvpos(rawOffset.x, (1.0f - rawOffset.y - rawOffset[3]));
 		glm::vec2 uvsize(rawOffset[2], rawOffset[3]);
-		rawUVBuffer.push_back(uvpos);
-		rawUVBuffer.push_back(uvpos + glm::vec2(uvsize.x, 0.0f));
-		rawUVBuffer.push_back(uvpos + glm::vec2(0.0f, uvsize.y));
-		rawUVBuffer.push_back(uvpos + glm::vec2(0.0f, uvsize.y));
-		rawUVBuffer.push_back(uvpos + glm::vec2(uvsize.x, 0.0f));
-		rawUVBuffer.push_back(uvpos + glm::vec2(uvsize.x, uvsize.y));
-		//done, the actual rendering happens in the flush!
+		//the corners bottom left, bottom right, top left, top right. The index buffer makes the triangles
+		vertices.push_back({ pos, uvpos });
+		vertices.push_back({ pos + glm::vec2(size.x, 0.0f), uvpos + glm::vec2(uvsize.x, 0.0f) });
+		vertices.push_back({ pos + glm::vec2(0.0f, size.y), uvpos + glm::vec2(0.0f, uvsize.y) });
+		vertices.push_back({ pos + size, uvpos + uvsize });
 	}
 
 	void BatchedTileset::FlushBatched()
 	{
-		//buffer stuff
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-		glBufferData(GL_ARRAY_BUFFER, rawVertexBuffer.size()*sizeof(GLfloat) * 2, &rawVertexBuffer[0][0], GL_STREAM_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-		glBufferData(GL_ARRAY_BUFFER, rawUVBuffer.size()*sizeof(GLfloat) * 2, &rawUVBuffer[0][0], GL_STREAM_DRAW);
-		TextureResource &t = Env::GetResourceManager().GetTextureResource(GetTexture());
-		GLProgramResource &p = Env::GetResourceManager().GetGLProgramResource(GetProgram());
+		static const std::uint32_t samplerUniform = GLProgramResource::GetUniformId("textureSampler");
+		static const std::uint32_t transformUniform = GLProgramResource::GetUniformId("tileTransform");
+		if (rawVertices.empty()) {
+			return;
+		}
+		TextureResource &t = Env::GetResourceManager().Get(textureHandle);
+		GLProgramResource &p = Env::GetResourceManager().Get(programHandle);
+		std::size_t tiles = rawVertices.size() / 4;
+		_ReserveIndices(tiles);
+
+		//the uvs are on the image, the texture might be a region of an atlas page. They are mapped while they are copied
+		AtlasRegion region = t.GetAtlasRegion();
+		if (!vertexStream) {
+			vertexStream.reset(new StreamBuffer());
+		}
+		TileVertex* out = static_cast<TileVertex*>(vertexStream->Map(rawVertices.size() * sizeof(TileVertex)));
+		if (!out) {
+			rawVertices.clear();
+			return;
+		}
+		for (std::size_t i = 0; i < rawVertices.size(); i++) {
+			out[i].position = rawVertices[i].position;
+			out[i].uv = region.MapUV(rawVertices[i].uv);
+		}
+		std::size_t offset = vertexStream->Unmap();
+
 		//bind 
 		p.Use();
 		t.Bind();
-		glUniform1i(p["textureSampler"], 0);
+		glUniform1i(p.GetUniform(samplerUniform), 0);
+		//the vertices are on the screen already
+		glUniform4f(p.GetUniform(transformUniform), 0.0f, 0.0f, 1.0f, 1.0f);
 		//render
+		glBindBuffer(GL_ARRAY_BUFFER, vertexStream->GetBuffer());
 		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void*)offset);
 		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-		glDrawArrays(GL_TRIANGLES, 0, rawVertexBuffer.size());
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void*)(offset + sizeof(glm::vec2)));
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *indexBuffer);
+		glDrawElements(GL_TRIANGLES, (GLsizei)(tiles * 6), GL_UNSIGNED_INT, (void*)0);
+		vertexStream->Fence();
+		Env::GetSpriteBatch().CountDrawCalls();
 		glDisableVertexAttribArray(1);
 		glDisableVertexAttribArray(0);
 		//cleanup
-		rawVertexBuffer.clear();
-		rawUVBuffer.clear();
+		rawVertices.clear();
+	}
+
+	void BatchedTileset::_ReserveIndices(std::size_t tiles)
+	{
+		if (!indexBuffer) {
+			indexBuffer = sharedIndexBuffer.lock();
+		}
+		if (!indexBuffer) {
+			GLuint buffer = 0;
+			glGenBuffers(1, &buffer);
+			indexBuffer.reset(new GLuint(buffer), [](GLuint* b) {
+				glDeleteBuffers(1, b);
+				delete b;
+			});
+			sharedIndexBuffer = indexBuffer;
+			indexedTiles = 0;
+		}
+		if (tiles <= indexedTiles) {
+			return;
+		}
+		//grows in steps, a scrolling map does not rebuild it every frame
+		indexedTiles = std::max(tiles, std::max(indexedTiles * 2, std::size_t(1024)));
+		std::vector<GLuint> indices;
+		indices.reserve(indexedTiles * 6);
+		for (GLuint tile = 0; tile < indexedTiles; tile++) {
+			GLuint first = tile * 4;
+			indices.push_back(first);
+			indices.push_back(first + 1);
+			indices.push_back(first + 2);
+			indices.push_back(first + 2);
+			indices.push_back(first + 1);
+			indices.push_back(first + 3);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
 	}
 
 	//Animated Tileset
@@ -3,6 +3,7 @@
 #include "base.h"
 #include "BaseClass.h"
 #include "Sprite.h"
+#include "StreamBuffer.h"
 
 namespace Dragon2D
 {
@@ -41,11 +42,16 @@ namespace Dragon2D
 		virtual void ResetTiles();
 
 		virtual int GetTileAtTexturePosition(glm::vec4 p) const;
+
+		//function: GetRevision
+		//note: counts up whenever the tiles change (Load(), SetTile(), ResetTiles()), so cached geometry knows it is outdated
+		unsigned int GetRevision() const;
 	private:
 		std::string name;
 
 		int defaultId;
 		std::map<int,glm::vec4> tiles;
+		unsigned int revision;
 	protected:
 		//var animations. Used by childClass TilesetAnimaiton to animate things.
 		std::map<std::string, TileAnimation> animations; 
@@ -64,6 +70,29 @@ namespace Dragon2D
 	D2DCLASS_SCRIPTINFO_END
 
 
+	//class: TileMesh
+	//note: Tiles of a BatchedTileset in a static vertex buffer. Built once by BatchedTileset::BuildMesh() and drawn with one draw call by BatchedTileset::DrawMesh(), maps keep one for every chunk of a layer.
+	class TileMesh
+	{
+	public:
+		TileMesh();
+		~TileMesh();
+
+		TileMesh(const TileMesh&) = delete;
+		TileMesh& operator=(const TileMesh&) = delete;
+
+		//var: buffer. the vertices, 4 for each tile
+		GLuint buffer;
+		//var: tiles. number of tiles in buffer
+		std::size_t tiles;
+		//var: region, revision. the atlas region and the tileset revision the mesh was built with
+		AtlasRegion region;
+		unsigned int revision;
+	};
+
+	//class: BatchedTileset
+	//note: Collects the tiles of Render(int) and draws them all at once in FlushBatched().
+	//note: A tile is 4 interleaved vertices (position and uv), made into two triangles by an index buffer all BatchedTilesets share. The vertices go through a StreamBuffer, so drawing a map every frame does not reallocate buffers.
 	D2DCLASS(BatchedTileset, public Tileset)
 	{
 	public:
@@ -72,13 +101,47 @@ namespace Dragon2D
 
 		virtual void Render(int id) override;
 		virtual void FlushBatched();
-	private:
-		GLuint vertexBuffer;
-		GLuint uvBuffer;
-
-		std::vector<glm::vec2> rawVertexBuffer;
-		std::vector<glm::vec2> rawUVBuffer;
 
+		//function: AddMeshTile
+		//note: adds a tile for the next BuildMesh(). x, y are in tiles, counted down from the top like map positions: the tile covers x to x+1 and y to y+1
+		void AddMeshTile(int id, int x, int y);
+		//function: BuildMesh
+		//note: puts the tiles of AddMeshTile() into mesh, replacing what it had
+		void BuildMesh(TileMesh& mesh);
+		//function: IsMeshCurrent
+		//note: false if the tiles or the texture changed since mesh was built (i.e. the texture finished loading), then it has to be built again
+		bool IsMeshCurrent(const TileMesh& mesh);
+		//function: DrawMesh
+		//note: draws mesh with one draw call. A vertex goes to transform.xy + position * transform.zw on the screen (0 to 1 from the bottom left), so scrolling only changes transform
+		void DrawMesh(const TileMesh& mesh, const glm::vec4& transform);
+	private:
+		//class: TileVertex
+		//note: a corner of a tile. position on the screen from the bottom left, uv on the image of the tileset
+		struct TileVertex
+		{
+			glm::vec2 position;
+			glm::vec2 uv;
+		};
+
+		//function: _AddTile
+		//note: adds the 4 vertices of tile id at pos (the lower left corner) with size to vertices. The uvs are on the image of the tileset
+		void _AddTile(std::vector<TileVertex>& vertices, glm::vec2 pos, glm::vec2 size, int id);
+		//function: _ReserveIndices
+		//note: makes the shared index buffer large enough for tiles tiles
+		void _ReserveIndices(std::size_t tiles);
+
+		//var: rawVertices. the tiles since the last flush, 4 vertices each
+		std::vector<TileVertex> rawVertices;
+		//var: meshVertices. the tiles of AddMeshTile() for the next BuildMesh()
+		std::vector<TileVertex> meshVertices;
+		//var: vertexStream. the vertices of the last frames. Created by the first flush (copies of the object share it)
+		std::shared_ptr<StreamBuffer> vertexStream;
+		//var: indexBuffer. the index buffer, shared by all BatchedTilesets. The last one deletes it
+		std::shared_ptr<GLuint> indexBuffer;
+
+		//var: sharedIndexBuffer, indexedTiles. the index buffer while any BatchedTileset has it, and for how many tiles it has indices
+		static std::weak_ptr<GLuint> sharedIndexBuffer;
+		static std::size_t indexedTiles;
 	protected:
 
 	};
@@ -34,6 +34,8 @@ namespace Dragon2D
 
 	void Ui::Render()
 	{
+		//the ui is drawn by TailTipUI, on top of the sprites before it
+		Env::GetSpriteBatch().Flush();
 		xmlloader.RenderElements();
 		BaseClass::Render();
 	}
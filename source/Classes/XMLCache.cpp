@@ -0,0 +1,71 @@
+#include "XMLCache.h"
+#include "MappedFile.h"
+
+#include <memory>
+
+namespace Dragon2D
+{
+	const char* XMLCache::Extension = ".hxc";
+
+	bool XMLCache::Load(const std::string& file, HoardXML::CompactDocument& doc)
+	{
+		std::uint64_t size;
+		std::int64_t mtime;
+		if (!MappedFile::Stat(file, size, mtime)) {
+			return false;
+		}
+
+		//try the cache first
+		std::string cacheName = file + Extension;
+		std::shared_ptr<MappedFile> cache = std::make_shared<MappedFile>(cacheName);
+		const Header* header = nullptr;
+		if (cache->IsOpen() && cache->GetSize() >= sizeof(Header)) {
+			header = reinterpret_cast<const Header*>(cache->GetData());
+			if (std::memcmp(header->magic, "HXCF", 4) != 0 || header->version != Version
+				|| header->sourceSize != size || header->arenaSize != cache->GetSize() - sizeof(Header)) {
+				header = nullptr;
+			}
+		}
+		//same size and time: use it without touching the source
+		if (header && header->sourceMtime == mtime
+			&& doc.SetBuffer(cache->GetData() + sizeof(Header), (std::size_t)header->arenaSize, cache)) {
+			return true;
+		}
+
+		MappedFile source(file);
+		if (!source.IsOpen()) {
+			return false;
+		}
+		std::uint64_t hash = MappedFile::Hash(source.GetData(), source.GetSize());
+		//only the time changed (e.g. the file was copied or checked out again): the content is the same
+		if (header && header->sourceHash == hash
+			&& doc.SetBuffer(cache->GetData() + sizeof(Header), (std::size_t)header->arenaSize, cache)) {
+			//update the time, so the next start does not have to hash again. doc does not need the old mapping then.
+			HoardXML::CompactDocument copy;
+			copy.SetBuffer(std::vector<char>(doc.GetBufferData(), doc.GetBufferData() + doc.GetBufferSize()));
+			doc = std::move(copy);
+			cache.reset();
+			Save(file, doc, size, mtime, hash);
+			return true;
+		}
+		cache.reset();
+
+		//parse it and write the cache for the next time
+		doc.Load(source.GetData(), source.GetSize());
+		Save(file, doc, size, mtime, hash);
+		return true;
+	}
+
+	bool XMLCache::Save(const std::string& file, const HoardXML::CompactDocument& doc, std::uint64_t size, std::int64_t mtime, std::uint64_t hash)
+	{
+		Header header;
+		std::memcpy(header.magic, "HXCF", 4);
+		header.version = Version;
+		header.sourceSize = size;
+		header.sourceMtime = mtime;
+		header.sourceHash = hash;
+		header.arenaSize = doc.GetBufferSize();
+
+		return MappedFile::WriteAtomic(file + Extension, { { &header, sizeof(Header) }, { doc.GetBufferData(), doc.GetBufferSize() } });
+	}
+}
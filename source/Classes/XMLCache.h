@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "../HoardXML/include/HoardXML.h"
+
+namespace Dragon2D
+{
+	//class: XMLCache
+	//note: Keeps the parsed form of xml files on disk. The CompactDocument of "file.xml" is stored in "file.xml.hxc", together with size, modification time and hash of the source.
+	//note: If the cache matches the source, it is memory mapped and used without parsing anything. Otherwise the source is parsed and the cache is (re)written.
+	class XMLCache
+	{
+	public:
+		//const: Extension
+		//note: appended to the name of the source to get the name of the cache
+		static const char* Extension;
+		//const: Version
+		//note: Version of the cache file format. Increase when Header changes, caches with other versions are rebuild.
+		static const std::uint32_t Version = 1;
+
+		//function: Load
+		//note: Loads the xml file "file" into doc, using the cache if possible. Returns false if the file does not exist.
+		//param:	file: the xml file to load
+		//		doc: gets the document
+		static bool Load(const std::string& file, HoardXML::CompactDocument& doc);
+
+		//function: Save
+		//note: Writes the cache for doc, which was parsed from a source with the given size, mtime and hash. Returns false if the cache can not be written.
+		//param:	file: the xml file doc was parsed from
+		//		doc: the document to store
+		//		size, mtime, hash: describe the source, see MappedFile::Stat and MappedFile::Hash
+		static bool Save(const std::string& file, const HoardXML::CompactDocument& doc, std::uint64_t size, std::int64_t mtime, std::uint64_t hash);
+
+	private:
+		//struct: Header
+		//note: starts every cache file. The arena of the document follows directly.
+		struct Header
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sourceSize;
+			std::int64_t sourceMtime;
+			std::uint64_t sourceHash;
+			std::uint64_t arenaSize;
+		};
+	};
+}
@@ -9,336 +9,1171 @@
 #include <vector>
 #include <map>
 #include <list>
-#include <regex>
 #include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
 
 //namespace: HoardXML
 //info: holds all the classes and functions used by HoardXML
 namespace HoardXML {
 
-//class: Tag
-//info: Tag contains a document-tag. 
-class Tag 
+//class: StringRef
+//info: A non-owning view on a string inside a CompactDocument or the source of a Reader. Valid as long as the document lives. 
+//		Strings of a CompactDocument are zero-terminated, so Data() can be passed to atoi and friends directly. 
+//		Strings of a Reader point into the source and are not, use ToInt and ToFloat for them.
+class StringRef
 {
 public:
-	//constructor: Tag
-	//note: Creates an empty Tag
-	Tag() 
-	: name(""), isEmptyTag(false) 
+	//constructor: StringRef
+	//note: Creates an empty StringRef
+	StringRef() 
+	: data(""), size(0) 
 	{
 	
 	}
-	
-	//constructor: Tag
-	//note: Creates an Tag with the name "tagName"
-	//param: name: name of the new Tag
-	Tag(std::string tagName) 
-	: name(tagName), isEmptyTag(false)
+
+	//constructor: StringRef
+	//note: Creates a StringRef viewing size chars at d. d[size] has to be '\0'.
+	StringRef(const char* d, std::size_t s) 
+	: data(d), size(s)
 	{
-		
+
 	}
-	
-	//constructor: Tag
-	//note: Creates an Tag with the name "tagName" and parses the string "toParse" to fill itself with content
-	//param: 	name: name of the new Tag
-	//		toParse: the string to parse into the tag. 
-	Tag(std::string tagName, std::string toParse) 
-	: name(tagName), isEmptyTag(false)
+
+	//function: Data
+	//note: returns the zero-terminated string 
+	const char* Data() const
 	{
-		Load(toParse);
+		return data;
 	}
 
-	//destructor: ~Tag
-	//note: does not much since all subclasses are self-deliting
-	virtual ~Tag() 
+	//function: Size
+	//note: returns the length of the string, without the terminating zero
+	std::size_t Size() const
 	{
-		//nothing 
+		return size;
 	}
-	
 
-	//function: GetName
-	//note: returns the name of the Tag
-	std::string GetName() const
+	//function: Empty
+	//note: returns true if the string is empty
+	bool Empty() const
 	{
-		return name;
+		return size==0;
 	}
-	
-	//function: SetName
-	//note: Sets the name of the Tag. 
-	//param: 	newName: name to set the tags to. 
-	void SetName(std::string newName) 
+
+	//function: Str
+	//note: returns a copy of the string 
+	std::string Str() const
 	{
-		name=newName;
+		return std::string(data, size);
 	}
 
-	//function: GetAttribute 
-	//note: Returns a specific attribute. Returns an empty string if the Attribute is unknown.
-	std::string GetAttribute(std::string attribute)
+	//function: ToInt
+	//note: converts the string to int, like atoi does
+	int ToInt() const
 	{
-		return attributes[attribute];
+		char buffer[32];
+		return std::atoi(_Terminated(buffer, sizeof(buffer)));
 	}
 
-	//function: SetAttribute
-	//note: sets a specific attribute to value "data"
-	//param: 	attribute: the attribute to set 
-	//		data: the data to set the value of the attribute to.		
-	void SetAttribute(std::string attribute, std::string data) 
+	//function: ToFloat
+	//note: converts the string to float, like atof does
+	float ToFloat() const
 	{
-		attributes[attribute] = data;
+		char buffer[64];
+		return static_cast<float>(std::atof(_Terminated(buffer, sizeof(buffer))));
 	}
 
-	//function: GetData
-	//note: returns the data of this tag 
-	std::string GetData() const
+	bool operator==(const StringRef& other) const
 	{
-		return data;
+		return size==other.size && std::memcmp(data, other.data, size)==0;
 	}
 
-	//function: SetData
-	//note: sets the data of this Tag
-	//param:	newData: data to set 
-	void SetData(std::string newData) 
+	bool operator==(const char* other) const
 	{
-		data = newData;
+		return std::strlen(other)==size && std::memcmp(data, other, size)==0;
 	}
 
-	//function: GetAttributes()
-	//note: returns a reference to the attributes of the tag. All of them, packed in a std::map 
-	std::map<std::string, std::string>& GetAttributes() 
+	bool operator==(const std::string& other) const
 	{
-		return attributes;
+		return size==other.size() && std::memcmp(data, other.data(), size)==0;
 	}
 
-	//function: GetChildren
-	//note: returns a reference to the children of this tag. 
-	std::vector<Tag>& GetChildren() 
+	template<class T>
+	bool operator!=(const T& other) const
 	{
-		return children;
+		return !(*this==other);
 	}
-	
-	//function: SetEmptyTag
-	//note: Sets this tag to be witout data and children. 
-	//note: it will be Serialized as <name [attributes]\>. 
-	//note: SETTING TO TRUE ERASES ALL DATA AND CHILD ELEMENTS!
-	//param:	b: Parameter to set isEmptyTag to.
-	void SetEmptyTag(bool b)
+
+private:
+	//function: _Terminated
+	//note: returns a zero-terminated version of the string, copied into buffer if needed. Numbers never need more then the buffer. 
+	const char* _Terminated(char* buffer, std::size_t bufferSize) const
 	{
-		isEmptyTag = b;
-		if(isEmptyTag) {
-			data = "";
-			children.clear();
+		std::size_t length = std::min(size, bufferSize-1);
+		std::memcpy(buffer, data, length);
+		buffer[length] = '\0';
+		return buffer;
+	}
+
+	const char* data;
+	std::size_t size;
+};
+
+//operator: <<
+//note: writes a StringRef to a stream 
+inline std::ostream& operator<<(std::ostream& out, const StringRef& s)
+{
+	return out.write(s.Data(), s.Size());
+}
+
+//function: ReadFile
+//note: reads the whole file "filename" into out. Returns false if the file cant be opened. 
+inline bool ReadFile(const std::string& filename, std::string& out)
+{
+	std::ifstream infile(filename, std::ios::in | std::ios::binary);
+	if(!infile.is_open()) {
+		out.clear();
+		return false;
+	}
+	infile.seekg(0, std::ios::end);
+	std::streamoff length = infile.tellg();
+	infile.seekg(0, std::ios::beg);
+	out.resize(length>0 ? static_cast<std::size_t>(length) : 0);
+	if(!out.empty()) {
+		infile.read(&out[0], out.size());
+		out.resize(static_cast<std::size_t>(infile.gcount()));
+	}
+	return true;
+}
+
+//class: Reader
+//info: A pull reader. It walks over the raw bytes of a document and reports one event per call of Next(), without building a tree. 
+//		Nothing is copied: names, values and text are StringRefs into the source, so the source has to outlive the reader.
+//		The rules are the same as for Document, so a document read tag by tag contains exactly what a Document would contain.
+//info: Events:
+//		EVENT_START_TAG: a tag begins. GetName() is the name of the tag. The attributes of the tag follow as EVENT_ATTRIBUTE.
+//		EVENT_ATTRIBUTE: GetName() and GetValue() are name and value of an attribute of the last started tag. 
+//		EVENT_TEXT: GetValue() is a part of the data of the current tag, as it is in the source. Newlines and tabs are not removed, use CleanData for that.
+//		EVENT_END_TAG: the current tag ends. Stand-alone tags (<name/>) get one too, IsEmptyTag() tells them apart. 
+//			Tags that are still open at the end of the document are closed as well.
+//		EVENT_END_DOCUMENT: there is nothing left to read. Returned by every following call of Next(), too.
+class Reader
+{
+public:
+	enum Event {
+		EVENT_START_TAG,
+		EVENT_ATTRIBUTE,
+		EVENT_TEXT,
+		EVENT_END_TAG,
+		EVENT_END_DOCUMENT
+	};
+
+	//constructor: Reader
+	//note: Creates a reader for size bytes at data
+	//param: 	data: the document 
+	//		size: size of the document in bytes
+	//		pos: position to start reading at
+	//		rootName: name of the tag that contains the part to read. Its end-tag ends the document. 
+	Reader(const char* data, std::size_t size, std::size_t pos = 0, StringRef rootName = StringRef())
+	: src(data), size(size), pos(pos), rootName(rootName), event(EVENT_END_DOCUMENT), depth(0), inAttributes(false), emptyTag(false), finished(false), 
+	  attributeBegin(0), attributePos(0), tagEnd(0)
+	{
+
+	}
+
+	//function: Next
+	//note: reads the next event and returns it 
+	Event Next()
+	{
+		if(finished) {
+			return event = EVENT_END_DOCUMENT;
+		}
+		emptyTag = false;
+		if(inAttributes) {
+			if(_NextAttribute(attributePos, name, value)) {
+				return event = EVENT_ATTRIBUTE;
+			}
+			inAttributes = false;
+			//now check if it is an empty tag (-> <tag bub="blahrg> /> )
+			if(FindFirstOf(src, "/", attributePos, tagEnd)!=tagEnd) {
+				emptyTag = true;
+				return _CloseTag();
+			}
+		}
+		const char* whitespace = " \n\t\r";
+		while(pos<size) {
+			const char* found = static_cast<const char*>(std::memchr(src+pos, '<', size-pos));
+			if(!found) {
+				break;
+			}
+			std::size_t tagBegin = found-src;
+			if(tagBegin>pos) {
+				name = StringRef();
+				value = StringRef(src+pos, tagBegin-pos);
+				depth = open.size();
+				pos = tagBegin;
+				return event = EVENT_TEXT;
+			}
+			const char* foundEnd = static_cast<const char*>(std::memchr(src+tagBegin, '>', size-tagBegin));
+			std::size_t end = foundEnd ? foundEnd-src : size;
+			pos = end+1;
+			//tagBegin..end is the whole tag, including the brackets
+			std::size_t namePos = FindFirstNotOf(src, whitespace, tagBegin+1, size);
+			if(namePos>=end) {
+				continue;
+			}
+			//is a end-tag?
+			if(src[namePos]=='/') {
+				//get the name of this end-tag. in theory it should be the name of the current tag, but who knows
+				std::size_t endNamePos = FindFirstNotOf(src, " \n\t\r/", namePos, end);
+				std::size_t endNameEnd = FindFirstOf(src, " \n\t\r/", endNamePos, end);
+				StringRef endName(src+endNamePos, endNameEnd-endNamePos);
+				if(open.empty() && endName==rootName) {
+					return _Finish();
+				}
+				if(!open.empty() && endName==open.back()) {
+					return _CloseTag();
+				}
+				//otherewise this tag is bad, and it should feel bad. becomes data
+				name = StringRef();
+				value = StringRef(src+tagBegin, std::min(end, size-1)-tagBegin+1);
+				depth = open.size();
+				return event = EVENT_TEXT;
+			}
+			//no, its a normal tag. 
+			std::size_t nameEnd = FindFirstOf(src, " \n\t\r/", namePos, end);
+			name = StringRef(src+namePos, nameEnd-namePos);
+			value = StringRef();
+			open.push_back(name);
+			depth = open.size();
+			inAttributes = true;
+			attributeBegin = attributePos = nameEnd;
+			tagEnd = end;
+			return event = EVENT_START_TAG;
 		}
+		//the document ended. close whatever is still open
+		if(!open.empty()) {
+			return _CloseTag();
+		}
+		return _Finish();
 	}
 
-	//function: GetEmptyTag
-	//note: Returns if this tag is stand-alone without data and children 
-	bool GetEmptyTag() 
+	//function: GetEvent
+	//note: returns the last event returned by Next
+	Event GetEvent() const
 	{
-		return isEmptyTag;
+		return event;
 	}
-	
 
-	//function: AddChild
-	//note: Adds a child to this tag. 
-	//param:	c: Tag to add
-	void AddChild(Tag& c) 
+	//function: GetName
+	//note: returns the name of the tag (EVENT_START_TAG, EVENT_END_TAG) or attribute (EVENT_ATTRIBUTE)
+	StringRef GetName() const
 	{
-		children.push_back(c);
+		return name;
 	}
- 	
-	//function: Serialize 
-	//note: serializes the tag and its subtags including the data into a xml-tree
-	//param:	depth: The depth of this operation. causes depth times '/t's added at the biginning to every line of the output 
-	virtual std::string Serialize(int depth=0)
+
+	//function: GetValue
+	//note: returns the value of the attribute (EVENT_ATTRIBUTE) or the text (EVENT_TEXT)
+	StringRef GetValue() const
 	{
-		std::string tabs;
-		for (int i = 0; i<depth;i++) {
-			tabs+='\t';
+		return value;
+	}
+
+	//function: GetAttribute
+	//note: returns a attribute of the last started tag, or an empty StringRef if it is unknown. Only works at EVENT_START_TAG and EVENT_ATTRIBUTE.
+	//note: if a attribute is set twice, the last value counts (as in Tag).
+	//param:	attribute: name of the attribute 
+	StringRef GetAttribute(const char* attribute) const
+	{
+		StringRef result;
+		if(event!=EVENT_START_TAG && event!=EVENT_ATTRIBUTE) {
+			return result;
 		}
-		std::string result;
-		result += tabs+std::string("<")+name+std::string(" ");
-		for (auto elem = attributes.begin(); elem!=attributes.end(); elem++) {
-			result += elem->first+std::string("=\"")+elem->second+std::string("\" ");
+		std::size_t p = attributeBegin;
+		StringRef n, v;
+		while(_NextAttribute(p, n, v)) {
+			if(n==attribute) {
+				result = v;
+			}
 		}
-		if(isEmptyTag) {
-			result+=std::string("/>\n");
-			return result;
+		return result;
+	}
+
+	//function: IsEmptyTag
+	//note: returns true if the current EVENT_END_TAG belongs to a stand-alone tag (<name/>)
+	bool IsEmptyTag() const
+	{
+		return emptyTag;
+	}
+
+	//function: GetDepth
+	//note: returns the depth of the current event. Top-level tags (and their attributes and text) have depth 1, text outside of them has depth 0. 
+	std::size_t GetDepth() const
+	{
+		return depth;
+	}
+
+	//function: GetPosition
+	//note: returns the position of the reader in the source. At EVENT_END_DOCUMENT it points behind the end-tag of the root. 
+	std::size_t GetPosition() const
+	{
+		return pos;
+	}
+
+	//function: SkipTag
+	//note: skips everything up to and including the end-tag of the current tag. Call it at EVENT_START_TAG or EVENT_ATTRIBUTE.
+	void SkipTag()
+	{
+		std::size_t tagDepth = depth;
+		while(Next()!=EVENT_END_DOCUMENT) {
+			if(event==EVENT_END_TAG && depth==tagDepth) {
+				return;
+			}
 		}
-		result+=std::string(">");
-		if(children.size()!=0) {
-			result += "\n";
-			for (Tag t : children) {
-				result+=t.Serialize(depth+1);
+	}
+
+	//function: NextChild
+	//note: reads up to the next tag that is a direct child of the tag at parentDepth and returns true. Everything on the way is skipped. 
+	//		returns false once the tag at parentDepth ended. Use parentDepth 0 for the top-level tags. 
+	//param:	parentDepth: depth of the parent tag, as returned by GetDepth() at its EVENT_START_TAG
+	bool NextChild(std::size_t parentDepth)
+	{
+		while(Next()!=EVENT_END_DOCUMENT) {
+			if(event==EVENT_START_TAG && depth==parentDepth+1) {
+				return true;
 			}
-			if(data!="") {
-				result += tabs+data+std::string("\n")+tabs;
+			if(event==EVENT_END_TAG && depth==parentDepth) {
+				return false;
 			}
 		}
-		else {
-			result+=data;
+		return false;
+	}
+
+	//function: ReadData
+	//note: reads up to and including the end-tag of the current tag and returns its data, cleaned like Tag::GetData. Call it at EVENT_START_TAG or EVENT_ATTRIBUTE.
+	std::string ReadData()
+	{
+		std::string result;
+		std::size_t tagDepth = depth;
+		while(Next()!=EVENT_END_DOCUMENT) {
+			if(event==EVENT_TEXT && depth==tagDepth) {
+				result.append(value.Data(), value.Size());
+			}
+			else if(event==EVENT_END_TAG && depth==tagDepth) {
+				break;
+			}
 		}
-		result+=std::string("</")+name+std::string(">\n");
+		CleanData(result);
 		return result;
 	}
-	
-	//operator: []
-	//note: reurns a vector of pointers to child tags with matching namepath.
-	//	 if there are multiple tags of one name in a layer AND you want tags from deeper layers, it will use the first known.
-	//	 if you want to get all of them, use GetChildren and search them yourself. 
-	//	 syntax is name(.name2(.name3...))
-	//param:	tagName: name of the tag to get, as dom-path (foo.bar.blahrg) 	
-	std::vector<Tag*> operator[](std::string tagName)  
+
+	//function: CleanData
+	//note: fixes the data of a tag. removes newlines and tabs and collapses double spaces, as Tag does it with its data. 
+	static void CleanData(std::string& data)
 	{
-		std::vector<Tag*> resultlist;
-		static std::regex nameRE("[.]?([\\w\\d]+)([\\w\\d.]*)");
-		std::smatch m;
-		if(std::regex_search(tagName, m, nameRE)) {
-			if(m[1]!="") {
-				for(auto t = children.begin(); t!=children.end(); t++) {
-					if(m[1]==t->GetName()) {
-						if(m[2]=="") {
-							resultlist.push_back(&(*t));
-						}
-						else {
-							std::vector<Tag*> l = (*t)[m[2]];
-							resultlist.insert(resultlist.end(), l.begin(), l.end());
-							break;
-						}
-					}
-				}
+		std::size_t out = 0;
+		for(std::size_t in = 0; in<data.size(); in++) {
+			char c = data[in];
+			if(c=='\n' || c=='\r' || c=='\t' || (c==' ' && out>0 && data[out-1]==' ')) {
+				continue;
 			}
+			data[out++] = c;
 		}
-		return resultlist;
+		data.resize(out);
 	}
 
-	//function: Load
-	//note: Loads tag-content into this tag
-	//param: 	toParse: data to parse
-	std::string Load(std::string toParse)
+	//function: IsOneOf
+	//note: returns true if c is one of the characters in chars. Other then std::strchr it never matches the terminating zero.
+	static bool IsOneOf(char c, const char* chars)
 	{
-		std::size_t pos = toParse.npos;
-		while((pos=toParse.find("<"))!=toParse.npos) {
-			data += toParse.substr(0,pos);
-			std::size_t endpos = toParse.find(">", pos);
-			std::string tagstring = toParse.substr(pos,endpos-pos+1);
-			toParse = toParse.substr(endpos+1, toParse.size()-endpos);
-			//create the new Tag
-			std::size_t newTagPos = 0;
-			if((newTagPos=tagstring.find_first_not_of("<> \n\t"))!=tagstring.npos) {
-				//is a end-tag?
-				if(tagstring[newTagPos]=='/' ) {
-					//get the name of this end-tag. in theory it should be the name of this tag, but who knows
-					std::size_t endTagNamePos = tagstring.find_first_not_of("<> \n\t/", newTagPos); 
-					std::size_t endTagNameEnd = tagstring.find_first_of("<> \n\t", endTagNamePos);
-					std::string endTagName = tagstring.substr(endTagNamePos,endTagNameEnd-endTagNamePos);
-					//if its us, were done here. 
-					if(endTagName==name) {
-						break;
-					} else { //otherewise this tag is bad, and it should feel bad. becomes data
-						data+=tagstring;
-					}
-				} else { //no, its a normal tag. parse it, add it as child and let it continue the parsing
-					std::size_t tagNamePos = tagstring.find_first_not_of("<> \n\t/", newTagPos); 
-					std::size_t tagNameEnd = tagstring.find_first_of("<> \n\t", tagNamePos);
-					std::string tagName = tagstring.substr(tagNamePos,tagNameEnd-tagNamePos);
-					Tag child(tagName);
-					//we have the name, we need the attributes: foo="bar". find the equal, go left, then right, then cut the string to parse.
-					std::string attributeString = tagstring.substr(tagNameEnd+1, tagstring.size()-tagNameEnd);
-					std::size_t equalPos = attributeString.npos;
-					while((equalPos=attributeString.find("="))!=attributeString.npos) {
-						std::string l = attributeString.substr(0,equalPos);
-						l.erase (std::remove (l.begin(), l.end(), ' '), l.end());
-						std::size_t rBegin = attributeString.find_first_of("\"'",equalPos+1);
-						std::size_t rEnd = attributeString.find_first_of("\"'",rBegin+1);
-						std::string r = attributeString.substr(rBegin+1,rEnd-rBegin-1);
-						child.SetAttribute(l,r);
-						attributeString = attributeString.substr(rEnd+1,attributeString.size()-rEnd);
-					}
-					//now check if it is an empty tag (-> <tag bub="blahrg> /> )
-					//if not, let it parse.
-					if(attributeString.find("/")!=attributeString.npos) {
-						child.SetEmptyTag(true);
-					} else {
-						toParse = child.Load(toParse);
-					}
-					AddChild(child);
-				}
+		return c!='\0' && std::strchr(chars, c)!=nullptr;
+	}
+
+	//function: FindFirstOf
+	//note: like std::string::find_first_of, but only searches between pos and end. returns end if nothing is found 
+	static std::size_t FindFirstOf(const char* s, const char* chars, std::size_t pos, std::size_t end)
+	{
+		if(pos>=end) {
+			return end;
+		}
+		//a single character is a lot faster with memchr
+		if(chars[0]!='\0' && chars[1]=='\0') {
+			const void* found = std::memchr(s+pos, chars[0], end-pos);
+			return found ? static_cast<const char*>(found)-s : end;
+		}
+		for(; pos<end; pos++) {
+			if(IsOneOf(s[pos], chars)) {
+				return pos;
 			}
 		}
-		//last step is to fix the data. remove newlines, double spaces etc. 
-		data.erase (std::remove (data.begin(), data.end(), '\n'), data.end());
-		data.erase (std::remove (data.begin(), data.end(), '\r'), data.end());
-		data.erase (std::remove (data.begin(), data.end(), '\t'), data.end());
-		data.erase(std::unique(data.begin(), data.end(), [](char lhs, char rhs) { return (lhs == rhs) && (lhs == ' '); }), data.end());   
-		return toParse;
+		return end;
 	}
-	
+
+	//function: FindFirstNotOf
+	//note: like std::string::find_first_not_of, but only searches between pos and end. returns end if nothing is found 
+	static std::size_t FindFirstNotOf(const char* s, const char* chars, std::size_t pos, std::size_t end)
+	{
+		for(; pos<end; pos++) {
+			if(!IsOneOf(s[pos], chars)) {
+				return pos;
+			}
+		}
+		return end;
+	}
+
 private:
-	//var: name. Holds the name of this tag. 
-	std::string name;
-	//var: data. Holds the data of this tag. 
-	std::string data;
-	//var: attributes. Holds the attributes of this tag. 
-	std::map<std::string, std::string> attributes;
-	//var: children. Holds the children of this tag. 
-	std::vector<Tag> children;
-	//var: isEmptyTag. Holds if it is a single tag without data. 
-	bool isEmptyTag;
-	
+	//function: _NextAttribute
+	//note: reads the next attribute behind p in the last started tag: foo="bar". find the equal, go left, then right, continue behind the value.
+	bool _NextAttribute(std::size_t& p, StringRef& attributeName, StringRef& attributeValue) const
+	{
+		const char* whitespace = " \n\t\r";
+		std::size_t equalPos = FindFirstOf(src, "=", p, tagEnd);
+		if(equalPos==tagEnd) {
+			return false;
+		}
+		std::size_t lBegin = FindFirstNotOf(src, whitespace, p, equalPos);
+		std::size_t lEnd = equalPos;
+		while(lEnd>lBegin && IsOneOf(src[lEnd-1], whitespace)) {
+			lEnd--;
+		}
+		std::size_t rBegin = FindFirstOf(src, "\"'", equalPos+1, tagEnd);
+		if(rBegin==tagEnd) {
+			p = tagEnd;
+			return false;
+		}
+		std::size_t rEnd = FindFirstOf(src, "\"'", rBegin+1, tagEnd);
+		attributeName = StringRef(src+lBegin, lEnd-lBegin);
+		attributeValue = StringRef(src+rBegin+1, rEnd-rBegin-1);
+		p = rEnd<tagEnd ? rEnd+1 : tagEnd;
+		return true;
+	}
+
+	Event _CloseTag()
+	{
+		name = open.back();
+		value = StringRef();
+		depth = open.size();
+		open.pop_back();
+		return event = EVENT_END_TAG;
+	}
+
+	Event _Finish()
+	{
+		finished = true;
+		name = value = StringRef();
+		depth = 0;
+		if(pos>size) {
+			pos = size;
+		}
+		return event = EVENT_END_DOCUMENT;
+	}
 
+	const char* src;
+	std::size_t size;
+	std::size_t pos;
+	StringRef rootName;
+	//var: open. names of the currently open tags 
+	std::vector<StringRef> open;
+	Event event;
+	StringRef name;
+	StringRef value;
+	std::size_t depth;
+	bool inAttributes;
+	bool emptyTag;
+	bool finished;
+	//var: attributeBegin, attributePos, tagEnd. the attribute-part of the last started tag and how far it is read
+	std::size_t attributeBegin;
+	std::size_t attributePos;
+	std::size_t tagEnd;
 };
 
-//class: Document
-//info: Document is the "root" tag of a xml. 	
-//		while you can do nearly everything with Tag itself, document manages saving, loading and other stuff for you. 
-//parent: Tag
-class Document : public Tag
+//class: TreeParser
+//info: Builds trees from a Reader. Used by Tag::Load and CompactDocument::Load, so every tree type shares the exact same parsing rules. 
+//info: A builder has to provide:
+//		AppendData(text): a part of the data of the current tag was found
+//		AddChild(name): adds a child with that name and returns the builder for it
+//		SetAttribute(name, value): adds an attribute to the current tag
+//		SetEmptyTag(): marks the current tag as stand-alone tag (<name [attributes]/>)
+//		Finish(): called after the end-tag of the current tag (or the end of the document) was reached
+class TreeParser
 {
 public:
-	//constructor: Document
-	//note: Creates an empty document
-	Document() 
+	//function: Parse
+	//note: Parses the content of a tag, starting at position pos of src. 
+	//param: 	src: data to parse
+	//		pos: position to start parsing at
+	//		rootName: name of the tag to fill. Parsing stops at its end-tag.
+	//		builder: builder of the tag to fill
+	//return: the position behind the end-tag of this tag (or src.size() if the document ended before)
+	template<class Builder>
+	static std::size_t Parse(const std::string& src, std::size_t pos, StringRef rootName, Builder& builder)
 	{
-	
+		return Parse(src.data(), src.size(), pos, rootName, builder);
 	}
-	
-	//constructor: Document
-	//note: Creates an document form a file with name "filename". 
-	//		calling save without argbuments on this will save it to that exact file. 
-	//param: the file to load from and save to by name
-	Document(std::string filename)
+
+	//function: Parse
+	//note: Same as above, for size bytes at src
+	template<class Builder>
+	static std::size_t Parse(const char* src, std::size_t size, std::size_t pos, StringRef rootName, Builder& builder)
 	{
-		std::ifstream infile(filename);
-		std::string indata = std::string(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
-		Load(indata);
+		Reader reader(src, size, pos, rootName);
+		Parse(reader, builder);
+		return reader.GetPosition();
 	}
 
-	//function: Save
-	//note: Saves a document to a file named by "filename"
-	//param: 	filename: file to save to
-	void Save(std::string filename)
+	//function: Parse
+	//note: Fills builder with everything reader finds until the current tag ends. Recurses for every child tag.
+	template<class Builder>
+	static void Parse(Reader& reader, Builder& builder)
 	{
-		std::fstream outfile(filename, std::ios::out);
-		outfile << Serialize();
-		outfile.close();
+		while(true) {
+			switch(reader.Next()) {
+			case Reader::EVENT_START_TAG: {
+				auto child = builder.AddChild(reader.GetName());
+				Parse(reader, child);
+				break;
+			}
+			case Reader::EVENT_ATTRIBUTE:
+				builder.SetAttribute(reader.GetName(), reader.GetValue());
+				break;
+			case Reader::EVENT_TEXT:
+				builder.AppendData(reader.GetValue());
+				break;
+			case Reader::EVENT_END_TAG:
+				if(reader.IsEmptyTag()) {
+					builder.SetEmptyTag();
+				}
+				builder.Finish();
+				return;
+			case Reader::EVENT_END_DOCUMENT:
+				builder.Finish();
+				return;
+			}
+		}
 	}
-	
-	//function: Save
-	//note: Saves a Document. Uses method intended by constructor
-	void Save() 
+};
+
+//class: Path
+//info: A compiled dom-path as used by Tag::operator[] (foo.bar.blahrg). Parse it once and reuse it for every lookup. 
+//		A segment is a run of letters, digits and '_', segments are seperated by '.'. Parsing stops at the first other character.
+class Path
+{
+public:
+	//constructor: Path
+	//note: Creates an empty path. It matches nothing.
+	Path() 
+	: valid(false) 
 	{
-			Save(savefile);
-	}
 	
-	//functions: Serialize
-	//note: overloaded Tag::Serialize that serializes a document 
-	//param: 	depth: tabs to add in the beginning of each line
+	}
+
+	//constructor: Path
+	//note: Compiles path
+	//param: 	path: the path as string (foo.bar.blahrg)
+	explicit Path(const std::string& path)
+	: valid(true)
+	{
+		std::size_t p = 0;
+		std::size_t size = path.size();
+		//everything in front of the first name is ignored
+		while(p<size && !_IsNameChar(path[p])) {
+			p++;
+		}
+		bool openDot = false;
+		while(p<size) {
+			std::size_t begin = p;
+			while(p<size && _IsNameChar(path[p])) {
+				p++;
+			}
+			if(p>begin) {
+				segments.push_back(path.substr(begin, p-begin));
+				hashes.push_back(std::hash<std::string>()(segments.back()));
+				openDot = false;
+			}
+			if(p<size && path[p]=='.') {
+				openDot = true;
+				p++;
+				continue;
+			}
+			break;
+		}
+		//a path that ends with a '.' (foo.) never matched anything, and still doesnt
+		if(segments.empty() || openDot) {
+			valid = false;
+		}
+	}
+
+	//function: IsValid
+	//note: returns false if the path can not match any tag 
+	bool IsValid() const
+	{
+		return valid;
+	}
+
+	//function: Size
+	//note: returns the number of segments
+	std::size_t Size() const
+	{
+		return segments.size();
+	}
+
+	//function: GetSegment
+	//note: returns the name of segment i
+	const std::string& GetSegment(std::size_t i) const
+	{
+		return segments[i];
+	}
+
+	//function: GetHash
+	//note: returns the hash of the name of segment i 
+	std::size_t GetHash(std::size_t i) const
+	{
+		return hashes[i];
+	}
+
+private:
+	static bool _IsNameChar(char c)
+	{
+		return (c>='a' && c<='z') || (c>='A' && c<='Z') || (c>='0' && c<='9') || c=='_';
+	}
+
+	std::vector<std::string> segments;
+	std::vector<std::size_t> hashes;
+	bool valid;
+};
+
+class Tag;
+
+//class: Writer
+//info: Writes tags as xml, straight into one string or into a std::ostream. Nothing is copied on the way, and the output grows in one buffer.
+//		Tag::Serialize and Document::Save use it. The default output is the format HoardXML always wrote.
+//info: Escaping is off by default: HoardXML does not turn entities back into characters when it loads, so escaped documents would not load as they were saved. 
+class Writer
+{
+public:
+	//constructor: Writer
+	//note: Creates a writer that appends to target
+	Writer(std::string& target) 
+	: str(&target), stream(nullptr), indent("\t"), escape(false) 
+	{
+	
+	}
+
+	//constructor: Writer
+	//note: Creates a writer that writes to target. The output is collected in blocks of BlockSize bytes before it goes to the stream.
+	Writer(std::ostream& target) 
+	: str(nullptr), stream(&target), indent("\t"), escape(false) 
+	{
+		buffer.reserve(BlockSize);
+	}
+
+	//destructor: ~Writer
+	//note: flushes the rest of the output 
+	~Writer() 
+	{
+		Flush();
+	}
+
+	//function: SetIndent
+	//note: Sets the string that is written once per depth at the beginning of a line. Default is one tab. 
+	void SetIndent(const std::string& newIndent)
+	{
+		indent = newIndent;
+	}
+
+	//function: SetEscape
+	//note: if set, &, <, >, " and ' in attributes and data are written as entities. Default is off.
+	void SetEscape(bool e) 
+	{
+		escape = e;
+	}
+
+	//function: Write
+	//note: writes tag and all of its children
+	//param:	tag: tag to write
+	//		depth: depth of the tag. Its lines start with depth times the indent.
+	inline void Write(const Tag& tag, int depth = 0);
+
+	//function: WriteChildren
+	//note: writes the children of tag, but not tag itself. Used for documents, wich are not written as tag. 
+	inline void WriteChildren(const Tag& tag, int depth = 0);
+
+	//function: Flush
+	//note: writes everything that is still buffered to the stream. 
+	void Flush()
+	{
+		if(stream && !buffer.empty()) {
+			stream->write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+
+private:
+	//const: BlockSize
+	//note: size of the blocks written to streams 
+	static const std::size_t BlockSize = 64*1024;
+
+	void _Put(const char* s, std::size_t length)
+	{
+		if(str) {
+			str->append(s, length);
+			return;
+		}
+		if(buffer.size()+length>BlockSize) {
+			Flush();
+		}
+		if(length>=BlockSize) {
+			stream->write(s, length);
+			return;
+		}
+		buffer.append(s, length);
+	}
+
+	void _Put(const std::string& s)
+	{
+		_Put(s.data(), s.size());
+	}
+
+	void _Put(char c)
+	{
+		_Put(&c, 1);
+	}
+
+	void _PutIndent(int depth)
+	{
+		for(int i = 0; i<depth; i++) {
+			_Put(indent);
+		}
+	}
+
+	//function: _PutText
+	//note: writes s, escaped if escaping is on
+	void _PutText(const std::string& s)
+	{
+		if(!escape) {
+			_Put(s);
+			return;
+		}
+		std::size_t begin = 0;
+		for(std::size_t i = 0; i<s.size(); i++) {
+			const char* entity = nullptr;
+			switch(s[i]) {
+			case '&': entity = "&amp;"; break;
+			case '<': entity = "&lt;"; break;
+			case '>': entity = "&gt;"; break;
+			case '"': entity = "&quot;"; break;
+			case '\'': entity = "&apos;"; break;
+			default: continue;
+			}
+			_Put(s.data()+begin, i-begin);
+			_Put(entity, std::strlen(entity));
+			begin = i+1;
+		}
+		_Put(s.data()+begin, s.size()-begin);
+	}
+
+	std::string* str;
+	std::ostream* stream;
+	std::string buffer;
+	std::string indent;
+	bool escape;
+};
+
+//class: Tag
+//info: Tag contains a document-tag. 
+class Tag 
+{
+public:
+	//constructor: Tag
+	//note: Creates an empty Tag
+	Tag() 
+	: name(""), isEmptyTag(false) 
+	{
+	
+	}
+	
+	//constructor: Tag
+	//note: Creates an Tag with the name "tagName"
+	//param: name: name of the new Tag
+	Tag(std::string tagName) 
+	: name(tagName), isEmptyTag(false)
+	{
+		
+	}
+	
+	//constructor: Tag
+	//note: Creates an Tag with the name "tagName" and parses the string "toParse" to fill itself with content
+	//param: 	name: name of the new Tag
+	//		toParse: the string to parse into the tag. 
+	Tag(std::string tagName, std::string toParse) 
+	: name(tagName), isEmptyTag(false)
+	{
+		Load(toParse);
+	}
+
+	//destructor: ~Tag
+	//note: does not much since all subclasses are self-deliting
+	virtual ~Tag() 
+	{
+		//nothing 
+	}
+
+	//note: the destructor above would drop the implicit moves, without them moving a Tag copies the whole subtree
+	Tag(const Tag&) = default;
+	Tag(Tag&&) noexcept = default;
+	Tag& operator=(const Tag&) = default;
+	Tag& operator=(Tag&&) noexcept = default;
+	
+
+	//function: GetName
+	//note: returns the name of the Tag
+	std::string GetName() const
+	{
+		return name;
+	}
+	
+	//function: SetName
+	//note: Sets the name of the Tag. 
+	//param: 	newName: name to set the tags to. 
+	void SetName(std::string newName) 
+	{
+		name=newName;
+		_NameGeneration()++;
+	}
+
+	//function: GetAttribute 
+	//note: Returns a specific attribute. Returns an empty string if the Attribute is unknown.
+	std::string GetAttribute(std::string attribute)
+	{
+		return attributes[attribute];
+	}
+
+	//function: SetAttribute
+	//note: sets a specific attribute to value "data"
+	//param: 	attribute: the attribute to set 
+	//		data: the data to set the value of the attribute to.		
+	void SetAttribute(std::string attribute, std::string data) 
+	{
+		attributes[attribute] = data;
+	}
+
+	//function: GetData
+	//note: returns the data of this tag 
+	std::string GetData() const
+	{
+		return data;
+	}
+
+	//function: SetData
+	//note: sets the data of this Tag
+	//param:	newData: data to set 
+	void SetData(std::string newData) 
+	{
+		data = newData;
+	}
+
+	//function: GetAttributes()
+	//note: returns a reference to the attributes of the tag. All of them, packed in a std::map 
+	std::map<std::string, std::string>& GetAttributes() 
+	{
+		return attributes;
+	}
+
+	//function: GetChildren
+	//note: returns a reference to the children of this tag. 
+	std::vector<Tag>& GetChildren() 
+	{
+		return children;
+	}
+	
+	//function: SetEmptyTag
+	//note: Sets this tag to be witout data and children. 
+	//note: it will be Serialized as <name [attributes]\>. 
+	//note: SETTING TO TRUE ERASES ALL DATA AND CHILD ELEMENTS!
+	//param:	b: Parameter to set isEmptyTag to.
+	void SetEmptyTag(bool b)
+	{
+		isEmptyTag = b;
+		if(isEmptyTag) {
+			data = "";
+			children.clear();
+		}
+	}
+
+	//function: GetEmptyTag
+	//note: Returns if this tag is stand-alone without data and children 
+	bool GetEmptyTag() const
+	{
+		return isEmptyTag;
+	}
+	
+
+	//function: AddChild
+	//note: Adds a child to this tag. 
+	//param:	c: Tag to add
+	void AddChild(Tag& c) 
+	{
+		children.push_back(c);
+	}
+
+	//function: AddChild
+	//note: Adds a child to this tag without copying it. 
+	//param:	c: Tag to move into this tag
+	void AddChild(Tag&& c) 
+	{
+		children.push_back(std::move(c));
+	}
+ 	
+	//function: Serialize 
+	//note: serializes the tag and its subtags including the data into a xml-tree
+	//note: to write big trees, or with other options, use a Writer directly. 
+	//param:	depth: The depth of this operation. causes depth times '/t's added at the biginning to every line of the output 
+	virtual std::string Serialize(int depth=0)
+	{
+		std::string result;
+		Writer writer(result);
+		writer.Write(*this, depth);
+		return result;
+	}
+	
+	//operator: []
+	//note: reurns a vector of pointers to child tags with matching namepath.
+	//	 if there are multiple tags of one name in a layer AND you want tags from deeper layers, it will use the first known.
+	//	 if you want to get all of them, use GetChildren and search them yourself. 
+	//	 syntax is name(.name2(.name3...))
+	//note: compiles the path on every call. If you look up the same path often, keep a Path and use the other operator[]
+	//param:	tagName: name of the tag to get, as dom-path (foo.bar.blahrg) 	
+	std::vector<Tag*> operator[](std::string tagName)  
+	{
+		return (*this)[Path(tagName)];
+	}
+
+	//operator: []
+	//note: same as operator[](std::string), with a compiled path. 
+	//note: tags with a lot of children build an index of their children-names on the first lookup, so the lookup is a hash probe. 
+	//	 the index notices added and removed children and renamed tags. If you replace children through GetChildren() by tags with other names, 
+	//	 they might not be found until the number of children changes.
+	//param:	path: the compiled dom-path
+	std::vector<Tag*> operator[](const Path& path)
+	{
+		std::vector<Tag*> resultlist;
+		if(!path.IsValid()) {
+			return resultlist;
+		}
+		//follow the first match of every segment but the last one
+		Tag* current = this;
+		for(std::size_t i = 0; i+1<path.Size(); i++) {
+			current = current->_FindChildren(path, i, nullptr);
+			if(!current) {
+				return resultlist;
+			}
+		}
+		current->_FindChildren(path, path.Size()-1, &resultlist);
+		return resultlist;
+	}
+
+	//function: Load
+	//note: Loads tag-content into this tag
+	//param: 	toParse: data to parse
+	//return: the part of toParse that is left after the end-tag of this tag 
+	std::string Load(std::string toParse)
+	{
+		std::size_t pos = Load(toParse, 0);
+		return toParse.substr(pos);
+	}
+
+	//function: Load
+	//note: Loads tag-content into this tag, starting at position pos of toParse. 
+	//note: toParse is only read through a cursor, nothing of it is copied but the names, attributes and data that end up in the tags.
+	//param: 	toParse: data to parse
+	//		pos: position to start parsing at
+	//return: the position behind the end-tag of this tag (or toParse.size() if the document ended before)
+	std::size_t Load(const std::string& toParse, std::size_t pos)
+	{
+		Builder builder(*this);
+		return TreeParser::Parse(toParse, pos, StringRef(name.data(), name.size()), builder);
+	}
+	
+private:
+	friend class Writer;
+
+	//class: Builder
+	//info: Fills a Tag for the TreeParser
+	class Builder
+	{
+	public:
+		Builder(Tag& t) : tag(t) {}
+		void AppendData(StringRef text) { tag.data.append(text.Data(), text.Size()); }
+		Builder AddChild(StringRef childName) 
+		{
+			tag.children.emplace_back(childName.Str());
+			return Builder(tag.children.back());
+		}
+		void SetAttribute(StringRef attribute, StringRef value) { tag.attributes[attribute.Str()] = value.Str(); }
+		void SetEmptyTag() { tag.SetEmptyTag(true); }
+		void Finish() { Reader::CleanData(tag.data); }
+	private:
+		Tag& tag;
+	};
+
+	//struct: ChildIndex
+	//info: index of the children of a tag by the hash of their names. Knows for which children it was built.
+	struct ChildIndex
+	{
+		const Tag* children;
+		std::size_t childCount;
+		unsigned int nameGeneration;
+		std::unordered_map<std::size_t, std::vector<std::uint32_t>> byHash;
+	};
+
+	//const: IndexThreshold
+	//note: tags with less children are searched linearly, that is faster then hashing for them 
+	static const std::size_t IndexThreshold = 8;
+
+	//function: _NameGeneration
+	//note: counts the calls of SetName, so indices notice renamed children 
+	static std::atomic<unsigned int>& _NameGeneration()
+	{
+		static std::atomic<unsigned int> generation(0);
+		return generation;
+	}
+
+	//function: _FindChildren
+	//note: finds the children named like segment i of path. Returns the first one, and adds all of them to result if it is given.
+	Tag* _FindChildren(const Path& path, std::size_t i, std::vector<Tag*>* result)
+	{
+		const std::string& childName = path.GetSegment(i);
+		if(children.size()<IndexThreshold) {
+			Tag* first = nullptr;
+			for(auto& c : children) {
+				if(c.name==childName) {
+					first = first ? first : &c;
+					if(!result) {
+						break;
+					}
+					result->push_back(&c);
+				}
+			}
+			return first;
+		}
+		const ChildIndex& index = _GetChildIndex();
+		auto found = index.byHash.find(path.GetHash(i));
+		if(found==index.byHash.end()) {
+			return nullptr;
+		}
+		Tag* first = nullptr;
+		for(std::uint32_t k : found->second) {
+			//different names can have the same hash
+			if(children[k].name==childName) {
+				first = first ? first : &children[k];
+				if(!result) {
+					break;
+				}
+				result->push_back(&children[k]);
+			}
+		}
+		return first;
+	}
+
+	//function: _GetChildIndex
+	//note: returns the index of the children, (re)builds it if there is none or if the children changed. 
+	const ChildIndex& _GetChildIndex()
+	{
+		unsigned int generation = _NameGeneration();
+		if(!childIndex || childIndex->children!=children.data() || childIndex->childCount!=children.size() || childIndex->nameGeneration!=generation) {
+			std::shared_ptr<ChildIndex> newIndex = std::make_shared<ChildIndex>();
+			newIndex->children = children.data();
+			newIndex->childCount = children.size();
+			newIndex->nameGeneration = generation;
+			std::hash<std::string> hasher;
+			for(std::size_t k = 0; k<children.size(); k++) {
+				newIndex->byHash[hasher(children[k].name)].push_back(static_cast<std::uint32_t>(k));
+			}
+			childIndex = newIndex;
+		}
+		return *childIndex;
+	}
+
+	//var: name. Holds the name of this tag. 
+	std::string name;
+	//var: data. Holds the data of this tag. 
+	std::string data;
+	//var: attributes. Holds the attributes of this tag. 
+	std::map<std::string, std::string> attributes;
+	//var: children. Holds the children of this tag. 
+	std::vector<Tag> children;
+	//var: isEmptyTag. Holds if it is a single tag without data. 
+	bool isEmptyTag;
+	//var: childIndex. index of the children by name, built by the first lookup with operator[]. shared between copies, which rebuild it when they use it. 
+	std::shared_ptr<const ChildIndex> childIndex;
+	
+
+};
+
+//class: Document
+//info: Document is the "root" tag of a xml. 	
+//		while you can do nearly everything with Tag itself, document manages saving, loading and other stuff for you. 
+//parent: Tag
+class Document : public Tag
+{
+public:
+	//constructor: Document
+	//note: Creates an empty document
+	Document() 
+	{
+	
+	}
+	
+	//constructor: Document
+	//note: Creates an document form a file with name "filename". 
+	//		calling save without argbuments on this will save it to that exact file. 
+	//param: the file to load from and save to by name
+	Document(std::string filename)
+	{
+		std::string indata;
+		ReadFile(filename, indata);
+		Load(indata, 0);
+	}
+
+	//function: Save
+	//note: Saves a document to a file named by "filename"
+	//param: 	filename: file to save to
+	void Save(std::string filename)
+	{
+		std::fstream outfile(filename, std::ios::out);
+		Save(outfile);
+		outfile.close();
+	}
+
+	//function: Save
+	//note: Writes the document to a stream 
+	//param: 	out: stream to write to 
+	void Save(std::ostream& out)
+	{
+		Writer writer(out);
+		writer.WriteChildren(*this, 1);
+	}
+	
+	//function: Save
+	//note: Saves a Document. Uses method intended by constructor
+	void Save() 
+	{
+			Save(savefile);
+	}
+	
+	//functions: Serialize
+	//note: overloaded Tag::Serialize that serializes a document 
+	//param: 	depth: tabs to add in the beginning of each line
 	virtual std::string Serialize(int depth=0)
 	{
 		std::string result;
-		for (Tag t : GetChildren()) {
-			result += t.Serialize(depth+1);
-		}
+		Writer writer(result);
+		writer.WriteChildren(*this, depth+1);
 		return result;
 	}
 	
@@ -349,4 +1184,757 @@ protected:
 
 };
 
+void Writer::Write(const Tag& tag, int depth)
+{
+	_PutIndent(depth);
+	_Put('<');
+	_Put(tag.name);
+	_Put(' ');
+	for(auto& attribute : tag.attributes) {
+		_Put(attribute.first);
+		_Put("=\"", 2);
+		_PutText(attribute.second);
+		_Put("\" ", 2);
+	}
+	if(tag.isEmptyTag) {
+		_Put("/>\n", 3);
+		return;
+	}
+	_Put('>');
+	if(!tag.children.empty()) {
+		_Put('\n');
+		WriteChildren(tag, depth+1);
+		if(!tag.data.empty()) {
+			_PutIndent(depth);
+			_PutText(tag.data);
+			_Put('\n');
+			_PutIndent(depth);
+		}
+	}
+	else {
+		_PutText(tag.data);
+	}
+	_Put("</", 2);
+	_Put(tag.name);
+	_Put(">\n", 2);
+}
+
+void Writer::WriteChildren(const Tag& tag, int depth)
+{
+	for(auto& child : tag.children) {
+		Write(child, depth);
+	}
+}
+
+//struct: CompactHeader
+//info: First bytes of a CompactDocument arena. All offsets are in bytes, relative to the beginning of the arena.
+struct CompactHeader
+{
+	//var: magic. always "HXC1"
+	char magic[4];
+	//var: version. version of the layout
+	std::uint32_t version;
+	//var: nodeCount, attributeCount, stringBytes. sizes of the three tables
+	std::uint32_t nodeCount;
+	std::uint32_t attributeCount;
+	std::uint32_t stringBytes;
+	//var: nodeOffset, attributeOffset, stringOffset. where the tables begin
+	std::uint32_t nodeOffset;
+	std::uint32_t attributeOffset;
+	std::uint32_t stringOffset;
+};
+
+//struct: CompactNode
+//info: a tag inside a CompactDocument. Strings are offsets into the string pool, children and attributes are indices into their tables. 
+//		Nodes are stored breadth first, so the children of a node are always next to each other.
+struct CompactNode
+{
+	std::uint32_t name;
+	std::uint32_t nameLength;
+	std::uint32_t data;
+	std::uint32_t dataLength;
+	std::uint32_t firstChild;
+	std::uint32_t childCount;
+	std::uint32_t firstAttribute;
+	std::uint32_t attributeCount;
+	std::uint32_t flags;
+};
+
+//struct: CompactAttribute
+//info: a attribute of a CompactNode. Both strings are offsets into the string pool. 
+struct CompactAttribute
+{
+	std::uint32_t name;
+	std::uint32_t nameLength;
+	std::uint32_t value;
+	std::uint32_t valueLength;
+};
+
+class CompactDocument;
+class CompactTagRange;
+
+//class: CompactTag
+//info: Handle of a tag inside a CompactDocument. Cheap to copy, does not own anything. 
+//		Valid as long as the document it belongs to lives and is not reloaded.
+class CompactTag
+{
+public:
+	//constructor: CompactTag
+	//note: creates an invalid tag handle 
+	CompactTag() 
+	: doc(nullptr), index(0) 
+	{
+	
+	}
+
+	//constructor: CompactTag
+	//note: creates a handle for the node with the index i of document d
+	CompactTag(const CompactDocument* d, std::uint32_t i) 
+	: doc(d), index(i) 
+	{
+	
+	}
+
+	//function: IsValid
+	//note: returns false for handles that dont point to a tag (e.g. the result of a failed FindChild)
+	bool IsValid() const
+	{
+		return doc!=nullptr;
+	}
+
+	//function: GetIndex
+	//note: returns the index of the node in the document 
+	std::uint32_t GetIndex() const
+	{
+		return index;
+	}
+
+	inline StringRef GetName() const;
+	inline StringRef GetData() const;
+	inline bool GetEmptyTag() const;
+	inline StringRef GetAttribute(const char* attribute) const;
+	inline std::size_t GetAttributeCount() const;
+	inline StringRef GetAttributeName(std::size_t i) const;
+	inline StringRef GetAttributeValue(std::size_t i) const;
+	inline CompactTagRange GetChildren() const;
+	inline CompactTag FindChild(const char* childName) const;
+	inline Tag ToTag() const;
+
+private:
+	const CompactDocument* doc;
+	std::uint32_t index;
+};
+
+//class: CompactTagRange
+//info: Non-owning span over the children of a CompactTag. Use it in range-based for loops. 
+class CompactTagRange
+{
+public:
+	//class: Iterator
+	//info: forward iterator over the tags of the range 
+	class Iterator
+	{
+	public:
+		Iterator(const CompactDocument* d, std::uint32_t i) : doc(d), index(i) {}
+		CompactTag operator*() const { return CompactTag(doc, index); }
+		Iterator& operator++() { index++; return *this; }
+		bool operator==(const Iterator& other) const { return index==other.index; }
+		bool operator!=(const Iterator& other) const { return index!=other.index; }
+	private:
+		const CompactDocument* doc;
+		std::uint32_t index;
+	};
+
+	CompactTagRange(const CompactDocument* d, std::uint32_t first, std::uint32_t count) 
+	: doc(d), first(first), count(count) 
+	{
+	
+	}
+
+	Iterator begin() const { return Iterator(doc, first); }
+	Iterator end() const { return Iterator(doc, first+count); }
+
+	//function: Size
+	//note: returns the number of tags in the range 
+	std::size_t Size() const
+	{
+		return count;
+	}
+
+	//operator: []
+	//note: returns the i-th tag of the range. i has to be smaller then Size()
+	CompactTag operator[](std::size_t i) const
+	{
+		return CompactTag(doc, first+static_cast<std::uint32_t>(i));
+	}
+
+private:
+	const CompactDocument* doc;
+	std::uint32_t first;
+	std::uint32_t count;
+};
+
+//class: CompactDocument
+//info: A read-only document that keeps all of its tags, attributes and strings in one single memory block (the arena). 
+//		Tag names and attribute names are interned, children are exposed as non-owning spans. 
+//		Parsing follows the exact same rules as Document, use it whenever a document is only read.
+class CompactDocument
+{
+public:
+	//const: Version
+	//note: Version of the arena layout. Increase when CompactHeader, CompactNode or CompactAttribute change.
+	static const std::uint32_t Version = 1;
+
+	//constructor: CompactDocument
+	//note: Creates an empty document
+	CompactDocument()
+	: base(nullptr), baseSize(0)
+	{
+		Load(std::string());
+	}
+
+	//constructor: CompactDocument
+	//note: Creates an document form a file with name "filename". 
+	//param: the file to load from 
+	CompactDocument(std::string filename)
+	: base(nullptr), baseSize(0)
+	{
+		std::string indata;
+		ReadFile(filename, indata);
+		Load(indata);
+	}
+
+	//function: Load
+	//note: Parses toParse and replaces the content of this document with it. All handles of the old content become invalid.
+	//param: 	toParse: data to parse
+	void Load(const std::string& toParse)
+	{
+		Load(toParse.data(), toParse.size());
+	}
+
+	//function: Load
+	//note: Same as above, for size bytes at data. 
+	void Load(const char* data, std::size_t size)
+	{
+		std::vector<BuildNode> nodes;
+		std::vector<CompactAttribute> attributes;
+		BuildContext context(size);
+		nodes.push_back(BuildNode());
+		nodes[0].name = context.Intern(std::string());
+		Builder root(nodes, attributes, context, 0);
+		TreeParser::Parse(data, size, 0, StringRef(), root);
+		_Layout(nodes, attributes, context.strings);
+	}
+
+	CompactDocument(const CompactDocument& other)
+	: base(nullptr), baseSize(0)
+	{
+		*this = other;
+	}
+
+	CompactDocument(CompactDocument&& other)
+	: base(nullptr), baseSize(0)
+	{
+		*this = std::move(other);
+	}
+
+	//operator: =
+	//note: copies the arena of other. Documents on external buffers share the buffer. 
+	CompactDocument& operator=(const CompactDocument& other)
+	{
+		if(this!=&other) {
+			bool owned = other._IsOwned();
+			arena = other.arena;
+			owner = other.owner;
+			_Rebase(owned, other);
+		}
+		return *this;
+	}
+
+	CompactDocument& operator=(CompactDocument&& other)
+	{
+		if(this!=&other) {
+			bool owned = other._IsOwned();
+			const char* otherBase = other.base;
+			std::size_t otherSize = other.baseSize;
+			arena = std::move(other.arena);
+			owner = std::move(other.owner);
+			base = owned ? arena.data() : otherBase;
+			baseSize = owned ? arena.size() : otherSize;
+			other.Load(std::string());
+		}
+		return *this;
+	}
+
+	//function: GetRoot
+	//note: returns the root tag. It has no name, its children are the top-level tags of the document. 
+	CompactTag GetRoot() const
+	{
+		return CompactTag(this, 0);
+	}
+
+	//function: GetChildren
+	//note: returns the top-level tags of the document
+	CompactTagRange GetChildren() const
+	{
+		return GetRoot().GetChildren();
+	}
+
+	//function: GetData
+	//note: returns the data of the root tag (everything outside of the top-level tags)
+	StringRef GetData() const
+	{
+		return GetRoot().GetData();
+	}
+
+	//function: ToDocument
+	//note: creates a modifiable Document with the same content 
+	Document ToDocument() const
+	{
+		Document result;
+		Tag root = GetRoot().ToTag();
+		result.SetData(root.GetData());
+		for(auto& c : root.GetChildren()) {
+			result.AddChild(c);
+		}
+		return result;
+	}
+
+	//function: GetMemoryUsage
+	//note: returns the number of bytes this document holds on the heap
+	std::size_t GetMemoryUsage() const
+	{
+		return arena.capacity();
+	}
+
+	//function: GetBufferData
+	//note: returns the arena. It is position independent, writing it to disk and loading it with SetBuffer restores the document.
+	const char* GetBufferData() const
+	{
+		return base;
+	}
+
+	//function: GetBufferSize
+	//note: returns the size of the arena in bytes 
+	std::size_t GetBufferSize() const
+	{
+		return baseSize;
+	}
+
+	//function: SetBuffer
+	//note: Replaces the content of this document with a arena created by GetBuffer. Returns false (and leaves the document empty) if the buffer is damaged.
+	//param: 	buffer: the arena to use 
+	bool SetBuffer(std::vector<char> buffer)
+	{
+		arena.swap(buffer);
+		owner.reset();
+		base = arena.data();
+		baseSize = arena.size();
+		if(!_Validate()) {
+			Load(std::string());
+			return false;
+		}
+		return true;
+	}
+
+	//function: SetBuffer
+	//note: Uses the arena at data (e.g. a memory mapped file) without copying it. Returns false (and leaves the document empty) if the buffer is damaged.
+	//note: data has to stay valid as long as the document uses it: owner is kept alive by the document (and its copies) for that.
+	//param: 	data: the arena to use. Has to be aligned to 8 bytes, otherwise it is copied.
+	//		size: size of the arena
+	//		owner: keeps data alive
+	bool SetBuffer(const char* data, std::size_t size, std::shared_ptr<const void> bufferOwner)
+	{
+		if(reinterpret_cast<std::uintptr_t>(data)%8!=0) {
+			return SetBuffer(std::vector<char>(data, data+size));
+		}
+		std::vector<char>().swap(arena);
+		owner = bufferOwner;
+		base = data;
+		baseSize = size;
+		if(!_Validate()) {
+			Load(std::string());
+			return false;
+		}
+		return true;
+	}
+
+	//function: GetNode
+	//note: returns the raw node with index i
+	const CompactNode& GetNode(std::uint32_t i) const
+	{
+		return _Nodes()[i];
+	}
+
+	//function: GetAttributeEntry
+	//note: returns the raw attribute with index i
+	const CompactAttribute& GetAttributeEntry(std::uint32_t i) const
+	{
+		return _Attributes()[i];
+	}
+
+	//function: GetString
+	//note: returns a view on the string at offset o with length l in the string pool 
+	StringRef GetString(std::uint32_t o, std::uint32_t l) const
+	{
+		return StringRef(base+_Header().stringOffset+o, l);
+	}
+
+private:
+	//struct: BuildNode
+	//info: temporary representation of a node while parsing (depth-first order)
+	struct BuildNode
+	{
+		BuildNode() : name(0), nameLength(0), firstChild(0), lastChild(0), nextSibling(0), childCount(0), firstAttribute(0), attributeCount(0), emptyTag(false) {}
+		std::uint32_t name;
+		std::uint32_t nameLength;
+		std::string data;
+		std::uint32_t firstChild;
+		std::uint32_t lastChild;
+		std::uint32_t nextSibling;
+		std::uint32_t childCount;
+		std::uint32_t firstAttribute;
+		std::uint32_t attributeCount;
+		bool emptyTag;
+	};
+
+	//class: BuildContext
+	//info: the string pool of a document while parsing. Interns names. 
+	class BuildContext
+	{
+	public:
+		BuildContext(std::size_t sourceSize)
+		{
+			strings.reserve(sourceSize/2+16);
+		}
+
+		std::uint32_t Intern(const std::string& s)
+		{
+			auto it = interned.find(s);
+			if(it!=interned.end()) {
+				return it->second;
+			}
+			std::uint32_t offset = Append(s.data(), s.size());
+			interned[s] = offset;
+			return offset;
+		}
+
+		std::uint32_t Append(const char* s, std::size_t length)
+		{
+			std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+			strings.append(s, length);
+			strings.push_back('\0');
+			return offset;
+		}
+
+		std::string strings;
+	private:
+		std::unordered_map<std::string, std::uint32_t> interned;
+	};
+
+	//class: Builder
+	//info: Fills the BuildNodes for the TreeParser
+	class Builder
+	{
+	public:
+		Builder(std::vector<BuildNode>& n, std::vector<CompactAttribute>& a, BuildContext& c, std::uint32_t i) 
+		: nodes(n), attributes(a), context(c), index(i) 
+		{
+		
+		}
+
+		void AppendData(StringRef text) 
+		{ 
+			nodes[index].data.append(text.Data(), text.Size()); 
+		}
+
+		Builder AddChild(StringRef childName) 
+		{
+			std::uint32_t child = static_cast<std::uint32_t>(nodes.size());
+			nodes.push_back(BuildNode());
+			nodes[child].name = context.Intern(childName.Str());
+			nodes[child].nameLength = static_cast<std::uint32_t>(childName.Size());
+			BuildNode& n = nodes[index];
+			if(n.childCount==0) {
+				n.firstChild = child;
+			} else {
+				nodes[n.lastChild].nextSibling = child;
+			}
+			n.lastChild = child;
+			n.childCount++;
+			return Builder(nodes, attributes, context, child);
+		}
+
+		void SetAttribute(StringRef attribute, StringRef value) 
+		{
+			BuildNode& n = nodes[index];
+			std::uint32_t attributeName = context.Intern(attribute.Str());
+			CompactAttribute* target = nullptr;
+			if(n.attributeCount==0) {
+				n.firstAttribute = static_cast<std::uint32_t>(attributes.size());
+			}
+			//same as in Tag: a attribute set twice keeps the last value
+			for(std::uint32_t i = n.firstAttribute; i<n.firstAttribute+n.attributeCount; i++) {
+				if(attributes[i].name==attributeName) {
+					target = &attributes[i];
+				}
+			}
+			if(!target) {
+				attributes.push_back(CompactAttribute());
+				target = &attributes.back();
+				n.attributeCount++;
+			}
+			target->name = attributeName;
+			target->nameLength = static_cast<std::uint32_t>(attribute.Size());
+			target->value = context.Append(value.Data(), value.Size());
+			target->valueLength = static_cast<std::uint32_t>(value.Size());
+		}
+
+		void SetEmptyTag() 
+		{ 
+			nodes[index].emptyTag = true; 
+			nodes[index].data.clear();
+		}
+
+		void Finish() 
+		{ 
+			Reader::CleanData(nodes[index].data); 
+		}
+
+	private:
+		std::vector<BuildNode>& nodes;
+		std::vector<CompactAttribute>& attributes;
+		BuildContext& context;
+		std::uint32_t index;
+	};
+
+	//function: _Layout
+	//note: writes the parsed nodes breadth first into the arena
+	void _Layout(std::vector<BuildNode>& nodes, const std::vector<CompactAttribute>& attributes, std::string& strings)
+	{
+		//breadth first order: order[i] is the build-node that becomes node i
+		std::vector<std::uint32_t> order;
+		order.reserve(nodes.size());
+		order.push_back(0);
+		for(std::size_t i = 0; i<order.size(); i++) {
+			const BuildNode& n = nodes[order[i]];
+			std::uint32_t c = n.firstChild;
+			for(std::uint32_t k = 0; k<n.childCount; k++) {
+				order.push_back(c);
+				c = nodes[c].nextSibling;
+			}
+		}
+		//data goes to the string pool now, names and attributes are already there 
+		std::vector<std::uint32_t> dataOffsets(nodes.size());
+		std::vector<std::uint32_t> dataLengths(nodes.size());
+		for(std::size_t i = 0; i<nodes.size(); i++) {
+			dataOffsets[i] = static_cast<std::uint32_t>(strings.size());
+			dataLengths[i] = static_cast<std::uint32_t>(nodes[i].data.size());
+			strings.append(nodes[i].data);
+			strings.push_back('\0');
+			std::string().swap(nodes[i].data);
+		}
+
+		CompactHeader header;
+		std::memcpy(header.magic, "HXC1", 4);
+		header.version = Version;
+		header.nodeCount = static_cast<std::uint32_t>(nodes.size());
+		header.attributeCount = static_cast<std::uint32_t>(attributes.size());
+		header.stringBytes = static_cast<std::uint32_t>(strings.size());
+		header.nodeOffset = _Align(sizeof(CompactHeader));
+		header.attributeOffset = _Align(header.nodeOffset+header.nodeCount*sizeof(CompactNode));
+		header.stringOffset = _Align(header.attributeOffset+header.attributeCount*sizeof(CompactAttribute));
+		std::vector<char>(header.stringOffset+header.stringBytes).swap(arena);
+		std::memcpy(&arena[0], &header, sizeof(header));
+
+		CompactNode* out = _Nodes();
+		std::uint32_t nextChild = 1;
+		for(std::uint32_t i = 0; i<order.size(); i++) {
+			const BuildNode& n = nodes[order[i]];
+			CompactNode& c = out[i];
+			c.name = n.name;
+			c.nameLength = n.nameLength;
+			c.data = dataOffsets[order[i]];
+			c.dataLength = dataLengths[order[i]];
+			c.firstChild = nextChild;
+			c.childCount = n.childCount;
+			c.firstAttribute = n.firstAttribute;
+			c.attributeCount = n.attributeCount;
+			c.flags = n.emptyTag ? FLAG_EMPTYTAG : 0;
+			nextChild += n.childCount;
+		}
+		if(!attributes.empty()) {
+			std::memcpy(&arena[header.attributeOffset], &attributes[0], attributes.size()*sizeof(CompactAttribute));
+		}
+		std::memcpy(&arena[header.stringOffset], strings.data(), strings.size());
+		owner.reset();
+		base = arena.data();
+		baseSize = arena.size();
+	}
+
+	//function: _Validate
+	//note: checks if the arena is a valid, complete document 
+	bool _Validate() const
+	{
+		if(baseSize<sizeof(CompactHeader)) {
+			return false;
+		}
+		const CompactHeader& h = _Header();
+		if(std::memcmp(h.magic, "HXC1", 4)!=0 || h.version!=Version || h.nodeCount==0
+			|| h.nodeOffset+std::uint64_t(h.nodeCount)*sizeof(CompactNode)>h.attributeOffset
+			|| h.attributeOffset+std::uint64_t(h.attributeCount)*sizeof(CompactAttribute)>h.stringOffset
+			|| std::uint64_t(h.stringOffset)+h.stringBytes!=baseSize
+			|| h.nodeOffset%8!=0 || h.attributeOffset%8!=0 || h.nodeOffset<sizeof(CompactHeader)) {
+			return false;
+		}
+		for(std::uint32_t i = 0; i<h.nodeCount; i++) {
+			const CompactNode& n = _Nodes()[i];
+			if(std::uint64_t(n.name)+n.nameLength>=h.stringBytes || std::uint64_t(n.data)+n.dataLength>=h.stringBytes
+				|| std::uint64_t(n.firstChild)+n.childCount>h.nodeCount 
+				|| std::uint64_t(n.firstAttribute)+n.attributeCount>h.attributeCount) {
+				return false;
+			}
+		}
+		for(std::uint32_t i = 0; i<h.attributeCount; i++) {
+			const CompactAttribute& a = _Attributes()[i];
+			if(std::uint64_t(a.name)+a.nameLength>=h.stringBytes || std::uint64_t(a.value)+a.valueLength>=h.stringBytes) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static std::uint32_t _Align(std::size_t offset)
+	{
+		return static_cast<std::uint32_t>((offset+7)&~std::size_t(7));
+	}
+
+	const CompactHeader& _Header() const
+	{
+		return *reinterpret_cast<const CompactHeader*>(base);
+	}
+
+	const CompactNode* _Nodes() const
+	{
+		return reinterpret_cast<const CompactNode*>(base+_Header().nodeOffset);
+	}
+
+	CompactNode* _Nodes()
+	{
+		return reinterpret_cast<CompactNode*>(arena.data()+reinterpret_cast<const CompactHeader*>(arena.data())->nodeOffset);
+	}
+
+	const CompactAttribute* _Attributes() const
+	{
+		return reinterpret_cast<const CompactAttribute*>(base+_Header().attributeOffset);
+	}
+
+	static const std::uint32_t FLAG_EMPTYTAG = 1;
+
+	//function: _IsOwned
+	//note: returns true if the document uses its own arena (and not a external buffer)
+	bool _IsOwned() const
+	{
+		return base==arena.data();
+	}
+
+	//function: _Rebase
+	//note: points base to the own arena, or to the external buffer of other
+	void _Rebase(bool owned, const CompactDocument& other)
+	{
+		base = owned ? arena.data() : other.base;
+		baseSize = owned ? arena.size() : other.baseSize;
+	}
+
+	//var: arena. header, nodes, attributes and strings of this document, in this order. Empty if the document uses an external buffer.
+	std::vector<char> arena;
+	//var: base, baseSize. the arena in use: either arena or the external buffer 
+	const char* base;
+	std::size_t baseSize;
+	//var: owner. keeps the external buffer alive 
+	std::shared_ptr<const void> owner;
+
+	friend class CompactTag;
+};
+
+StringRef CompactTag::GetName() const
+{
+	const CompactNode& n = doc->GetNode(index);
+	return doc->GetString(n.name, n.nameLength);
+}
+
+StringRef CompactTag::GetData() const
+{
+	const CompactNode& n = doc->GetNode(index);
+	return doc->GetString(n.data, n.dataLength);
+}
+
+bool CompactTag::GetEmptyTag() const
+{
+	return (doc->GetNode(index).flags & CompactDocument::FLAG_EMPTYTAG)!=0;
+}
+
+StringRef CompactTag::GetAttribute(const char* attribute) const
+{
+	const CompactNode& n = doc->GetNode(index);
+	for(std::uint32_t i = n.firstAttribute; i<n.firstAttribute+n.attributeCount; i++) {
+		const CompactAttribute& a = doc->GetAttributeEntry(i);
+		if(doc->GetString(a.name, a.nameLength)==attribute) {
+			return doc->GetString(a.value, a.valueLength);
+		}
+	}
+	return StringRef();
+}
+
+std::size_t CompactTag::GetAttributeCount() const
+{
+	return doc->GetNode(index).attributeCount;
+}
+
+StringRef CompactTag::GetAttributeName(std::size_t i) const
+{
+	const CompactAttribute& a = doc->GetAttributeEntry(doc->GetNode(index).firstAttribute+static_cast<std::uint32_t>(i));
+	return doc->GetString(a.name, a.nameLength);
+}
+
+StringRef CompactTag::GetAttributeValue(std::size_t i) const
+{
+	const CompactAttribute& a = doc->GetAttributeEntry(doc->GetNode(index).firstAttribute+static_cast<std::uint32_t>(i));
+	return doc->GetString(a.value, a.valueLength);
+}
+
+CompactTagRange CompactTag::GetChildren() const
+{
+	const CompactNode& n = doc->GetNode(index);
+	return CompactTagRange(doc, n.firstChild, n.childCount);
+}
+
+CompactTag CompactTag::FindChild(const char* childName) const
+{
+	for(CompactTag c : GetChildren()) {
+		if(c.GetName()==childName) {
+			return c;
+		}
+	}
+	return CompactTag();
+}
+
+Tag CompactTag::ToTag() const
+{
+	Tag result(GetName().Str());
+	for(std::size_t i = 0; i<GetAttributeCount(); i++) {
+		result.SetAttribute(GetAttributeName(i).Str(), GetAttributeValue(i).Str());
+	}
+	if(GetEmptyTag()) {
+		result.SetEmptyTag(true);
+		return result;
+	}
+	result.SetData(GetData().Str());
+	for(CompactTag c : GetChildren()) {
+		Tag child = c.ToTag();
+		result.AddChild(child);
+	}
+	return result;
+}
+
 }; //end of namespace HoardXML
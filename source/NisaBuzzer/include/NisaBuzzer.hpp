@@ -254,6 +254,16 @@ namespace NisaBuzzer
 			FireEvent(Event::EventType::EVENT_FULL_RESET, 0);
 		}
 		
+		//function: SetReceiveHandler
+		//note: Sets a function that is called with every byte right when it is received, on the receive thread. For measuring latencies, it must be quick and thread safe.
+		//param:	f: the function, an empty one removes it
+		void SetReceiveHandler(std::function<void(unsigned char)> f)
+		{
+			recvMutex.lock();
+			receiveHandler = f;
+			recvMutex.unlock();
+		}
+		
 		//function: AddEventHandler
 		//note: 	adds a BuzzerEventHandler 
 		//param:	h: the handler to add
@@ -337,6 +347,9 @@ namespace NisaBuzzer
 				port.read_some(asio::buffer(&c,1));
 				recvMutex.lock();
 				toRead.push(c);
+				if(receiveHandler) {
+					receiveHandler(c);
+				}
 				recvMutex.unlock();
 			}
 		}
@@ -440,6 +453,8 @@ namespace NisaBuzzer
 		std::thread					recvThread;
 		//var: recvMutex. the Mutex loced so toRead dosn't explode
 		std::recursive_mutex		recvMutex;
+		//var: receiveHandler. called for every received byte, see SetReceiveHandler
+		std::function<void(unsigned char)>	receiveHandler;
 		//var: eventThread. the thread that handlers the events
 		std::thread					eventThread;
 		//var: evntMutex. the mutex that maks shure eventHandlers dosnt explode
@@ -11,6 +11,7 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <memory>
 
 //Not-So-Standart lib includes
 //Sdl-foo
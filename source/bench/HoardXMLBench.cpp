@@ -0,0 +1,354 @@
+//File: HoardXMLBench.cpp
+//Info: Benchmarks for HoardXML. Generates big map and tileset documents (like the ones in the demogame, just a lot bigger) and measures how long HoardXML needs for them.
+//Info: Build and run with "make bench". Takes the size of the generated documents in MB as optional argument.
+
+#include <HoardXML.h>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <regex>
+#include <sstream>
+
+//gcc does not like the free in operator delete below, as it can not know it is paired with the malloc in operator new 
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+//var: allocatedBytes, allocations. counted by the global operator new below, so the benchmarks can report memory usage
+static std::size_t allocatedBytes = 0;
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+	allocatedBytes += size;
+	allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+//function: GenerateTileset
+//note: Generates a tileset document with at least size bytes, like tilesets/BaseTileset.xml
+std::string GenerateTileset(std::size_t size)
+{
+	std::string result = "<tileset name=\"BenchTileset\" >\n\t<texture name=\"BaseTileset\" />\n\t<default id=\"0\" />\n\t<tiles >\n";
+	for (int id = 0; result.size() < size; id++) {
+		result += "\t\t<tile h=\"0.050000\" id=\"" + std::to_string(id) + "\" w=\"0.050000\" x=\"" + std::to_string((id % 20)*0.05f) + "\" y=\"" + std::to_string((id / 20)*0.05f) + "\" />\n";
+	}
+	result += "\t</tiles>\n</tileset>\n";
+	return result;
+}
+
+//function: GenerateMap
+//note: Generates a map document with at least size bytes, like map/testmap.xml
+std::string GenerateMap(std::size_t size)
+{
+	std::string result = "<map name=\"benchmap\">\n\t<info>\n\t\t<mapsize width=\"15\" height=\"15\" />\n\t</info>\n\t<mapdata>\n";
+	for (int layer = 0; result.size() < size; layer++) {
+		result += "\t\t<layer id=\"" + std::to_string(layer) + "\" tileset=\"BaseTileset\" nodefault=\"false\" default=\"63\">\n";
+		for (int i = 0; i < 256*256 && result.size() < size; i++) {
+			result += "\t\t\t<tile x=\"" + std::to_string(i % 256) + "\" y=\"" + std::to_string(i / 256) + "\" id=\"" + std::to_string(i % 400) + "\" />\n";
+		}
+		result += "\t\t</layer>\n";
+	}
+	result += "\t</mapdata>\n\t<script>\n\t\tprint(\"benchmark\");\n\t</script>\n</map>\n";
+	return result;
+}
+
+//function: Measure
+//note: Runs f runs times and returns the average time in milliseconds
+template<class F>
+double Measure(int runs, F f)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++) {
+		f();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - begin).count() / runs;
+}
+
+//function: Report
+//note: Prints a line of benchmark results
+void Report(std::string name, std::size_t bytes, double ms)
+{
+	std::cout << name << ": " << bytes / 1024 << " KB in " << ms << " ms (" << (bytes / (1024.0*1024.0)) / (ms / 1000.0) << " MB/s)" << std::endl;
+}
+
+void BenchParse(std::string name, const std::string& document)
+{
+	std::size_t tags = 0;
+	double ms = Measure(5, [&]() {
+		HoardXML::Tag root;
+		root.Load(document, 0);
+		tags = root.GetChildren().size();
+	});
+	Report(std::string("parse ") + name, document.size(), ms);
+	if (tags == 0) {
+		std::cout << "WARNING: " << name << " parsed to an empty document!" << std::endl;
+	}
+}
+
+//function: Allocated
+//note: returns the bytes and allocations f has requested from operator new. Frees nothing itself, so keep what f allocates alive inside of f.
+template<class F>
+std::pair<std::size_t, std::size_t> Allocated(F f)
+{
+	std::size_t bytes = allocatedBytes;
+	std::size_t count = allocations;
+	f();
+	return std::make_pair(allocatedBytes - bytes, allocations - count);
+}
+
+//function: CountAttributes
+//note: walks a tree and counts all attributes, so the traversal cant be optimized away
+std::size_t CountAttributes(HoardXML::Tag& tag)
+{
+	std::size_t result = tag.GetAttributes().size();
+	for (auto& c : tag.GetChildren()) {
+		result += CountAttributes(c);
+	}
+	return result;
+}
+
+std::size_t CountAttributes(HoardXML::CompactTag tag)
+{
+	std::size_t result = tag.GetAttributeCount();
+	for (auto c : tag.GetChildren()) {
+		result += CountAttributes(c);
+	}
+	return result;
+}
+
+void BenchCompact(std::string name, const std::string& document)
+{
+	std::size_t tags = 0;
+	double ms = Measure(5, [&]() {
+		HoardXML::CompactDocument doc;
+		doc.Load(document);
+		tags = doc.GetChildren().Size();
+	});
+	Report(std::string("compact parse ") + name, document.size(), ms);
+	if (tags == 0) {
+		std::cout << "WARNING: " << name << " parsed to an empty compact document!" << std::endl;
+	}
+
+	std::size_t tagMemory = 0;
+	std::size_t compactMemory = 0;
+	std::size_t tagAttributes = 0;
+	std::size_t compactAttributes = 0;
+	double tagWalk = 0;
+	double compactWalk = 0;
+	auto tagAllocated = Allocated([&]() {
+		HoardXML::Tag root;
+		root.Load(document, 0);
+		tagWalk = Measure(5, [&]() { tagAttributes = CountAttributes(root); });
+	});
+	tagMemory = tagAllocated.first;
+	auto compactAllocated = Allocated([&]() {
+		HoardXML::CompactDocument doc;
+		doc.Load(document);
+		compactMemory = doc.GetMemoryUsage();
+		compactWalk = Measure(5, [&]() { compactAttributes = CountAttributes(doc.GetRoot()); });
+	});
+	std::cout << "memory " << name << ": Tag " << tagMemory / 1024 << " KB in " << tagAllocated.second << " allocations, "
+		<< "CompactDocument " << compactMemory / 1024 << " KB kept (" << compactAllocated.first / 1024 << " KB in " << compactAllocated.second << " allocations while parsing)" << std::endl;
+	std::cout << "walk " << name << ": Tag " << tagWalk << " ms, CompactDocument " << compactWalk << " ms" << std::endl;
+	if (tagAttributes != compactAttributes) {
+		std::cout << "WARNING: " << name << " has " << tagAttributes << " attributes as Tag, but " << compactAttributes << " as CompactDocument!" << std::endl;
+	}
+}
+
+void BenchReader(std::string name, const std::string& document)
+{
+	std::size_t tags = 0;
+	std::size_t ids = 0;
+	std::pair<std::size_t, std::size_t> allocated;
+	double ms = Measure(5, [&]() {
+		allocated = Allocated([&]() {
+			HoardXML::Reader reader(document.data(), document.size());
+			tags = 0;
+			ids = 0;
+			while (reader.Next() != HoardXML::Reader::EVENT_END_DOCUMENT) {
+				if (reader.GetEvent() == HoardXML::Reader::EVENT_START_TAG) {
+					tags++;
+					ids += reader.GetAttribute("id").ToInt();
+				}
+			}
+		});
+	});
+	Report(std::string("read ") + name, document.size(), ms);
+	std::cout << "memory " << name << ": Reader " << allocated.first / 1024 << " KB in " << allocated.second << " allocations for " << tags << " tags" << std::endl;
+	if (tags == 0 || ids == 0) {
+		std::cout << "WARNING: " << name << " read no tags!" << std::endl;
+	}
+}
+
+//function: GenerateWide
+//note: Generates a wide document: one tag with count children of 100 different names, each with a few children of their own
+std::string GenerateWide(int count)
+{
+	std::string result = "<root>\n";
+	for (int i = 0; i < count; i++) {
+		std::string name = "entry" + std::to_string(i % 100);
+		result += "\t<" + name + " id=\"" + std::to_string(i) + "\">\n\t\t<info a=\"1\" />\n\t\t<value>" + std::to_string(i) + "</value>\n\t</" + name + ">\n";
+	}
+	result += "</root>\n";
+	return result;
+}
+
+//function: RegexLookup
+//note: The old Tag::operator[]: a regex search on every call and a linear scan of the children. Kept here to compare against.
+std::vector<HoardXML::Tag*> RegexLookup(HoardXML::Tag& tag, std::string tagName)
+{
+	std::vector<HoardXML::Tag*> resultlist;
+	static std::regex nameRE("[.]?([\\w\\d]+)([\\w\\d.]*)");
+	std::smatch m;
+	if (std::regex_search(tagName, m, nameRE)) {
+		if (m[1] != "") {
+			for (auto t = tag.GetChildren().begin(); t != tag.GetChildren().end(); t++) {
+				if (m[1] == t->GetName()) {
+					if (m[2] == "") {
+						resultlist.push_back(&(*t));
+					}
+					else {
+						std::vector<HoardXML::Tag*> l = RegexLookup(*t, m[2]);
+						resultlist.insert(resultlist.end(), l.begin(), l.end());
+						break;
+					}
+				}
+			}
+		}
+	}
+	return resultlist;
+}
+
+void BenchLookup(int width)
+{
+	HoardXML::Document doc;
+	doc.Load(GenerateWide(width), 0);
+	const int lookups = 2000;
+	std::vector<std::string> paths;
+	std::vector<HoardXML::Path> compiled;
+	for (int i = 0; i < lookups; i++) {
+		paths.push_back("root.entry" + std::to_string(i % 100));
+		compiled.push_back(HoardXML::Path(paths.back()));
+	}
+	std::size_t found[3] = { 0, 0, 0 };
+	double regexMs = Measure(3, [&]() {
+		for (auto& p : paths) {
+			found[0] += RegexLookup(doc, p).size();
+		}
+	});
+	double stringMs = Measure(3, [&]() {
+		for (auto& p : paths) {
+			found[1] += doc[p].size();
+		}
+	});
+	double pathMs = Measure(3, [&]() {
+		for (auto& p : compiled) {
+			found[2] += doc[p].size();
+		}
+	});
+	std::cout << "lookup " << width << " children: regex " << regexMs * 1000.0 / lookups << " us, string " << stringMs * 1000.0 / lookups
+		<< " us, Path " << pathMs * 1000.0 / lookups << " us per lookup" << std::endl;
+	if (found[0] != found[1] || found[1] != found[2]) {
+		std::cout << "WARNING: lookups found different tags! " << found[0] << " " << found[1] << " " << found[2] << std::endl;
+	}
+}
+
+//function: ConcatSerialize
+//note: The old Tag::Serialize: recursive string concatenation, every child copied. Kept here to compare against.
+std::string ConcatSerialize(HoardXML::Tag& tag, int depth)
+{
+	std::string tabs;
+	for (int i = 0; i < depth; i++) {
+		tabs += '\t';
+	}
+	std::string result;
+	result += tabs + std::string("<") + tag.GetName() + std::string(" ");
+	for (auto elem = tag.GetAttributes().begin(); elem != tag.GetAttributes().end(); elem++) {
+		result += elem->first + std::string("=\"") + elem->second + std::string("\" ");
+	}
+	if (tag.GetEmptyTag()) {
+		result += std::string("/>\n");
+		return result;
+	}
+	result += std::string(">");
+	if (tag.GetChildren().size() != 0) {
+		result += "\n";
+		for (HoardXML::Tag t : tag.GetChildren()) {
+			result += ConcatSerialize(t, depth + 1);
+		}
+		if (tag.GetData() != "") {
+			result += tabs + tag.GetData() + std::string("\n") + tabs;
+		}
+	}
+	else {
+		result += tag.GetData();
+	}
+	result += std::string("</") + tag.GetName() + std::string(">\n");
+	return result;
+}
+
+void BenchWrite(std::string name, const std::string& document)
+{
+	HoardXML::Document doc;
+	doc.Load(document, 0);
+	HoardXML::Tag& root = doc.GetChildren()[0];
+	std::string concat, serialized, streamed;
+	std::pair<std::size_t, std::size_t> concatAllocated, writerAllocated;
+	double concatMs = Measure(3, [&]() {
+		concatAllocated = Allocated([&]() { concat = ConcatSerialize(root, 1); });
+	});
+	double writerMs = Measure(3, [&]() {
+		writerAllocated = Allocated([&]() { serialized = root.Serialize(1); });
+	});
+	double streamMs = Measure(3, [&]() {
+		std::ostringstream out;
+		doc.Save(out);
+		streamed = out.str();
+	});
+	Report(std::string("write concat ") + name, concat.size(), concatMs);
+	Report(std::string("write Serialize ") + name, serialized.size(), writerMs);
+	Report(std::string("write stream ") + name, streamed.size(), streamMs);
+	std::cout << "memory " << name << ": concat " << concatAllocated.first / 1024 << " KB in " << concatAllocated.second << " allocations, Writer "
+		<< writerAllocated.first / 1024 << " KB in " << writerAllocated.second << " allocations" << std::endl;
+	if (concat != serialized || concat != streamed) {
+		std::cout << "WARNING: " << name << " was written differently!" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t megabytes = 4;
+	if (argc > 1) {
+		megabytes = atoi(argv[1]);
+	}
+	std::string tileset = GenerateTileset(megabytes * 1024 * 1024);
+	std::string map = GenerateMap(megabytes * 1024 * 1024);
+
+	BenchParse("tileset", tileset);
+	BenchParse("map", map);
+	BenchCompact("tileset", tileset);
+	BenchCompact("map", map);
+	BenchReader("tileset", tileset);
+	BenchReader("map", map);
+	BenchWrite("tileset", tileset);
+	BenchWrite("map", map);
+	BenchLookup(100);
+	BenchLookup(10000);
+	return 0;
+}
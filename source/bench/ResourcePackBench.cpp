@@ -0,0 +1,147 @@
+//File: ResourcePackBench.cpp
+//Info: Benchmarks the startup of the ResourceManager with the .db files and with a ResourcePack: filling the dbs and reading every file in them.
+//Info: The pack is written to a temporary file, the game folder is not changed.
+//Info: Build and run with "make bench". Takes the path of the game as optional argument (default engine/demogame/).
+
+#include <HoardXML.h>
+#include "../Classes/MappedFile.h"
+#include "../Classes/ResourcePack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <regex>
+#include <unistd.h>
+
+using Dragon2D::MappedFile;
+using Dragon2D::ResourcePack;
+
+//const: Folders
+//note: the folders with a .db file, as the ResourceManager loads them
+const char* Folders[] = { "audio", "video", "texture", "script", "font", "shader", "map", "text" };
+
+//function: Measure
+//note: Runs f runs times and returns the average time in milliseconds
+template<class F>
+double Measure(int runs, F f)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++) {
+		f();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - begin).count() / runs;
+}
+
+//function: LoadDbIntoMap
+//note: the db parsing of ResourceManager::_LoadDbIntoMap
+std::map<std::string, std::string> LoadDbIntoMap(std::string FileString, std::string resFolder)
+{
+	std::map<std::string, std::string> tmpMap;
+	std::regex e("\\s*([\\w\\d/\\\\_]*.[\\w\\d]*)\\s*");
+	std::smatch m;
+	std::string s(FileString);
+	while (std::regex_search(s, m, e)) {
+		std::regex e2("([\\w\\d]*)\\.");
+		std::smatch m2;
+		std::string s2(m[1]);
+		std::regex_search(s2, m2, e2);
+		tmpMap[m2[1]] = resFolder + m[1].str();
+		s = m.suffix().str();
+	}
+	return tmpMap;
+}
+
+//function: StartupDb
+//note: fills the dbs from the .db files and reads every file. Returns the number of bytes read.
+std::size_t StartupDb(const std::string& gamepath)
+{
+	std::size_t bytes = 0;
+	for (const char* folder : Folders) {
+		std::string dbString;
+		HoardXML::ReadFile(gamepath + folder + "/" + folder + ".db", dbString);
+		for (auto& entry : LoadDbIntoMap(dbString, std::string(folder) + "/")) {
+			std::shared_ptr<const MappedFile> file = MappedFile::Share(gamepath + entry.second);
+			if (file) {
+				bytes += (std::size_t)file->GetSize();
+			}
+		}
+	}
+	return bytes;
+}
+
+//function: StartupPack
+//note: fills the dbs from the pack index and reads every file. Returns the number of bytes read.
+std::size_t StartupPack(const std::string& packName)
+{
+	ResourcePack pack;
+	pack.Open(packName);
+	std::map<std::string, std::string> db;
+	for (std::size_t i = 0; i < pack.GetFileCount(); i++) {
+		std::string path = pack.GetPath(i);
+		db[path.substr(path.find('/') + 1, path.find('.') - path.find('/') - 1)] = path;
+	}
+	std::size_t bytes = 0;
+	for (auto& entry : db) {
+		const char* data;
+		std::size_t size;
+		std::shared_ptr<const void> owner;
+		if (pack.Read(entry.second, data, size, owner)) {
+			bytes += size;
+		}
+	}
+	return bytes;
+}
+
+int main(int argc, char** argv)
+{
+	std::string gamepath = "engine/demogame/";
+	if (argc > 1) {
+		gamepath = std::string(argv[1]) + "/";
+	}
+
+	//the pack gets the files of the dbs
+	std::vector<ResourcePack::File> files;
+	for (const char* folder : Folders) {
+		std::string dbString;
+		HoardXML::ReadFile(gamepath + folder + "/" + folder + ".db", dbString);
+		for (auto& entry : LoadDbIntoMap(dbString, std::string(folder) + "/")) {
+			//MappedFile skips the folders in the dbs (script/ui)
+			std::shared_ptr<const MappedFile> mapped = MappedFile::Share(gamepath + entry.second);
+			if (mapped) {
+				ResourcePack::File file;
+				file.path = entry.second;
+				file.data.assign(mapped->GetData(), (std::size_t)mapped->GetSize());
+				files.push_back(file);
+			}
+		}
+	}
+	if (files.empty()) {
+		std::cout << "WARNING: no .db files found in " << gamepath << std::endl;
+		return 1;
+	}
+	char packTemplate[] = "/tmp/ResourcePackBenchXXXXXX";
+	int fd = mkstemp(packTemplate);
+	if (fd < 0) {
+		std::cout << "WARNING: cannot create temporary file" << std::endl;
+		return 1;
+	}
+	close(fd);
+	std::string packName = packTemplate;
+	std::size_t count = files.size();
+	ResourcePack::Write(packName, files, true);
+	std::uint64_t packSize;
+	std::int64_t mtime;
+	MappedFile::Stat(packName, packSize, mtime);
+
+	std::size_t dbBytes = 0, packBytes = 0;
+	double dbMs = Measure(20, [&]() { dbBytes = StartupDb(gamepath); });
+	double packMs = Measure(20, [&]() { packBytes = StartupPack(packName); });
+	std::cout << "startup " << count << " files, " << dbBytes / 1024 << " KB (pack " << packSize / 1024 << " KB): .db files " << dbMs << " ms, pack " << packMs
+		<< " ms (" << dbMs / packMs << "x)" << std::endl;
+	if (dbBytes != packBytes) {
+		std::cout << "WARNING: the pack gave " << packBytes << " bytes instead of " << dbBytes << std::endl;
+	}
+	std::remove(packName.c_str());
+	return 0;
+}
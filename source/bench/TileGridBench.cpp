@@ -0,0 +1,145 @@
+//File: TileGridBench.cpp
+//Info: Benchmarks the render preparation of map layers against the map size: the tiles are stored in nested std::maps (as MapLayer did) and in a TileGrid.
+//Info: "view" collects the tiles of one screen (like the old Map::Render did every frame, the nested maps including the copy of the layer it made), "build" collects the tiles of every chunk (like Map::Load does for the chunk meshes).
+//Info: Build and run with "make bench".
+
+#include "../Classes/TileGrid.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+
+using Dragon2D::TileGrid;
+
+//function: Measure
+//note: Runs f runs times and returns the average time in milliseconds
+template<class F>
+double Measure(int runs, F f)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++) {
+		f();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - begin).count() / runs;
+}
+
+//class: Quad
+//note: what the render preparation makes of a tile
+struct Quad
+{
+	int x, y, id;
+};
+
+typedef std::map<int, std::map<int, int>> NestedTiles;
+
+//const: ViewWidth, ViewHeight, DefaultId
+//note: the tiles on a screen, the default tile of the layers
+const int ViewWidth = 40;
+const int ViewHeight = 24;
+const int DefaultId = 0;
+
+//function: NestedGet
+//note: the tile lookup of the old Map::Render
+int NestedGet(const NestedTiles& tiles, int x, int y)
+{
+	auto xiter = tiles.find(x);
+	if (xiter != tiles.end()) {
+		auto yiter = xiter->second.find(y);
+		if (yiter != xiter->second.end()) {
+			return yiter->second;
+		}
+	}
+	return DefaultId;
+}
+
+//function: Checksum
+//note: sums up the quads, so both ways can be compared
+long long Checksum(const std::vector<Quad>& quads)
+{
+	long long sum = 0;
+	for (auto& q : quads) {
+		sum += (long long)q.id * 31 + q.x * 7 + q.y;
+	}
+	return sum;
+}
+
+int main(int argc, char** argv)
+{
+	const int sizes[] = { 64, 256, 1024 };
+	std::vector<Quad> quads;
+	for (int size : sizes) {
+		//every second tile set, the rest is the default
+		std::mt19937 random(size);
+		NestedTiles nested;
+		TileGrid grid;
+		grid.SetDefault(DefaultId);
+		for (int x = 0; x < size; x++) {
+			for (int y = 0; y < size; y++) {
+				if (random() % 2) {
+					int id = (int)(random() % 256);
+					nested[x][y] = id;
+					grid.Set(x, y, id);
+				}
+			}
+		}
+		//the view is in the middle of the map
+		int vx = (size - ViewWidth) / 2;
+		int vy = (size - ViewHeight) / 2;
+		const int runs = 200;
+
+		long long nestedView = 0, gridView = 0;
+		double nestedViewMs = Measure(runs, [&]() {
+			quads.clear();
+			NestedTiles layer = nested;
+			for (int y = vy; y < vy + ViewHeight; y++) {
+				for (int x = vx; x < vx + ViewWidth; x++) {
+					quads.push_back({ x, y, NestedGet(layer, x, y) });
+				}
+			}
+			nestedView = Checksum(quads);
+		});
+		double gridViewMs = Measure(runs, [&]() {
+			quads.clear();
+			grid.ForEach(vx, vy, vx + ViewWidth, vy + ViewHeight, [&](int x, int y, int id) {
+				quads.push_back({ x, y, id });
+			});
+			gridView = Checksum(quads);
+		});
+
+		const int chunkSize = TileGrid::ChunkSize;
+		const int buildRuns = size > 256 ? 3 : 20;
+		long long nestedBuild = 0, gridBuild = 0;
+		double nestedBuildMs = Measure(buildRuns, [&]() {
+			nestedBuild = 0;
+			for (auto& chunk : grid.GetChunks()) {
+				quads.clear();
+				for (int y = chunk.second*chunkSize; y < (chunk.second + 1)*chunkSize; y++) {
+					for (int x = chunk.first*chunkSize; x < (chunk.first + 1)*chunkSize; x++) {
+						quads.push_back({ x, y, NestedGet(nested, x, y) });
+					}
+				}
+				nestedBuild += Checksum(quads);
+			}
+		});
+		double gridBuildMs = Measure(buildRuns, [&]() {
+			gridBuild = 0;
+			for (auto& chunk : grid.GetChunks()) {
+				quads.clear();
+				grid.ForEach(chunk.first*chunkSize, chunk.second*chunkSize, (chunk.first + 1)*chunkSize, (chunk.second + 1)*chunkSize, [&](int x, int y, int id) {
+					quads.push_back({ x, y, id });
+				});
+				gridBuild += Checksum(quads);
+			}
+		});
+
+		std::cout << size << "x" << size << " tiles: view " << ViewWidth << "x" << ViewHeight << " nested maps " << nestedViewMs << " ms, grid " << gridViewMs << " ms ("
+			<< nestedViewMs / gridViewMs << "x); build " << grid.GetChunks().size() << " chunks nested maps " << nestedBuildMs << " ms, grid " << gridBuildMs << " ms ("
+			<< nestedBuildMs / gridBuildMs << "x)" << std::endl;
+		if (nestedView != gridView || nestedBuild != gridBuild) {
+			std::cout << "WARNING: the grid has other tiles than the nested maps" << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+//File: XMLCacheBench.cpp
+//Info: Benchmarks the startup of the demogame with and without the XMLCache. Copies all xml files of the demogame (and a big generated map) to a temporary folder and loads them
+//Info: without cache (parsing every file), cold (parsing every file and writing the caches) and warm (mapping the caches).
+//Info: Build and run with "make bench". Takes the path of the game as optional argument (default engine/demogame/).
+
+#include <HoardXML.h>
+#include "../Classes/MappedFile.h"
+#include "../Classes/XMLCache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+using Dragon2D::MappedFile;
+using Dragon2D::XMLCache;
+
+//function: Measure
+//note: Runs f runs times and returns the average time in milliseconds
+template<class F>
+double Measure(int runs, F f)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++) {
+		f();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - begin).count() / runs;
+}
+
+//function: FindXML
+//note: Adds all xml files in the subfolders of gamepath (like the ResourceManager sees them) to files
+void FindXML(const std::string& gamepath, std::vector<std::string>& files)
+{
+	DIR* game = opendir(gamepath.c_str());
+	if (!game) {
+		return;
+	}
+	while (dirent* folder = readdir(game)) {
+		std::string folderName = folder->d_name;
+		if (folderName[0] == '.') {
+			continue;
+		}
+		DIR* sub = opendir((gamepath + folderName).c_str());
+		if (!sub) {
+			continue;
+		}
+		while (dirent* file = readdir(sub)) {
+			std::string fileName = file->d_name;
+			if (fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".xml") == 0) {
+				files.push_back(gamepath + folderName + "/" + fileName);
+			}
+		}
+		closedir(sub);
+	}
+	closedir(game);
+}
+
+//function: WriteFile
+//note: writes data to filename
+bool WriteFile(const std::string& filename, const std::string& data)
+{
+	std::ofstream out(filename, std::ios::out | std::ios::binary);
+	out.write(data.data(), data.size());
+	return out.good();
+}
+
+//function: GenerateMap
+//note: Generates a map document with at least size bytes, like map/testmap.xml
+std::string GenerateMap(std::size_t size)
+{
+	std::string result = "<map name=\"benchmap\">\n\t<info>\n\t\t<mapsize width=\"256\" height=\"256\" />\n\t</info>\n\t<mapdata>\n";
+	for (int layer = 0; result.size() < size; layer++) {
+		result += "\t\t<layer id=\"" + std::to_string(layer) + "\" tileset=\"BaseTileset\" nodefault=\"false\" default=\"63\">\n";
+		for (int i = 0; i < 256 * 256 && result.size() < size; i++) {
+			result += "\t\t\t<tile x=\"" + std::to_string(i % 256) + "\" y=\"" + std::to_string(i / 256) + "\" id=\"" + std::to_string(i % 400) + "\" />\n";
+		}
+		result += "\t\t</layer>\n";
+	}
+	result += "\t</mapdata>\n</map>\n";
+	return result;
+}
+
+//function: RemoveCaches
+//note: deletes the cache files of files
+void RemoveCaches(const std::vector<std::string>& files)
+{
+	for (auto& f : files) {
+		std::remove((f + XMLCache::Extension).c_str());
+	}
+}
+
+//function: BenchStartup
+//note: Loads files without cache, cold and warm, and checks that all three give the same documents
+void BenchStartup(const std::string& name, const std::vector<std::string>& files, int runs)
+{
+	std::uint64_t bytes = 0;
+	for (auto& f : files) {
+		std::uint64_t size;
+		std::int64_t mtime;
+		MappedFile::Stat(f, size, mtime);
+		bytes += size;
+	}
+	std::vector<HoardXML::CompactDocument> docs(files.size());
+	double parseMs = Measure(runs, [&]() {
+		for (std::size_t i = 0; i < files.size(); i++) {
+			docs[i] = HoardXML::CompactDocument(files[i]);
+		}
+	});
+	std::vector<std::string> expected;
+	for (auto& d : docs) {
+		expected.push_back(d.ToDocument().Serialize());
+	}
+
+	double coldMs = Measure(runs, [&]() {
+		RemoveCaches(files);
+		for (std::size_t i = 0; i < files.size(); i++) {
+			XMLCache::Load(files[i], docs[i]);
+		}
+	});
+	bool same = true;
+	for (std::size_t i = 0; i < files.size(); i++) {
+		same = same && docs[i].ToDocument().Serialize() == expected[i];
+	}
+
+	double warmMs = Measure(runs, [&]() {
+		for (std::size_t i = 0; i < files.size(); i++) {
+			XMLCache::Load(files[i], docs[i]);
+		}
+	});
+	for (std::size_t i = 0; i < files.size(); i++) {
+		same = same && docs[i].ToDocument().Serialize() == expected[i];
+	}
+
+	std::cout << "startup " << name << ": " << files.size() << " files, " << bytes / 1024 << " KB: no cache " << parseMs << " ms, cold " << coldMs
+		<< " ms, warm " << warmMs << " ms (" << parseMs / warmMs << "x)" << std::endl;
+	if (!same) {
+		std::cout << "WARNING: " << name << " loaded different documents from the cache!" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string gamepath = "engine/demogame/";
+	if (argc > 1) {
+		gamepath = std::string(argv[1]) + "/";
+	}
+	std::vector<std::string> sources;
+	FindXML(gamepath, sources);
+	if (sources.empty()) {
+		std::cout << "WARNING: no xml files found in " << gamepath << std::endl;
+		return 1;
+	}
+
+	//work on copies, so the game folder does not get cache files
+	char tempTemplate[] = "/tmp/XMLCacheBenchXXXXXX";
+	if (!mkdtemp(tempTemplate)) {
+		std::cout << "WARNING: cannot create temporary folder" << std::endl;
+		return 1;
+	}
+	std::string temp = tempTemplate;
+	std::vector<std::string> files;
+	for (std::size_t i = 0; i < sources.size(); i++) {
+		std::string data;
+		HoardXML::ReadFile(sources[i], data);
+		files.push_back(temp + "/" + std::to_string(i) + ".xml");
+		WriteFile(files.back(), data);
+	}
+	std::vector<std::string> withMap = files;
+	withMap.push_back(temp + "/bigmap.xml");
+	WriteFile(withMap.back(), GenerateMap(4 * 1024 * 1024));
+
+	BenchStartup("demogame", files, 50);
+	BenchStartup("demogame + 4 MB map", withMap, 5);
+
+	RemoveCaches(withMap);
+	for (auto& f : withMap) {
+		std::remove(f.c_str());
+	}
+	rmdir(temp.c_str());
+	return 0;
+}
@@ -0,0 +1,112 @@
+//File: PackTool.cpp
+//Info: Builds the ResourcePack of a game: puts all files of the resource folders (audio/, texture/, ...) into <game>/game.pak.
+//Info: Folders the game writes to (cfg/, save/, tilesets/) stay outside of the pack.
+//Info: XML files are parsed here already, their HoardXML::CompactDocument is stored next to them, so the engine does not have to parse them at all.
+//Info: Cooked textures (see TextureTool.cpp) are packed if they match their source.
+//Info: Build and run with "make gamepack". Usage: PackTool <gamefolder> [--nocompress]
+
+#include <HoardXML.h>
+#include "../Classes/ResourcePack.h"
+#include "../Classes/XMLCache.h"
+#include "../Classes/TextureCache.h"
+#include <dirent.h>
+#include <sys/stat.h>
+
+using Dragon2D::ResourcePack;
+using Dragon2D::XMLCache;
+using Dragon2D::TextureCache;
+
+//const: PackedFolders
+//note: the read only folders of a game: the ones of the ResourceManager, quizzes and maps
+const char* PackedFolders[] = { "audio", "video", "texture", "script", "font", "shader", "map", "text", "quiz" };
+
+//function: EndsWith
+//note: returns true if s ends with end
+bool EndsWith(const std::string& s, const std::string& end)
+{
+	return s.size() >= end.size() && s.compare(s.size() - end.size(), end.size(), end) == 0;
+}
+
+//function: IsDirectory
+//note: returns true if path is a directory
+bool IsDirectory(const std::string& path)
+{
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+//function: AddFolder
+//note: Adds the files in gamepath/folder to files. Like the .db files, only the files directly in the folder are used.
+void AddFolder(const std::string& gamepath, const std::string& folder, std::vector<ResourcePack::File>& files)
+{
+	DIR* dir = opendir((gamepath + folder).c_str());
+	if (!dir) {
+		return;
+	}
+	while (dirent* entry = readdir(dir)) {
+		std::string name = entry->d_name;
+		std::string path = folder + "/" + name;
+		//no hidden files, no db files and no caches: the pack replaces them
+		if (name[0] == '.' || EndsWith(name, ".db") || EndsWith(name, XMLCache::Extension) || EndsWith(name, ".tmp") || IsDirectory(gamepath + path)) {
+			continue;
+		}
+		//old texture caches would only be rejected by the engine
+		if (EndsWith(name, TextureCache::Extension)
+			&& !TextureCache::IsCurrent(gamepath + path.substr(0, path.size() - std::strlen(TextureCache::Extension)), -1)) {
+			continue;
+		}
+		ResourcePack::File file;
+		file.path = path;
+		if (!HoardXML::ReadFile(gamepath + path, file.data)) {
+			std::cerr << "WARNING: cannot read " << gamepath + path << std::endl;
+			continue;
+		}
+		if (EndsWith(name, ".xml")) {
+			//the parsed document, XMLResource uses it instead of parsing the file
+			HoardXML::CompactDocument doc;
+			doc.Load(file.data);
+			ResourcePack::File cooked;
+			cooked.path = path + XMLCache::Extension;
+			cooked.data.assign(doc.GetBufferData(), doc.GetBufferSize());
+			files.push_back(cooked);
+		}
+		files.push_back(file);
+	}
+	closedir(dir);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <gamefolder> [--nocompress]" << std::endl;
+		return 1;
+	}
+	std::string gamepath = std::string(argv[1]) + "/";
+	bool compress = !(argc > 2 && std::string(argv[2]) == "--nocompress");
+
+	DIR* game = opendir(gamepath.c_str());
+	if (!game) {
+		std::cerr << "ERROR: cannot open " << gamepath << std::endl;
+		return 1;
+	}
+	closedir(game);
+	std::vector<ResourcePack::File> files;
+	for (const char* folder : PackedFolders) {
+		AddFolder(gamepath, folder, files);
+	}
+
+	std::size_t bytes = 0;
+	for (auto& f : files) {
+		bytes += f.data.size();
+	}
+	std::size_t count = files.size();
+	std::string packName = gamepath + ResourcePack::FileName;
+	if (!ResourcePack::Write(packName, std::move(files), compress)) {
+		std::cerr << "ERROR: cannot write " << packName << std::endl;
+		return 1;
+	}
+	struct stat info;
+	stat(packName.c_str(), &info);
+	std::cout << "Packed " << count << " files (" << bytes / 1024 << " KB) into " << packName << " (" << info.st_size / 1024 << " KB)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,108 @@
+//File: TextureTool.cpp
+//Info: Cooks the textures of a game: decodes every image in <game>/texture/ and writes its TextureCache next to it (scaled down, RGBA, with mip levels), so the engine does not decode anything.
+//Info: Small images are left alone, they go into the texture atlas. Caches that are up to date are kept.
+//Info: Build and run with "make gamepack" (before the PackTool, which packs the caches). Usage: TextureTool <gamefolder> [maxSize]
+//Info: maxSize has to be the textureMaxSize of the engine settings, otherwise the engine does not use the caches (default 2048).
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "../Classes/MappedFile.h"
+#include "../Classes/RGBASurface.h"
+#include "../Classes/TextureCache.h"
+#include <iostream>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using Dragon2D::MappedFile;
+using Dragon2D::TextureCache;
+
+//const: AtlasImageSize
+//note: images up to this size go into the atlas (TextureAtlas::MaxImageSize)
+const int AtlasImageSize = 256;
+
+//function: EndsWith
+//note: returns true if s ends with end
+bool EndsWith(const std::string& s, const std::string& end)
+{
+	return s.size() >= end.size() && s.compare(s.size() - end.size(), end.size(), end) == 0;
+}
+
+//function: Cook
+//note: writes the cache of one image. Returns false if it can not be decoded.
+bool Cook(const std::string& path, int maxSize)
+{
+	SDL_Surface* surface = IMG_Load(path.c_str());
+	if (!surface) {
+		std::cerr << "WARNING: cannot decode " << path << ": " << IMG_GetError() << std::endl;
+		return false;
+	}
+	if (surface->w <= AtlasImageSize && surface->h <= AtlasImageSize) {
+		SDL_FreeSurface(surface);
+		return true;
+	}
+	SDL_Surface* rgba = Dragon2D::ConvertToRGBA(surface);
+	SDL_FreeSurface(surface);
+	if (!rgba) {
+		std::cerr << "WARNING: cannot convert " << path << ": " << SDL_GetError() << std::endl;
+		return false;
+	}
+	TextureCache::Image image;
+	SDL_LockSurface(rgba);
+	TextureCache::Build(static_cast<const unsigned char*>(rgba->pixels), rgba->w, rgba->h, rgba->pitch, maxSize, image);
+	SDL_UnlockSurface(rgba);
+
+	std::uint64_t size;
+	std::int64_t mtime;
+	MappedFile source(path);
+	bool written = MappedFile::Stat(path, size, mtime) && source.IsOpen()
+		&& TextureCache::Save(path, image, maxSize, size, mtime, MappedFile::Hash(source.GetData(), source.GetSize()));
+	if (written) {
+		std::cout << path << ": " << rgba->w << "x" << rgba->h << " -> " << image.levels[0].width << "x" << image.levels[0].height
+			<< ", " << image.levels.size() << " levels, " << image.GetMemorySize() / 1024 << " KB" << std::endl;
+	}
+	else {
+		std::cerr << "WARNING: cannot write the cache of " << path << std::endl;
+	}
+	SDL_FreeSurface(rgba);
+	return written;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <gamefolder> [maxSize]" << std::endl;
+		return 1;
+	}
+	std::string folder = std::string(argv[1]) + "/texture/";
+	int maxSize = argc > 2 ? std::atoi(argv[2]) : TextureCache::DefaultMaxSize;
+
+	DIR* dir = opendir(folder.c_str());
+	if (!dir) {
+		std::cerr << "ERROR: cannot open " << folder << std::endl;
+		return 1;
+	}
+	IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG | IMG_INIT_TIF);
+	int failed = 0;
+	while (dirent* entry = readdir(dir)) {
+		std::string name = entry->d_name;
+		//no hidden files, no db and no caches
+		if (name[0] == '.' || EndsWith(name, ".db") || EndsWith(name, TextureCache::Extension) || EndsWith(name, ".tmp")) {
+			continue;
+		}
+		std::string path = folder + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0 || S_ISDIR(info.st_mode) || TextureCache::IsCurrent(path, maxSize)) {
+			continue;
+		}
+		if (!Cook(path, maxSize)) {
+			failed++;
+		}
+	}
+	closedir(dir);
+	IMG_Quit();
+	if (failed) {
+		std::cout << failed << " files in " << folder << " could not be cooked" << std::endl;
+	}
+	return 0;
+}